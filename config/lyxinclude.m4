@@ -297,6 +297,16 @@ if test "x$enable_assertions" = xyes ; then
     [Define if you want assertions to be enabled in the code])
 fi
 
+AC_ARG_ENABLE(tracing,
+  AS_HELP_STRING([--disable-tracing],[do not support recording of trace spans (-trace)]),,
+  [enable_tracing=yes]
+)
+if test "x$enable_tracing" = xyes ; then
+   lyx_flags="$lyx_flags tracing"
+   AC_DEFINE(ENABLE_TRACING,1,
+    [Define if you want trace spans to be recorded with -trace])
+fi
+
 # set the compiler options correctly.
 if test x$GXX = xyes; then
   dnl clang++ pretends to be g++ 4.2.1; this is not useful
@@ -247,7 +247,7 @@ AC_DEFUN([QT_DO_PKG_CONFIG],
 	  PKG_CONFIG_PATH=$qt_cv_dir/lib:$qt_cv_dir/lib/pkgconfig:$PKG_CONFIG_PATH
 	  export PKG_CONFIG_PATH
 	fi
-	qt_corelibs="Qt5Core"
+	qt_corelibs="Qt5Core Qt5Concurrent"
 	qt_guilibs="Qt5Core Qt5Concurrent Qt5Gui Qt5Svg Qt5Widgets"
 	lyx_use_x11extras=false
 	PKG_CHECK_EXISTS(Qt5X11Extras, [lyx_use_x11extras=true], [])
@@ -282,7 +282,7 @@ AC_DEFUN([QT_DO_PKG_CONFIG],
 		QT_LDFLAGS=`$PKG_CONFIG --libs-only-L $qt_guilibs`
 		AC_SUBST(QT_INCLUDES)
 		AC_SUBST(QT_LDFLAGS)
-		QTLIB_VERSION=`$PKG_CONFIG --modversion $qt_corelibs`
+		QTLIB_VERSION=`$PKG_CONFIG --modversion Qt5Core`
 		AC_SUBST(QTLIB_VERSION)
 		QT_LIB=`$PKG_CONFIG --libs-only-l $qt_guilibs`
 		AC_SUBST(QT_LIB)
@@ -329,7 +329,7 @@ AC_DEFUN([QT_DO_MANUAL_CONFIG],
 				QT_INCLUDES="$QT_INCLUDES -I$qt_cv_libraries/${i}.framework/Headers"
 			fi
 		done
-		QT_CORE_INCLUDES="-I$qt_cv_includes -I$qt_cv_includes/QtCore"
+		QT_CORE_INCLUDES="-I$qt_cv_includes -I$qt_cv_includes/QtCore -I$qt_cv_includes/QtConcurrent"
 	fi
 	case "$qt_cv_libraries" in
 	"")
@@ -337,7 +337,7 @@ AC_DEFUN([QT_DO_MANUAL_CONFIG],
 	*)
 		if test "$lyx_use_packaging" = "macosx" ; then
 			QT_INCLUDES="$QT_INCLUDES -F$qt_cv_libraries"
-			QT_CORE_INCLUDES="$QT_CORE_INCLUDES -I$qt_cv_libraries/QtCore.framework/Headers -F$qt_cv_libraries"
+			QT_CORE_INCLUDES="$QT_CORE_INCLUDES -I$qt_cv_libraries/QtCore.framework/Headers -I$qt_cv_libraries/QtConcurrent.framework/Headers -F$qt_cv_libraries"
 			QT_LDFLAGS="-F$qt_cv_libraries"
 			QT_CORE_LDFLAGS="-F$qt_cv_libraries"
 		else
@@ -387,6 +387,7 @@ dnl Use first suitable qmake in PATH
 	    lyx_test_qt_mak="$lyx_test_qt_dir/Makefile"
 	    cat > $lyx_test_qt_pro << EOF1
 qtHaveModule(core):		QT += core
+qtHaveModule(concurrent):	QT += concurrent
 percent.target = %
 percent.commands = @echo -n "\$(\$(@))\ "
 QMAKE_EXTRA_TARGETS += percent
@@ -0,0 +1,63 @@
+# This file is part of LyX, the document processor.
+# Licence details can be found in the file COPYING.
+#
+#
+# Export LYXFILE to LaTeX serially and with several threads
+# (preference \latex_export_threads) and check that the results are
+# byte-identical, and that some output of the worker threads was used.
+#
+# Script should be called like:
+# cmake -DWORKDIR=${BUILD_DIR}/autotests/out-home \
+#       -DLYX_TESTS_USERDIR=${LYX_TESTS_USERDIR} \
+#       -DLYX_USERDIR_VER=${LYX_USERDIR_VER} \
+#       -DLYXFILE=xxx \
+#       -Dlyx=xxx \
+#       -Dthreads=4 \
+#       -P "${TOP_SRC_DIR}/development/autotests/parallel_latex.cmake"
+#
+
+get_filename_component(_base ${LYXFILE} NAME_WE)
+set(_serial "${WORKDIR}/${_base}_serial.tex")
+set(_parallel "${WORKDIR}/${_base}_parallel.tex")
+# The user directory of the parallel export only differs in the
+# number of threads in the preferences file
+set(_userdir "${WORKDIR}/parallel_userdir_${_base}")
+
+set(ENV{LANG} "en") # to get all error-messages in english
+set(ENV{${LYX_USERDIR_VER}} "${LYX_TESTS_USERDIR}")
+message(STATUS "Executing ${lyx} -userdir \"${LYX_TESTS_USERDIR}\" -E latex ${_serial} \"${LYXFILE}\"")
+execute_process(
+  COMMAND ${lyx} -userdir "${LYX_TESTS_USERDIR}" -E latex ${_serial} "${LYXFILE}"
+  RESULT_VARIABLE _err)
+if(_err)
+  message(FATAL_ERROR "Serial export of ${LYXFILE} failed")
+endif()
+
+file(REMOVE_RECURSE "${_userdir}")
+file(COPY "${LYX_TESTS_USERDIR}/" DESTINATION "${_userdir}")
+if(NOT EXISTS "${_userdir}/preferences")
+  file(WRITE "${_userdir}/preferences" "\\format 40\n")
+endif()
+# Later entries override earlier ones
+file(APPEND "${_userdir}/preferences" "\\latex_export_threads ${threads}\n")
+set(ENV{${LYX_USERDIR_VER}} "${_userdir}")
+message(STATUS "Executing ${lyx} -userdir \"${_userdir}\" -dbg outfile -E latex ${_parallel} \"${LYXFILE}\"")
+execute_process(
+  COMMAND ${lyx} -userdir "${_userdir}" -dbg outfile -E latex ${_parallel} "${LYXFILE}"
+  RESULT_VARIABLE _err
+  ERROR_VARIABLE _debug)
+if(_err)
+  message(FATAL_ERROR "Parallel export of ${LYXFILE} failed")
+endif()
+# Written by latexParallel() in src/output_latex.cpp for each range of
+# paragraphs that was output by a worker thread
+if(NOT _debug MATCHES "Using parallel output of paragraphs")
+  message(FATAL_ERROR "Export of ${LYXFILE} with ${threads} threads did not use the parallel output")
+endif()
+
+execute_process(
+  COMMAND ${CMAKE_COMMAND} -E compare_files ${_serial} ${_parallel}
+  RESULT_VARIABLE _err)
+if(_err)
+  message(FATAL_ERROR "Parallel LaTeX output ${_parallel} differs from serial output ${_serial}")
+endif()
@@ -0,0 +1,245 @@
+#! /usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# file development/batchtests/benchmark.py
+# This file is part of LyX, the document processor.
+# Licence details can be found in the file COPYING.
+
+# Full author contact details are available in file CREDITS
+
+# This script measures the speed of core operations of LyX. It runs LyX
+# without display (Qt platform "offscreen") on some manuals and on two large
+# documents made by repeating the body of the User Guide and of the math
+# manual. For each document it loads the file, scrolls down some pages and
+# back to the top, exports it to LaTeX, XHTML and DocBook, searches a word
+# that is not found, replaces a frequent word and undoes and redoes the
+# replacement. The metrics of the scrolled pages are part of the "metrics"
+# time, which is dominated by the formulas in the math documents. In a
+# separate run, it exports the document to PDF to measure the parsing of
+# the LaTeX log files (this needs a LaTeX installation and can be skipped
+# with --no-pdf). The times are taken from the trace spans that LyX records
+# with "-trace" (see LYXTRACE in src/support/debug.h), so LyX must not be
+# built with --disable-tracing.
+#
+# The best time of several runs is written as JSON, and can be compared
+# with the results of another build with --compare.
+
+from __future__ import print_function
+
+import argparse, json, os, shutil, subprocess, sys, tempfile, time
+
+documents = ['UserGuide.lyx', 'Math.lyx', 'EmbeddedObjects.lyx']
+
+# Documents that are enlarged to the size given by --size
+large_documents = ['UserGuide.lyx', 'Math.lyx']
+
+# Trace span names for each measured operation, see the LYXTRACE calls
+operations = [('load', 'Buffer::loadLyXFile'),
+              ('updateBuffer', 'Buffer::updateBuffer'),
+              ('metrics', 'BufferView::updateMetrics'),
+              ('latex', 'Buffer::makeLaTeXFile'),
+              ('xhtml', 'Buffer::makeLyXHTMLFile'),
+              ('docbook', 'Buffer::makeDocBookFile'),
+              ('find', 'lyxfind'),
+              ('replace', 'lyxreplace'),
+              ('undo', 'Undo::undoAction'),
+              ('redo', 'Undo::redoAction'),
+              # Only measured by the PDF export
+              ('logscan', 'LaTeX::scanLogFile'),
+              ('deplog', 'LaTeX::deplog')]
+
+def commands(lyxfile):
+    """The LyX functions run on lyxfile"""
+    return ['file-open ' + lyxfile,
+            # Compute the metrics of the first pages, which is where
+            # the formulas of the math documents are measured
+            'repeat 100 screen-down',
+            'buffer-begin',
+            'buffer-export latex',
+            'buffer-export xhtml',
+            'buffer-export docbook5',
+            # Not found, so that the whole document is searched. The
+            # flags are <casesensitive> <matchword> <forward> <wrap>:
+            # with <wrap>, LyX wraps around without asking whether it
+            # should, which nobody could answer here.
+            'word-find lyxbenchmarknotfound\n0 0 1 1',
+            # Replace all occurrences, the arguments are the replacement,
+            # the searched string and the flags <casesensitive>
+            # <matchword> <all> <forward> <findnext> <wrap> <onlysel>
+            'word-replace thee\nthe\n1 1 1 1 1 0 0',
+            'undo',
+            'redo',
+            # Save, so that LyX does not ask on quit
+            'buffer-write',
+            'lyx-quit']
+
+def enlarge(lyxfile, outfile, size):
+    """Write a copy of lyxfile to outfile, with the body repeated until
+       the file has at least size bytes."""
+    f = open(lyxfile, 'rb')
+    content = f.read()
+    f.close()
+    begin = content.index(b'\\begin_body\n') + len(b'\\begin_body\n')
+    end = content.rindex(b'\\end_body')
+    body = content[begin:end]
+    count = max(1, -(-(size - len(content) + len(body)) // len(body)))
+    f = open(outfile, 'wb')
+    f.write(content[:begin])
+    for i in range(count):
+        f.write(body)
+    f.write(content[end:])
+    f.close()
+
+def run_lyx(lyx, userdir, args, timeout):
+    """Run LyX and return its exit code, or None if it did not finish
+       within timeout seconds (e.g. because it waits for an answer to a
+       dialog, which nobody can give with the offscreen platform)."""
+    cmd = [lyx, '-userdir', userdir, '-platform', 'offscreen'] + args
+    proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+    try:
+        proc.communicate(timeout=timeout)
+    except subprocess.TimeoutExpired:
+        proc.kill()
+        proc.communicate()
+        print('LyX did not finish within %d s: %s' % (timeout, ' '.join(cmd)))
+        return None
+    return proc.returncode
+
+def read_trace(tracefile, spent):
+    """Add the time spent in each span of tracefile to spent. Return False
+       if LyX did not write the trace."""
+    if not os.path.exists(tracefile):
+        return False
+    f = open(tracefile, 'r')
+    events = json.load(f)['traceEvents']
+    f.close()
+    for e in events:
+        spent[e['name']] = spent.get(e['name'], 0) + e['dur']
+    return True
+
+def measure(lyx, userdir, lyxfile, tracefile, pdf, timeout):
+    """Run the operations on lyxfile once. Return the time spent in each
+       operation in seconds, or None if LyX did not finish or did not write
+       the trace."""
+    if os.path.exists(tracefile):
+        os.remove(tracefile)
+    if run_lyx(lyx, userdir, ['-trace', tracefile,
+                              '-x', 'command-sequence ' + ';'.join(commands(lyxfile))],
+               timeout) is None:
+        return None
+    spent = {}
+    if not read_trace(tracefile, spent):
+        return None
+    if pdf:
+        # The log files are scanned after each LaTeX run. LaTeX errors
+        # do not matter here, so the exit code is ignored.
+        pdffile = os.path.splitext(lyxfile)[0] + '.pdf'
+        if os.path.exists(tracefile):
+            os.remove(tracefile)
+        if run_lyx(lyx, userdir, ['-trace', tracefile, '-E', 'pdf2', pdffile, lyxfile],
+                   timeout) is None:
+            return None
+        read_trace(tracefile, spent)
+    result = {}
+    for (op, span) in operations:
+        if span in spent:
+            result[op] = spent[span] / 1e6
+    return result
+
+def benchmark(lyx, size, runs, pdf, timeout):
+    docdir = os.path.join(os.path.realpath(os.path.dirname(sys.argv[0])), '..', '..', 'lib', 'doc')
+    workdir = tempfile.mkdtemp(prefix='lyxbench')
+    results = {'lyx': lyx, 'runs': runs, 'documents': {}}
+    try:
+        userdir = os.path.join(workdir, 'userdir')
+        os.mkdir(userdir)
+        # The first start configures LyX
+        if run_lyx(lyx, userdir, ['-batch'], timeout) is None:
+            return None
+        # Images and bibliographies used by the manuals
+        for d in ['clipart', 'biblio']:
+            shutil.copytree(os.path.join(docdir, d), os.path.join(workdir, d))
+        names = list(documents)
+        for name in names:
+            shutil.copyfile(os.path.join(docdir, name), os.path.join(workdir, name))
+        for name in large_documents:
+            large = os.path.splitext(name)[0] + '-large.lyx'
+            enlarge(os.path.join(docdir, name), os.path.join(workdir, large), int(size * 1048576))
+            names.append(large)
+        for name in names:
+            lyxfile = os.path.join(workdir, name)
+            f = open(lyxfile, 'rb')
+            original = f.read()
+            f.close()
+            best = None
+            for i in range(runs):
+                # buffer-write changed the document
+                f = open(lyxfile, 'wb')
+                f.write(original)
+                f.close()
+                spent = measure(lyx, userdir, lyxfile, os.path.join(workdir, 'trace.json'),
+                                pdf, timeout)
+                if spent is None:
+                    print('No results for %s. Did LyX finish, and is it built with tracing?' % name)
+                    return None
+                if best is None:
+                    best = spent
+                else:
+                    for op in spent:
+                        best[op] = min(best.get(op, spent[op]), spent[op])
+            results['documents'][name] = {'size': len(original), 'seconds': best}
+            report(name, len(original), best)
+    finally:
+        shutil.rmtree(workdir, True)
+    return results
+
+def report(name, size, seconds):
+    print('%s (%d bytes)' % (name, size))
+    for (op, span) in operations:
+        if op in seconds:
+            print('  %-14s %10.3f s' % (op, seconds[op]))
+        else:
+            print('  %-14s        n/a' % op)
+
+def compare(old, new):
+    """Print the ratio new/old of the times of each operation"""
+    for name in sorted(new['documents']):
+        if name not in old['documents']:
+            continue
+        print(name)
+        old_seconds = old['documents'][name]['seconds']
+        new_seconds = new['documents'][name]['seconds']
+        for (op, span) in operations:
+            if op in old_seconds and op in new_seconds:
+                ratio = new_seconds[op] / max(old_seconds[op], 1e-6)
+                print('  %-14s %10.3f s %10.3f s %8.2fx' % (op, old_seconds[op], new_seconds[op], ratio))
+
+def main(argv):
+    parser = argparse.ArgumentParser(description='Measure the speed of core operations of LyX.')
+    parser.add_argument('lyx', nargs='?', default='./lyx', help='the LyX binary')
+    parser.add_argument('--size', type=float, default=5, help='size of the large documents in MB')
+    parser.add_argument('--runs', type=int, default=3, help='number of runs, the best time is kept')
+    parser.add_argument('--no-pdf', action='store_true', help='do not export to PDF to measure the log file parsing')
+    parser.add_argument('--timeout', type=int, default=1200, help='maximal time in seconds of one LyX run')
+    parser.add_argument('--output', help='write the results to this JSON file')
+    parser.add_argument('--compare', help='compare the results to this JSON file of another build')
+    args = parser.parse_args(argv[1:])
+
+    lyx = os.path.realpath(args.lyx)
+    results = benchmark(lyx, args.size, args.runs, not args.no_pdf, args.timeout)
+    if results is None:
+        return 1
+    results['date'] = time.strftime('%Y-%m-%d %H:%M:%S')
+    if args.output:
+        f = open(args.output, 'w')
+        json.dump(results, f, indent=2, sort_keys=True)
+        f.close()
+    if args.compare:
+        f = open(args.compare, 'r')
+        old = json.load(f)
+        f.close()
+        compare(old, results)
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
@@ -175,6 +175,10 @@
 #   Add \ui_theme, by koji
 #   No conversion necessary.
 
+# Incremented to format 40
+#   Add \latex_export_threads
+#   No conversion necessary.
+
 # NOTE: The format should also be updated in LYXRC.cpp and
 # in configure.py (search for lyxrc_fileformat).
 
@@ -564,5 +568,6 @@ conversions = [
 	[ 36, [add_spellcheck_default]],
 	[ 37, [remove_fullscreen_widthlimit]],
 	[ 38, []],
-	[ 39, []]
+	[ 39, []],
+	[ 40, []]
 ]
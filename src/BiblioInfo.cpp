@@ -34,9 +34,13 @@
 #include "support/lstrings.h"
 #include "support/textutils.h"
 
+#include <algorithm>
+#include <atomic>
+#include <iterator>
 #include <map>
 #include <regex>
 #include <set>
+#include <tuple>
 
 using namespace std;
 using namespace lyx::support;
@@ -1485,31 +1489,20 @@ void BiblioInfo::mergeBiblioInfo(BiblioInfo const & info)
 	bimap_.insert(info.begin(), info.end());
 	field_names_.insert(info.field_names_.begin(), info.field_names_.end());
 	entry_types_.insert(info.entry_types_.begin(), info.entry_types_.end());
+	cited_data_.clear();
+	changed();
 }
 
 
-namespace {
-
-// used in xhtml to sort a list of BibTeXInfo objects
-bool lSorter(BibTeXInfo const * lhs, BibTeXInfo const * rhs)
+void BiblioInfo::changed()
 {
-	docstring const lauth = lhs->getAuthorOrEditorList();
-	docstring const rauth = rhs->getAuthorOrEditorList();
-	docstring const lyear = lhs->getYear();
-	docstring const ryear = rhs->getYear();
-	docstring const ltitl = lhs->operator[]("title");
-	docstring const rtitl = rhs->operator[]("title");
-	return  (lauth < rauth)
-		|| (lauth == rauth && lyear < ryear)
-		|| (lauth == rauth && lyear == ryear && ltitl < rtitl);
+	static atomic<unsigned long> counter(0);
+	generation_ = ++counter;
 }
 
-} // namespace
-
 
 void BiblioInfo::collectCitedEntries(Buffer const & buf)
 {
-	cited_entries_.clear();
 	// We are going to collect all the citation keys used in the document,
 	// getting them from the TOC.
 	// FIXME We may want to collect these differently, in the first case,
@@ -1522,65 +1515,92 @@ void BiblioInfo::collectCitedEntries(Buffer const & buf)
 		vector<docstring> const keys = getVectorFromString(t.str());
 		citekeys.insert(keys.begin(), keys.end());
 	}
-	if (citekeys.empty())
-		return;
 
-	// We have a set of the keys used in this document.
+	// The entries we already know about keep their place (and their
+	// label). Forget about those that are not cited anymore. What
+	// remains in citekeys afterwards are the new citations.
+	cited_data_.erase(remove_if(cited_data_.begin(), cited_data_.end(),
+		[&citekeys](CitedEntry const & ce) { return citekeys.erase(ce.key) == 0; }),
+		cited_data_.end());
+
+	// We have a set of the new keys used in this document.
 	// We will now convert it to a list of the BibTeXInfo objects used in
 	// this document...
-	vector<BibTeXInfo const *> bi;
+	vector<CitedEntry> added;
 	for (auto const & ck : citekeys) {
 		BiblioInfo::const_iterator const bt = find(ck);
 		if (bt == end() || !bt->second.isBibTeX())
 			continue;
-		bi.push_back(&(bt->second));
+		BibTeXInfo const & bi = bt->second;
+		CitedEntry ce;
+		ce.key = ck;
+		ce.author = bi.getAuthorOrEditorList();
+		ce.year = bi.getYear();
+		ce.title = bi["title"];
+		ce.label_year = getYear(ck);
+		if (!cited_numbers_)
+			ce.label_author = bi.getAuthorOrEditorList(&buf, 128, false);
+		added.push_back(ce);
+	}
+
+	if (!added.empty()) {
+		// ...and sort it. The key is only used to make the order
+		// deterministic.
+		auto const sorter = [](CitedEntry const & lhs, CitedEntry const & rhs) {
+			return tie(lhs.author, lhs.year, lhs.title, lhs.key)
+				< tie(rhs.author, rhs.year, rhs.title, rhs.key);
+		};
+		sort(added.begin(), added.end(), sorter);
+		vector<CitedEntry> merged;
+		merged.reserve(cited_data_.size() + added.size());
+		merge(make_move_iterator(cited_data_.begin()),
+		      make_move_iterator(cited_data_.end()),
+		      make_move_iterator(added.begin()),
+		      make_move_iterator(added.end()),
+		      back_inserter(merged), sorter);
+		cited_data_.swap(merged);
 	}
-	// ...and sort it.
-	sort(bi.begin(), bi.end(), lSorter);
 
 	// Now we can write the sorted keys
-	// b is a BibTeXInfo const *
-	for (auto const & b : bi)
-		cited_entries_.push_back(b->key());
+	cited_entries_.clear();
+	for (auto const & ce : cited_data_)
+		cited_entries_.push_back(ce.key);
 }
 
 
 void BiblioInfo::makeCitationLabels(Buffer const & buf)
 {
-	collectCitedEntries(buf);
 	CiteEngineType const engine_type = buf.params().citeEngineType();
 	bool const numbers = (engine_type & ENGINE_TYPE_NUMERICAL);
+	// Labels depend on the cite engine and its type, on the cite macros
+	// of the document class and on the language of the buffer
+	DocumentClassConstPtr const dclass = buf.params().documentClassPtr();
+	if (engine_type != cited_engine_type_ || dclass != cited_class_
+	    || buf.params().language != cited_language_) {
+		cited_data_.clear();
+		cited_numbers_ = numbers;
+		cited_engine_type_ = engine_type;
+		cited_class_ = dclass;
+		cited_language_ = buf.params().language;
+	}
+	// This keeps the data of entries that were already cited, so that
+	// only the labels of entries whose number or modifier changes
+	// have to be computed again.
+	collectCitedEntries(buf);
 
-	int keynumber = 0;
-	char modifier = 0;
-	// used to remember the last one we saw
-	// we'll be comparing entries to see if we need to add
-	// modifiers, like "1984a"
-	map<docstring, BibTeXInfo>::iterator last = bimap_.end();
-
-	// add letters to years
-	for (auto const & ce : cited_entries_) {
-		map<docstring, BibTeXInfo>::iterator const biit = bimap_.find(ce);
-		// this shouldn't happen, but...
-		if (biit == bimap_.end())
-			// ...fail gracefully, anyway.
-			continue;
-		BibTeXInfo & entry = biit->second;
-		if (numbers) {
-			docstring const num = convert<docstring>(++keynumber);
-			entry.setCiteNumber(num);
-		} else {
-			// The first test here is checking whether this is the first
-			// time through the loop. If so, then we do not have anything
-			// with which to compare.
-			if (last != bimap_.end()
-			    && entry.getAuthorOrEditorList() == last->second.getAuthorOrEditorList()
-			    // we access the year via getYear() so as to get it from the xref,
-			    // if we need to do so
-			    && getYear(entry.key()) == getYear(last->second.key())) {
+	// add numbers or letters to years
+	vector<char> modifiers(cited_data_.size(), 0);
+	if (!numbers) {
+		char modifier = 0;
+		// we'll be comparing entries to the previous one to see if we
+		// need to add modifiers, like "1984a"
+		for (size_t i = 1; i < cited_data_.size(); ++i) {
+			CitedEntry const & ce = cited_data_[i];
+			CitedEntry const & last = cited_data_[i - 1];
+			if (ce.author == last.author && ce.label_year == last.label_year) {
 				if (modifier == 0) {
 					// so the last one should have been 'a'
-					last->second.setModifier('a');
+					modifiers[i - 1] = 'a';
 					modifier = 'b';
 				} else if (modifier == 'z')
 					modifier = 'A';
@@ -1589,31 +1609,45 @@ void BiblioInfo::makeCitationLabels(Buffer const & buf)
 			} else {
 				modifier = 0;
 			}
-			entry.setModifier(modifier);
-			// remember the last one
-			last = biit;
+			modifiers[i] = modifier;
 		}
 	}
-	// Set the labels
-	for (auto const & ce : cited_entries_) {
-		map<docstring, BibTeXInfo>::iterator const biit = bimap_.find(ce);
+
+	int keynumber = 0;
+	for (size_t i = 0; i < cited_data_.size(); ++i) {
+		CitedEntry & ce = cited_data_[i];
+		map<docstring, BibTeXInfo>::iterator const biit = bimap_.find(ce.key);
 		// this shouldn't happen, but...
 		if (biit == bimap_.end())
 			// ...fail gracefully, anyway.
 			continue;
 		BibTeXInfo & entry = biit->second;
+		if (numbers) {
+			docstring const num = convert<docstring>(++keynumber);
+			if (entry.citeNumber() != num) {
+				entry.setCiteNumber(num);
+				ce.dirty = true;
+			}
+		} else if (entry.modifier() != modifiers[i]) {
+			entry.setModifier(modifiers[i]);
+			ce.dirty = true;
+		}
+		if (!ce.dirty)
+			continue;
+		// Set the label
 		if (numbers) {
 			entry.label(entry.citeNumber());
 		} else {
-			docstring const auth = entry.getAuthorOrEditorList(&buf, 128, false);
+			docstring const & auth = ce.label_author;
 			// we do it this way so as to access the xref, if necessary
 			// note that this also gives us the modifier
-			docstring const year = getYear(ce, buf, true);
+			docstring const year = getYear(ce.key, buf, true);
 			if (!auth.empty() && !year.empty())
 				entry.label(auth + ' ' + year);
 			else
 				entry.label(entry.key());
 		}
+		ce.dirty = false;
 	}
 }
 
@@ -15,6 +15,8 @@
 #ifndef BIBLIOINFO_H
 #define BIBLIOINFO_H
 
+#include "DocumentClassPtr.h"
+
 #include "support/docstring.h"
 
 #include <map>
@@ -28,6 +30,7 @@ class Buffer;
 class BufferParams;
 class CitationStyle;
 class CiteItem;
+class Language;
 class XMLStream;
 
 /// \param latex_str a LaTeX command, "cite", "Citep*", etc
@@ -269,7 +272,7 @@ public:
 	///
 	const_iterator begin() const { return bimap_.begin(); }
 	///
-	void clear() { bimap_.clear(); }
+	void clear() { bimap_.clear(); cited_data_.clear(); changed(); }
 	///
 	bool empty() const { return bimap_.empty(); }
 	///
@@ -278,13 +281,21 @@ public:
 	const_iterator find(docstring const & f) const { return bimap_.find(f); }
 	///
 	void mergeBiblioInfo(BiblioInfo const & info);
-	///
-	BibTeXInfo & operator[](docstring const & f) { return bimap_[f]; }
+	/// Since the entry may be modified, the citation labels will
+	/// be computed from scratch next time.
+	BibTeXInfo & operator[](docstring const & f)
+		{ cited_data_.clear(); changed(); return bimap_[f]; }
 	///
 	void addFieldName(docstring const & f) { field_names_.insert(f); }
 	///
 	void addEntryType(docstring const & f) { entry_types_.insert(f); }
+	/// Changes whenever entries are added or may have been modified.
+	/// The same value is never used by two different BiblioInfo
+	/// contents, so it can be used to cache data derived from them.
+	unsigned long generation() const { return generation_; }
 private:
+	/// Assign a new generation
+	void changed();
 	/// Collects the cited entries from buf.
 	void collectCitedEntries(Buffer const & buf);
 	///
@@ -297,6 +308,39 @@ private:
 	/// do not try to make this a vector<BibTeXInfo *> or anything of
 	/// the sort, because reloads will invalidate those pointers.
 	std::vector<docstring> cited_entries_;
+	/// What we know about an entry of cited_entries_, so that the
+	/// citation labels can be updated incrementally.
+	struct CitedEntry {
+		///
+		docstring key;
+		/// The sorting criteria
+		docstring author;
+		///
+		docstring year;
+		///
+		docstring title;
+		/// The year, possibly from the crossref, used to find
+		/// entries that need a modifier.
+		docstring label_year;
+		/// The author list as it appears in the label
+		docstring label_author;
+		/// Whether the label has to be recomputed
+		bool dirty = true;
+	};
+	/// The entries of cited_entries_, in the same order
+	std::vector<CitedEntry> cited_data_;
+	/// The context in which cited_data_ has been computed. The
+	/// document class carries the cite engine, its cite macros and
+	/// max_citenames.
+	bool cited_numbers_ = false;
+	///
+	int cited_engine_type_ = 0;
+	///
+	DocumentClassConstPtr cited_class_;
+	///
+	Language const * cited_language_ = nullptr;
+	///
+	unsigned long generation_ = 0;
 };
 
 } // namespace lyx
@@ -104,7 +104,11 @@
 #include "support/TempFile.h"
 #include "support/types.h"
 
+#include <QFuture>
+#include <QtConcurrentRun>
+
 #include <algorithm>
+#include <ctime>
 #include <fstream>
 #include <iomanip>
 #include <map>
@@ -258,6 +262,31 @@ public:
 	int id_ = 0;
 	/// The buffer id at last updateMacros invokation
 	int update_macros_id_ = -1;
+	/// This is increased every time this very buffer is marked dirty
+	/// (contrary to id_, changes in relatives do not count)
+	int content_id_ = 0;
+
+	/// The body of this buffer, as written to a given file by the last
+	/// export as a child. See Buffer::reuseChildLaTeXFile().
+	struct ChildLaTeXFile {
+		/// the contents and parameters the file was written with
+		string key;
+		///
+		unsigned long checksum = 0;
+		///
+		TexRow texrow;
+		/// the external files registered while writing the file
+		ExportData exportdata;
+	};
+	/// This is only filled in the original buffer, also when exporting
+	/// a clone. Since exports happen in a separate thread, access is
+	/// protected by child_latex_mutex_.
+	map<FileName, ChildLaTeXFile> child_latex_files_;
+	///
+	Mutex child_latex_mutex_;
+	/// Contents and parameters that influence the body of the buffer
+	/// when exported as a child with \p runparams.
+	string childLaTeXKey(OutputParams const & runparams) const;
 
 	/// A cache for the bibfiles (including bibfiles of loaded child
 	/// documents), needed for appropriate update of natbib labels.
@@ -408,6 +437,9 @@ public:
 	// Make sure the file monitor monitors the good file.
 	void refreshFileMonitor();
 
+	/// The file status known by the file monitor
+	FileStatus const & fileStatus() const { return file_monitor_->status(); }
+
 	/// Notify or clear of external modification
 	void fileExternallyModified(bool exists);
 
@@ -474,6 +506,7 @@ Buffer::Impl::Impl(Buffer * owner, FileName const & file, bool readonly_,
 	}
 	temppath = cloned_buffer_->d->temppath;
 	file_fully_loaded = true;
+	content_id_ = cloned_buffer_->d->content_id_;
 	params = cloned_buffer_->d->params;
 	bibfiles_cache_ = cloned_buffer_->d->bibfiles_cache_;
 	bibinfo_ = cloned_buffer_->d->bibinfo_;
@@ -821,6 +854,7 @@ int Buffer::id() const
 
 void Buffer::updateId()
 {
+	++d->content_id_;
 	for(Buffer * b : allRelatives())
 		++(b->d->id_);
 }
@@ -924,6 +958,8 @@ void Buffer::setFileName(FileName const & fname)
 {
 	bool const changed = fname != d->filename;
 	d->filename = fname;
+	if (changed && !isClone())
+		theBufferList().fileNameChanged(this);
 	d->refreshFileMonitor();
 	if (changed)
 		lyxvc().file_found_hook(fname);
@@ -1122,8 +1158,14 @@ bool Buffer::readDocument(Lexer & lex)
 	if (!parent())
 		clearIncludeList();
 
+	DocumentClassConstPtr const docclass = params().documentClassPtr();
 	bool const res = text().read(lex, errorList, d->inset);
 	d->old_position.clear();
+	// Unknown layouts have been added to a copy of a shared class (see
+	// Text::readParToken()), the paragraphs before still refer to the
+	// shared one.
+	if (params().documentClassPtr() != docclass && !paragraphs().empty())
+		cap::switchBetweenClasses(docclass, params().documentClassPtr(), *d->inset);
 
 	// inform parent buffer about local macros
 	if (parent()) {
@@ -1231,9 +1273,278 @@ bool Buffer::readString(string const & s)
 }
 
 
+namespace {
+
+/// The part of the loading of a child document that was done in advance
+struct PrefetchedChild {
+	/// The modification time of the file when it was read
+	time_t timestamp = 0;
+	/// The file converted to the current format by lyx2lyx. This is
+	/// empty if no conversion was needed or if it failed.
+	FileName converted;
+};
+
+
+/** Prefetches the child documents of a document that is being loaded.
+    The include insets load their child documents as soon as they are
+    read, so the children are loaded one after the other. The
+    prefetcher looks for the includes in the text of the file in a
+    worker thread, reads the children in other workers, runs lyx2lyx on
+    those in another format, and continues with their own children.
+    The Buffers themselves are still created and read in the main
+    thread, since this registers them in the buffer list and uses the
+    text classes, the macros and the dialogs, which are not thread
+    safe.
+ */
+class ChildPrefetcher {
+public:
+	/// The prefetched children that were not loaded are discarded
+	/// when the outermost scope ends.
+	class Scope {
+	public:
+		///
+		Scope();
+		///
+		~Scope();
+	};
+	/// Look in a worker thread for the LyX children of \p fn, which
+	/// is in the current format, and start prefetching them.
+	/// The file names are relative to \p dir.
+	void start(FileName const & fn, string const & dir);
+	/// Wait until \p fn is prefetched and take over the result.
+	/// \return false if \p fn was not prefetched or changed meanwhile.
+	bool take(FileName const & fn, PrefetchedChild & result);
+private:
+	///
+	struct Job {
+		///
+		QFuture<PrefetchedChild> future;
+		///
+		bool scheduled = false;
+		/// Did the main thread already ask for it?
+		bool taken = false;
+	};
+	/// Start prefetching \p fn unless this was already done
+	void schedule(FileName const & fn);
+	/// Schedule the LyX children included by \p fn.
+	/// \return the format of \p fn, or -1 if it is not a LyX file.
+	/// The includes are not looked for if the format is not current.
+	int scan(FileName const & fn, string const & dir);
+	/// Prefetch \p fn and its children. Runs in a worker thread.
+	PrefetchedChild prefetch(FileName const & fn);
+	/// Wait for all jobs and discard the results that were not taken
+	void clear();
+	///
+	int depth_ = 0;
+	/// The lyx2lyx command without the file names
+	string lyx2lyx_;
+	///
+	Mutex mutex_;
+	/// The jobs by absolute file name
+	map<string, Job> jobs_;
+};
+
+
+ChildPrefetcher & prefetcher()
+{
+	static ChildPrefetcher instance;
+	return instance;
+}
+
+
+ChildPrefetcher::Scope::Scope()
+{
+	ChildPrefetcher & p = prefetcher();
+	if (p.depth_++ > 0)
+		return;
+	// No workers are running now, so this can be set safely
+	FileName const lyx2lyx = libFileSearch("lyx2lyx", "lyx2lyx");
+	if (lyx2lyx.empty())
+		p.lyx2lyx_.clear();
+	else
+		p.lyx2lyx_ = os::python() + ' '
+			+ quoteName(lyx2lyx.toFilesystemEncoding())
+			+ " -t " + convert<string>(LYX_FORMAT);
+}
+
+
+ChildPrefetcher::Scope::~Scope()
+{
+	ChildPrefetcher & p = prefetcher();
+	if (--p.depth_ == 0)
+		p.clear();
+}
+
+
+void ChildPrefetcher::start(FileName const & fn, string const & dir)
+{
+	Mutex::Locker lock(&mutex_);
+	Job & job = jobs_[fn.absFileName()];
+	if (job.scheduled || job.taken)
+		return;
+	// The result is not needed, only the scan
+	job.scheduled = true;
+	job.taken = true;
+	job.future = QtConcurrent::run([this, fn, dir]() {
+		scan(fn, dir);
+		return PrefetchedChild();
+	});
+}
+
+
+bool ChildPrefetcher::take(FileName const & fn, PrefetchedChild & result)
+{
+	QFuture<PrefetchedChild> future;
+	{
+		Mutex::Locker lock(&mutex_);
+		Job & job = jobs_[fn.absFileName()];
+		if (job.taken)
+			return false;
+		// If it was not scheduled yet, it will not be anymore
+		job.taken = true;
+		if (!job.scheduled)
+			return false;
+		future = job.future;
+	}
+	result = future.result();
+	if (result.timestamp != fn.lastModified()) {
+		if (!result.converted.empty())
+			result.converted.removeFile();
+		result = PrefetchedChild();
+		return false;
+	}
+	LYXERR(Debug::FILES, "Using prefetched " << fn
+		<< (result.converted.empty() ? "" : " converted to ")
+		<< result.converted);
+	return true;
+}
+
+
+void ChildPrefetcher::schedule(FileName const & fn)
+{
+	Mutex::Locker lock(&mutex_);
+	Job & job = jobs_[fn.absFileName()];
+	if (job.scheduled || job.taken)
+		return;
+	job.scheduled = true;
+	job.future = QtConcurrent::run([this, fn]() {
+		return prefetch(fn);
+	});
+}
+
+
+int ChildPrefetcher::scan(FileName const & fn, string const & dir)
+{
+	gz::igzstream is(fn.toSafeFilesystemEncoding().c_str());
+	int format = -1;
+	bool in_include = false;
+	bool lyx_include = false;
+	string line;
+	while (getline(is, line)) {
+		if (format < 0) {
+			if (!prefixIs(line, "\\lyxformat "))
+				continue;
+			// LyX formats 217 and earlier were written as 2.17,
+			// see parseLyXFormat()
+			string const tmp = subst(subst(trim(line.substr(11)),
+			                               ".", ""), ",", "");
+			if (!isStrInt(tmp))
+				return -1;
+			format = convert<int>(tmp);
+			// Older formats write the includes differently
+			if (format != LYX_FORMAT)
+				return format;
+		} else if (line == "\\begin_inset CommandInset include") {
+			in_include = true;
+			lyx_include = false;
+		} else if (!in_include) {
+			continue;
+		} else if (line == "\\end_inset") {
+			in_include = false;
+		} else if (line == "LatexCommand include"
+		           || line == "LatexCommand input") {
+			lyx_include = true;
+		} else if (lyx_include && prefixIs(line, "filename \"")
+		           && suffixIs(line, '"') && line.size() > 11) {
+			// Undo Lexer::quoteString()
+			string const name = subst(subst(
+				line.substr(10, line.size() - 11),
+				"\\\"", "\""), "\\\\", "\\");
+			FileName const child = makeAbsPath(ltrim(name), dir);
+			if (isLyXFileName(child.absFileName()) && child.exists())
+				schedule(child);
+		}
+	}
+	return format;
+}
+
+
+PrefetchedChild ChildPrefetcher::prefetch(FileName const & fn)
+{
+	PrefetchedChild result;
+	result.timestamp = fn.lastModified();
+	string const dir = onlyPath(fn.absFileName());
+	int const format = scan(fn, dir);
+	if (format < 0 || format == LYX_FORMAT || lyx2lyx_.empty())
+		return result;
+
+	// See convertLyXFormat()
+	TempFile tempfile("Buffer_convertLyXFormatXXXXXX.lyx");
+	tempfile.setAutoRemove(false);
+	FileName const tmpfile = tempfile.name();
+	if (tmpfile.empty())
+		return result;
+	string const command = lyx2lyx_
+		+ " -o " + quoteName(tmpfile.toSafeFilesystemEncoding())
+		+ ' ' + quoteName(fn.toSafeFilesystemEncoding());
+	if (!runCommand(command).valid) {
+		// The main thread runs it again and reports the error
+		tmpfile.removeFile();
+		return result;
+	}
+	scan(tmpfile, dir);
+	result.converted = tmpfile;
+	return result;
+}
+
+
+void ChildPrefetcher::clear()
+{
+	// The workers may schedule more jobs while we wait
+	size_t waited = 0;
+	while (true) {
+		vector<QFuture<PrefetchedChild>> futures;
+		{
+			Mutex::Locker lock(&mutex_);
+			if (jobs_.size() == waited)
+				break;
+			for (auto const & job : jobs_)
+				if (job.second.scheduled)
+					futures.push_back(job.second.future);
+			waited = jobs_.size();
+		}
+		for (auto & future : futures)
+			future.waitForFinished();
+	}
+
+	Mutex::Locker lock(&mutex_);
+	for (auto const & job : jobs_) {
+		if (!job.second.scheduled || job.second.taken)
+			continue;
+		FileName const converted = job.second.future.result().converted;
+		if (!converted.empty())
+			converted.removeFile();
+	}
+	jobs_.clear();
+}
+
+} // namespace
+
+
 Buffer::ReadStatus Buffer::readFile(FileName const & fn,
 				    string const ofn)
 {
+	ChildPrefetcher::Scope const prefetch_scope;
 	Lexer lex;
 	if (!lex.setFile(fn)) {
 		Alert::error(_("File Not Found"),
@@ -1247,12 +1558,22 @@ Buffer::ReadStatus Buffer::readFile(FileName const & fn,
 	if (ret_plf != ReadSuccess)
 		return ret_plf;
 
+	// If this is a child that was prefetched, its children are already
+	// being prefetched as well. Otherwise, start with them now.
+	string const dir = onlyPath(fn.absFileName());
+	PrefetchedChild prefetched;
+	bool const was_prefetched = ofn.empty()
+		&& prefetcher().take(fn, prefetched);
+
 	if (file_format != LYX_FORMAT) {
-		FileName tmpFile;
-		ReadStatus ret_clf = convertLyXFormat(fn, tmpFile, file_format);
-		if (ret_clf != ReadSuccess)
-			return ret_clf;
-		ret_clf = readFile(tmpFile, fn.absFileName());
+		FileName tmpFile = prefetched.converted;
+		if (tmpFile.empty()) {
+			ReadStatus const ret = convertLyXFormat(fn, tmpFile, file_format);
+			if (ret != ReadSuccess)
+				return ret;
+			prefetcher().start(tmpFile, dir);
+		}
+		ReadStatus const ret_clf = readFile(tmpFile, fn.absFileName());
 		if (ret_clf == ReadSuccess) {
 			d->file_format = file_format;
 			d->need_format_backup = true;
@@ -1260,6 +1581,9 @@ Buffer::ReadStatus Buffer::readFile(FileName const & fn,
 		return ret_clf;
 	}
 
+	if (ofn.empty() && !was_prefetched)
+		prefetcher().start(fn, dir);
+
 	// FIXME: InsetInfo needs to know whether the file is under VCS
 	// during the parse process, so this has to be done before.
 	lyxvc().file_found_hook(d->filename);
@@ -1793,6 +2117,7 @@ Buffer::ExportStatus Buffer::makeLaTeXFile(FileName const & fname,
 			   OutputParams const & runparams_in,
 			   OutputWhat output) const
 {
+	LYXTRACE("Buffer::makeLaTeXFile");
 	OutputParams runparams = runparams_in;
 
 	string const encoding = runparams.encoding->iconvName();
@@ -1885,6 +2210,117 @@ Buffer::ExportStatus Buffer::makeLaTeXFile(FileName const & fname,
 }
 
 
+namespace {
+
+/// Whether the LaTeX output of \p buf depends on the contents of files
+/// that are not LyX documents, or has side effects on the temp dir (like
+/// copying and converting graphics). Such output cannot be reused, since
+/// the key of Buffer::Impl::childLaTeXKey() does not cover these files.
+bool hasExternalLaTeXDependencies(Buffer const & buf)
+{
+	Inset & inset = buf.inset();
+	InsetIterator const i_end = end(inset);
+	for (InsetIterator it = begin(inset); it != i_end; ++it) {
+		switch (it->lyxCode()) {
+		case BIBTEX_CODE:
+		case EXTERNAL_CODE:
+		case GRAPHICS_CODE:
+			return true;
+		case INCLUDE_CODE: {
+			// Included LyX documents are checked as descendants
+			InsetCommand const & ic = static_cast<InsetCommand const &>(*it);
+			if (!isLyXFileName(to_utf8(ic.getParam("filename"))))
+				return true;
+			break;
+		}
+		default:
+			break;
+		}
+	}
+	return false;
+}
+
+} // namespace
+
+
+string Buffer::Impl::childLaTeXKey(OutputParams const & rp) const
+{
+	ostringstream os;
+	// The contents of the buffer and of the buffers it includes
+	os << content_id_;
+	for (Buffer const * b : owner_->getDescendants())
+		os << ' ' << b->d->content_id_;
+	// The contents and parameters of the master. We consider the master
+	// contents in order to be on the safe side with respect to things
+	// like macros defined in the master. This does not hurt much, since
+	// in large projects the master mostly consists of includes.
+	Buffer const * const master = owner_->masterBuffer();
+	os << '\n' << master->d->content_id_ << '\n';
+	master->params().writeFile(os, master);
+	// The relevant output parameters, that are mostly set by the master
+	os << '\n' << int(rp.flavor) << ' ' << int(rp.math_flavor)
+	   << ' ' << rp.nice << ' ' << rp.for_preview << ' ' << rp.includeall
+	   << ' ' << rp.use_babel << rp.use_polyglossia << rp.use_hyperref
+	   << rp.use_CJK << rp.use_indices << rp.use_memindex << rp.use_japanese
+	   << ' ' << (rp.encoding ? rp.encoding->name() : string())
+	   << ' ' << (rp.master_language ? rp.master_language->lang() : string())
+	   << ' ' << (rp.local_font ? rp.local_font->language()->lang() : string())
+	   << ' ' << rp.document_language << ' ' << rp.main_fontenc
+	   << ' ' << rp.active_chars << ' ' << rp.bibtex_command
+	   << ' ' << rp.index_command << ' ' << rp.hyperref_driver
+	   << ' ' << rp.export_folder;
+	return os.str();
+}
+
+
+bool Buffer::reuseChildLaTeXFile(FileName const & fname,
+				 OutputParams const & runparams) const
+{
+	if (hasExternalLaTeXDependencies(*this))
+		return false;
+	for (Buffer const * b : getDescendants())
+		if (hasExternalLaTeXDependencies(*b))
+			return false;
+
+	Impl * const orig = isClone() ? d->cloned_buffer_->d : d;
+	string const key = d->childLaTeXKey(runparams);
+
+	Mutex::Locker locker(&orig->child_latex_mutex_);
+	auto const it = orig->child_latex_files_.find(fname);
+	if (it == orig->child_latex_files_.end() || it->second.key != key)
+		return false;
+	// Make sure that the file has not been overwritten meanwhile
+	// (e.g. by BufferList::updateIncludedTeXfiles)
+	fname.refresh();
+	if (fname.checksum() != it->second.checksum)
+		return false;
+
+	LYXERR(Debug::OUTFILE, "Reusing child LaTeX file " << fname);
+	d->texrow = it->second.texrow;
+	if (runparams.exportdata)
+		runparams.exportdata->addExternalFiles(it->second.exportdata);
+	return true;
+}
+
+
+void Buffer::cacheChildLaTeXFile(FileName const & fname,
+				 OutputParams const & runparams) const
+{
+	Impl * const orig = isClone() ? d->cloned_buffer_->d : d;
+	string const key = d->childLaTeXKey(runparams);
+	fname.refresh();
+	unsigned long const checksum = fname.checksum();
+
+	Mutex::Locker locker(&orig->child_latex_mutex_);
+	Impl::ChildLaTeXFile & entry = orig->child_latex_files_[fname];
+	entry.key = key;
+	entry.checksum = checksum;
+	entry.texrow = d->texrow;
+	entry.exportdata = runparams.exportdata ? *runparams.exportdata
+	                                        : ExportData();
+}
+
+
 Buffer::ExportStatus Buffer::writeLaTeXSource(otexstream & os,
 			   string const & original_path,
 			   OutputParams const & runparams_in,
@@ -2155,9 +2591,10 @@ Buffer::ExportStatus Buffer::makeDocBookFile(FileName const & fname,
 			      OutputParams const & runparams,
 			      OutputWhat output) const
 {
+	LYXTRACE("Buffer::makeDocBookFile");
 	LYXERR(Debug::OUTFILE, "makeDocBookFile...");
 
-	ofdocstream ofs;
+	utf8_ofdocstream ofs;
 	if (!openFileWrite(ofs, fname))
 		return ExportError;
 
@@ -2251,9 +2688,10 @@ Buffer::ExportStatus Buffer::writeDocBookSource(odocstream & os,
 Buffer::ExportStatus Buffer::makeLyXHTMLFile(FileName const & fname,
 			      OutputParams const & runparams) const
 {
+	LYXTRACE("Buffer::makeLyXHTMLFile");
 	LYXERR(Debug::OUTFILE, "makeLyXHTMLFile...");
 
-	ofdocstream ofs;
+	utf8_ofdocstream ofs;
 	if (!openFileWrite(ofs, fname))
 		return ExportError;
 
@@ -2340,7 +2778,7 @@ Buffer::ExportStatus Buffer::writeLyXHTMLSource(odocstream & os,
 			bool written = false;
 			if (params().html_css_as_file) {
 				// open a file for CSS info
-				ofdocstream ocss;
+				utf8_ofdocstream ocss;
 				string const fcssname = addName(temppath(), "docstyle.css");
 				FileName const fcssfile = FileName(fcssname);
 				if (openFileWrite(ocss, fcssfile)) {
@@ -4542,6 +4980,7 @@ void Buffer::setMathFlavor(OutputParams & op) const
 Buffer::ExportStatus Buffer::doExport(string const & target, bool put_in_tempdir,
 	bool includeall, string & result_file) const
 {
+	LYXTRACE("Buffer::doExport");
 	if (removeBiblioTemps)
 		removeBiblioTempFiles();
 	LYXERR(Debug::FILES, "target=" << target);
@@ -5004,6 +5443,7 @@ Buffer::ReadStatus Buffer::loadAutosave()
 
 Buffer::ReadStatus Buffer::loadLyXFile()
 {
+	LYXTRACE("Buffer::loadLyXFile");
 	if (!d->filename.isReadableFile()) {
 		ReadStatus const ret_rvc = extractFromVC();
 		if (ret_rvc != ReadSuccess)
@@ -5088,6 +5528,7 @@ void Buffer::updateBuffer() const
 
 void Buffer::updateBuffer(UpdateScope scope, UpdateType utype) const
 {
+	LYXTRACE("Buffer::updateBuffer");
 	LBUFERR(!text().paragraphs().empty());
 
 	// This can be called when loading a file, so that there be no
@@ -5584,6 +6025,8 @@ Buffer::ReadStatus Buffer::reload()
 		if (!d->parent() && oldparent && oldparent->isFullyLoaded()
 		    && oldparent->isChild(this))
 			d->setParent(oldparent);
+		// the contents have changed
+		updateId();
 		markClean();
 		message(bformat(_("Document %1$s reloaded."), disp_fn));
 		d->undo_.clear();
@@ -5721,6 +6164,8 @@ void Buffer::Impl::refreshFileMonitor()
 	// The previous file monitor is invalid
 	// This also destroys the previous file monitor and all its connections
 	file_monitor_ = FileSystemWatcher::monitor(filename);
+	// The checksum is compared to ours in fileExternallyModified()
+	file_monitor_->needChecksum();
 	// file_monitor_ will be destroyed with *this, so it is not going to call a
 	// destroyed object method.
 	file_monitor_->connect([this](bool exists) {
@@ -5731,8 +6176,11 @@ void Buffer::Impl::refreshFileMonitor()
 
 void Buffer::Impl::fileExternallyModified(bool const exists)
 {
+	// The status has been queried in a worker thread, we must not access
+	// the file system here since it might be slow.
+	FileStatus const & status = fileStatus();
 	// ignore notifications after our own saving operations
-	if (checksum_ == filename.checksum()) {
+	if (checksum_ == status.checksum) {
 		LYXERR(Debug::FILES, "External modification but "
 		       "checksum unchanged: " << filename);
 		return;
@@ -5747,16 +6195,11 @@ void Buffer::Impl::fileExternallyModified(bool const exists)
 	if (wa_ && wa_->unhide(owner_)) {
 		wa_->updateTitles();
 
+		// A file overwrite often causes short-term removal (see #12819),
+		// but the deletion has been double checked with a delay by
+		// FileStatus::query().
 		if (exists)
 			return;
-		//Essentially the same problem as in FileMonitorGuard::refresh.
-		//'exists' is not reliable marker of file removal here, e.g.
-		//file overwrite often causes short-term removal, see #12819.
-		std::this_thread::sleep_for(200ms);
-		FileName refreshf (filename.absFileName());
-		//Only double check with delay will trigger warning
-		if(refreshf.exists())
-			return;
 
 		lyx_clean = false;
 		wa_->updateTitles();
@@ -5773,6 +6216,12 @@ void Buffer::Impl::fileExternallyModified(bool const exists)
 }
 
 
+FileStatus const & Buffer::fileStatus() const
+{
+	return d->fileStatus();
+}
+
+
 bool Buffer::notifiesExternalModification() const
 {
 	return d->externally_modified_;
@@ -34,6 +34,7 @@ class DispatchResult;
 class DocIterator;
 class docstring_list;
 class ErrorList;
+class ExportData;
 class FuncRequest;
 class FuncStatus;
 class Inset;
@@ -66,6 +67,7 @@ namespace support {
 class DocFileName;
 class FileName;
 class FileNameList;
+struct FileStatus;
 class Lexer;
 } // namespace support
 
@@ -312,6 +314,22 @@ public:
 			   std::string const & original_path,
 			   OutputParams const &,
 			   OutputWhat output = FullSource) const;
+	/** When this buffer is exported as a child, check whether the body
+	    written to \p filename by an earlier export can be reused. This
+	    is the case if neither this buffer, its descendants nor its
+	    master have changed since then, and if the master parameters and
+	    \p runparams are the same, and if the buffer and its descendants
+	    contain no insets whose output depends on other files (graphics,
+	    external material, bibliographies, included non-LyX files). If
+	    so, the TexRow of that export is restored and the external files
+	    it registered are added to the exportdata of \p runparams.
+	 */
+	bool reuseChildLaTeXFile(support::FileName const & filename,
+			   OutputParams const & runparams) const;
+	/// Remember that \p filename has just been written by makeLaTeXFile()
+	/// with \p runparams, see reuseChildLaTeXFile().
+	void cacheChildLaTeXFile(support::FileName const & filename,
+			   OutputParams const & runparams) const;
 	/** Export the buffer to LaTeX.
 	    If \p os is a file stream, and params().inputenc is "auto-legacy" or
 	    "auto-legacy-plain", and the buffer contains text in different languages
@@ -374,6 +392,9 @@ public:
 	/// Fast but (not so) inaccurate, can be cleared by the user.
 	bool notifiesExternalModification() const;
 	void clearExternalModification() const;
+	/// The status of the disk file, as of the last notification of the
+	/// FileSystemWatcher. This does not access the file system.
+	support::FileStatus const & fileStatus() const;
 
 	/// mark the main lyx file as not needing saving
 	void markClean() const;
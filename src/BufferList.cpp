@@ -25,10 +25,12 @@
 #include "support/FileNameList.h"
 #include "support/filetools.h"
 #include "support/lstrings.h"
+#include "support/os.h"
 
 #include "support/lassert.h"
 
 #include <algorithm>
+#include <chrono>
 #include <cstdlib> // exit()
 #include <iterator>
 #include <memory>
@@ -40,6 +42,33 @@ namespace lyx {
 
 namespace Alert = lyx::frontend::Alert;
 
+namespace {
+
+/// The string under which the file \p name is found in the lookup
+/// tables. Like operator==(FileName, FileName), this ignores the case
+/// if the file system does.
+string nameKey(string const & name)
+{
+	if (os::isFilesystemCaseSensitive())
+		return name;
+	return to_utf8(lowercase(from_utf8(name)));
+}
+
+
+template<typename Map>
+Buffer * lookup(Map const & map, string const & key)
+{
+	typename Map::const_iterator const it = map.find(key);
+	return it == map.end() ? nullptr : it->second;
+}
+
+
+/// The lookup statistics are output with Debug::FILES after this many
+/// lookups
+unsigned int const lookup_report_interval = 256;
+
+} // namespace
+
 
 BufferList::BufferList()
 {}
@@ -94,6 +123,7 @@ void BufferList::release(Buffer * buf)
 		Buffer * tmp = (*it);
 		bstore.erase(it);
 		LASSERT(tmp, return);
+		removeFromIndex(bindex, bstore, tmp);
 		delete tmp;
 		if (parent)
 			// If this was a child, update the parent's buffer
@@ -109,6 +139,7 @@ Buffer * BufferList::newInternalBuffer(string const & s)
 	if (buf) {
 		buf->setInternal(true);
 		binternal.push_back(buf);
+		addToIndex(binternal_index, buf);
 	}
 	return buf;
 }
@@ -120,6 +151,7 @@ Buffer * BufferList::newBuffer(string const & s)
 	if (buf) {
 		LYXERR(Debug::INFO, "Assigning to buffer " << bstore.size());
 		bstore.push_back(buf);
+		addToIndex(bindex, buf);
 	}
 	return buf;
 }
@@ -254,21 +286,13 @@ bool BufferList::exists(FileName const & fname) const
 
 bool BufferList::isLoaded(Buffer const * b) const
 {
-	if (!b)
-		return false;
-	BufferStorage::const_iterator cit =
-		find(bstore.begin(), bstore.end(), b);
-	return cit != bstore.end();
+	return b && bindex.keys.find(b) != bindex.keys.end();
 }
 
 
 bool BufferList::isInternal(Buffer const * b) const
 {
-	if (!b)
-		return false;
-	BufferStorage::const_iterator cit =
-		find(binternal.begin(), binternal.end(), b);
-	return cit != binternal.end();
+	return b && binternal_index.keys.find(b) != binternal_index.keys.end();
 }
 
 
@@ -292,48 +316,150 @@ bool BufferList::isOthersChild(Buffer * parent, Buffer * child) const
 
 Buffer * BufferList::getBuffer(support::FileName const & fname, bool internal) const
 {
+	bool const timed = lyxerr.debugging(Debug::FILES);
+	chrono::steady_clock::time_point const start = timed
+		? chrono::steady_clock::now() : chrono::steady_clock::time_point();
 	// 1) cheap test, using string comparison of file names
-	for (Buffer * b : bstore)
-		if (b->fileName() == fname)
-			return b;
-	// 2) possibly expensive test, using equivalence test of file names
-	for (Buffer * b : bstore)
-		if (equivalent(b->fileName(), fname))
-			return b;
-	if (internal) {
-		// 1) cheap test, using string comparison of file names
-		for (Buffer * b : binternal)
-			if (b->fileName() == fname)
-				return b;
-		// 2) possibly expensive test, using equivalence test of file names
-		for (Buffer * b : binternal)
-			if (equivalent(b->fileName(), fname))
-				return b;
+	string const name = nameKey(fname.absFileName());
+	Buffer * b = lookup(bindex.names, name);
+	// 2) possibly expensive test, resolving the links
+	string real_name;
+	if (!b) {
+		real_name = nameKey(fname.realPath());
+		b = lookup(bindex.real_names, real_name);
+	}
+	if (!b && internal) {
+		b = lookup(binternal_index.names, name);
+		if (!b)
+			b = lookup(binternal_index.real_names, real_name);
 	}
-	return nullptr;
+	if (timed)
+		recordLookup(chrono::duration<double>(
+			chrono::steady_clock::now() - start).count(), b);
+	return b;
 }
 
 
 Buffer * BufferList::getBufferFromTmp(string const & path, bool realpath)
 {
-	for (Buffer * buf : bstore) {
-		string const temppath = realpath ? FileName(buf->temppath()).realPath() : buf->temppath();
-		if (prefixIs(path, temppath)) {
-			// check whether the filename matches the master
-			string const master_name = buf->latexName();
-			if (suffixIs(path, master_name))
-				return buf;
+	bool const timed = lyxerr.debugging(Debug::FILES);
+	chrono::steady_clock::time_point const start = timed
+		? chrono::steady_clock::now() : chrono::steady_clock::time_point();
+	Index::Map const & temppaths =
+		realpath ? bindex.real_temppaths : bindex.temppaths;
+	// Find the buffer whose temppath is a parent directory of path
+	Buffer * buf = nullptr;
+	for (size_t pos = path.find('/'); !buf; pos = path.find('/', pos + 1)) {
+		buf = lookup(temppaths, path.substr(0, pos));
+		if (pos == string::npos)
+			break;
+	}
+	Buffer * result = nullptr;
+	if (buf) {
+		// check whether the filename matches the master
+		string const master_name = buf->latexName();
+		if (suffixIs(path, master_name))
+			result = buf;
+		else {
 			// if not, try with the children
 			for (Buffer * child : buf->getDescendants()) {
 				string const mangled_child_name = DocFileName(
 					changeExtension(child->absFileName(),
 						".tex")).mangledFileName();
-				if (suffixIs(path, mangled_child_name))
-					return child;
+				if (suffixIs(path, mangled_child_name)) {
+					result = child;
+					break;
+				}
 			}
 		}
 	}
-	return nullptr;
+	if (timed)
+		recordLookup(chrono::duration<double>(
+			chrono::steady_clock::now() - start).count(), result);
+	return result;
+}
+
+
+void BufferList::fileNameChanged(Buffer const * b)
+{
+	BufferStorage::const_iterator it = find(bstore.begin(), bstore.end(), b);
+	if (it != bstore.end()) {
+		removeFromIndex(bindex, bstore, b);
+		addToIndex(bindex, *it);
+	}
+	it = find(binternal.begin(), binternal.end(), b);
+	if (it != binternal.end()) {
+		removeFromIndex(binternal_index, binternal, b);
+		addToIndex(binternal_index, *it);
+	}
+}
+
+
+void BufferList::addToIndex(Index & index, Buffer * b)
+{
+	IndexKeys keys;
+	keys.name = nameKey(b->absFileName());
+	keys.real_name = nameKey(b->fileName().realPath());
+	keys.temppath = b->temppath();
+	if (!keys.temppath.empty())
+		keys.real_temppath = FileName(keys.temppath).realPath();
+	// If several buffers have the same key, the first one is found,
+	// as with a search in the storage.
+	index.names.emplace(keys.name, b);
+	index.real_names.emplace(keys.real_name, b);
+	if (!keys.temppath.empty()) {
+		index.temppaths.emplace(keys.temppath, b);
+		index.real_temppaths.emplace(keys.real_temppath, b);
+	}
+	index.keys[b] = keys;
+}
+
+
+void BufferList::removeFromIndex(Index & index, BufferStorage const & store,
+                                 Buffer const * b)
+{
+	auto const it = index.keys.find(b);
+	if (it == index.keys.end())
+		return;
+	IndexKeys const keys = it->second;
+	index.keys.erase(it);
+
+	auto remove = [&](Index::Map & map, string IndexKeys::* member) {
+		string const & key = keys.*member;
+		Index::Map::iterator const mit = map.find(key);
+		if (mit == map.end() || mit->second != b)
+			return;
+		map.erase(mit);
+		// Another buffer may have the same key
+		for (Buffer * other : store) {
+			auto const kit = index.keys.find(other);
+			if (kit != index.keys.end() && kit->second.*member == key) {
+				map.emplace(key, other);
+				return;
+			}
+		}
+	};
+	remove(index.names, &IndexKeys::name);
+	remove(index.real_names, &IndexKeys::real_name);
+	remove(index.temppaths, &IndexKeys::temppath);
+	remove(index.real_temppaths, &IndexKeys::real_temppath);
+}
+
+
+void BufferList::recordLookup(double seconds, bool found) const
+{
+	++lookups_;
+	if (found)
+		++lookup_hits_;
+	lookup_seconds_ += seconds;
+	if (lookups_ < lookup_report_interval)
+		return;
+	LYXERR(Debug::FILES, "BufferList: " << lookups_ << " lookups, "
+		<< lookup_hits_ << " found, "
+		<< 1e6 * lookup_seconds_ / lookups_ << " us on average");
+	lookups_ = 0;
+	lookup_hits_ = 0;
+	lookup_seconds_ = 0;
 }
 
 
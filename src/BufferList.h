@@ -13,6 +13,7 @@
 #define BUFFER_LIST_H
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 
@@ -103,6 +104,9 @@ public:
 	///  If optional \p realpath is \c true the lookup is done with real path names
 	Buffer * getBufferFromTmp(std::string const & path, bool realpath = false);
 
+	/// Update the lookup tables after the file name of \p b changed
+	void fileNameChanged(Buffer const * b);
+
 	/** returns a pointer to the buffer that follows argument in
 	 * buffer list. The buffer following the last in list is the
 	 * first one.
@@ -142,10 +146,55 @@ private:
 
 	typedef std::vector<Buffer *> BufferStorage;
 
+	/// The keys of the lookup tables for a buffer
+	struct IndexKeys {
+		///
+		std::string name;
+		/// The name with all links resolved
+		std::string real_name;
+		///
+		std::string temppath;
+		/// The temppath with all links resolved
+		std::string real_temppath;
+	};
+	/// Lookup tables for the buffers of a BufferStorage. The file
+	/// names are compared as strings, see nameKey() in BufferList.cpp.
+	struct Index {
+		///
+		typedef std::unordered_map<std::string, Buffer *> Map;
+		///
+		Map names;
+		///
+		Map real_names;
+		///
+		Map temppaths;
+		///
+		Map real_temppaths;
+		/// The keys of each buffer, to update the tables
+		std::unordered_map<Buffer const *, IndexKeys> keys;
+	};
+	/// Add \p b to \p index
+	static void addToIndex(Index & index, Buffer * b);
+	/// Remove \p b, which has been removed from \p store, from \p index
+	static void removeFromIndex(Index & index, BufferStorage const & store,
+	                            Buffer const * b);
+	/// Record the time a lookup took, and whether it found a buffer
+	void recordLookup(double seconds, bool found) const;
+
 	/// storage of all buffers
 	BufferStorage bstore;
 	/// storage of all internal buffers used for cut&paste, etc.
 	BufferStorage binternal;
+	/// lookup tables of bstore
+	Index bindex;
+	/// lookup tables of binternal
+	Index binternal_index;
+	/// Number of lookups by file name since the last report
+	mutable unsigned int lookups_ = 0;
+	/// Number of these lookups that found a buffer
+	mutable unsigned int lookup_hits_ = 0;
+	/// Time spent in these lookups
+	mutable double lookup_seconds_ = 0;
 };
 
 /// Implementation is in LyX.cpp
@@ -3127,6 +3127,17 @@ void BufferParams::setDocumentClass(DocumentClassConstPtr const & tc)
 }
 
 
+DocumentClassConstPtr BufferParams::unshareDocumentClass()
+{
+	if (!doc_class_ || !doc_class_->isShared())
+		return DocumentClassConstPtr();
+	LYXERR(Debug::TCLASS, "Unsharing document class " << doc_class_->name());
+	unshared_doc_class_ = doc_class_;
+	doc_class_ = copyDocumentClass(*doc_class_);
+	return unshared_doc_class_;
+}
+
+
 bool BufferParams::setBaseClass(string const & classname, string const & path)
 {
 	LYXERR(Debug::TCLASS, "setBaseClass: " << classname);
@@ -3187,6 +3198,21 @@ void BufferParams::makeDocumentClass(bool clone, bool internal)
 	for (auto const & mod : layout_modules_)
 		mods.push_back(mod);
 
+	if (!clone) {
+		// Documents with the same settings share their class. Clones
+		// get their own copy, since they live in other threads.
+		vector<string> const local_layouts = {
+			to_utf8(forced_local_layout_), to_utf8(local_layout_) };
+		bool local_ok = true;
+		setDocumentClass(getSharedDocumentClass(*baseClass(), mods,
+			cite_engine_, local_layouts, internal, local_ok));
+		if (!local_ok) {
+			docstring const msg = _("Error reading internal layout information");
+			frontend::Alert::warning(_("Read Error"), msg);
+		}
+		return;
+	}
+
 	doc_class_ = getDocumentClass(*baseClass(), mods, cite_engine_, clone, internal);
 
 	TextClass::ReturnValues success = TextClass::OK;
@@ -170,6 +170,13 @@ public:
 	/// Should be called with care and would be better not being here,
 	/// but it seems to be needed by CutAndPaste::putClipboard().
 	void setDocumentClass(DocumentClassConstPtr const &);
+	/// If other documents share the DocumentClass, replace it by a copy
+	/// that can be modified (see DocumentClass::addLayoutIfNeeded()).
+	/// \return the shared class, or a null pointer if the class was not
+	/// shared. The paragraphs still refer to the layouts of the shared
+	/// class until they are switched to the copy with
+	/// cap::switchBetweenClasses(); the shared class is kept until then.
+	DocumentClassConstPtr unshareDocumentClass();
 	/// List of modules in use
 	LayoutModuleList const & getModules() const { return layout_modules_; }
 	/// List of default modules the user has removed
@@ -706,6 +713,9 @@ private:
 					   bool const warn) const;
 	///
 	DocumentClassPtr doc_class_;
+	/// The shared class doc_class_ has been copied from by
+	/// unshareDocumentClass(), paragraphs may still refer to it.
+	DocumentClassConstPtr unshared_doc_class_;
 	///
 	LayoutModuleList layout_modules_;
 	/// this is for modules that are required by the document class but that
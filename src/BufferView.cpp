@@ -84,6 +84,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdlib>
 #include <cstring>
 #include <fstream>
 #include <functional>
@@ -210,7 +211,8 @@ enum ScreenUpdateStrategy {
 	NoScreenUpdate,
 	SingleParUpdate,
 	FullScreenUpdate,
-	DecorationUpdate
+	DecorationUpdate,
+	ScrollUpdate
 };
 
 } // namespace
@@ -226,7 +228,7 @@ struct BufferView::Private
 {
 	Private(BufferView & bv) :
 		update_strategy_(FullScreenUpdate),
-		update_flags_(Update::Force),
+		update_flags_(Update::Force), math_row_memo_(bv),
 		cursor_(bv), anchor_pit_(0), anchor_ypos_(10000),
 		wh_(0), inlineCompletionUniqueChars_(0),
 		last_inset_(nullptr), mouse_position_cache_(),
@@ -242,11 +244,19 @@ struct BufferView::Private
 	ScreenUpdateStrategy update_strategy_;
 	///
 	Update::flags update_flags_;
+	/// Vertical amount of pixels by which the view has been scrolled
+	/// by scrollDocView and that has not been handled yet.
+	int scroll_request_ = 0;
+	/// Vertical amount of pixels by which the screen contents have
+	/// moved since last redraw. Only meaningful with ScrollUpdate.
+	int scroll_offset_ = 0;
 	///
 	CoordCache coord_cache_;
 	///
 	typedef unordered_map<MathData const *, MathRow> MathRows;
 	MathRows math_rows_;
+	/// layouts of math cells that can be reused by later updates
+	MathRowMemo math_row_memo_;
 
 	/// this is used to handle XSelection events in the right manner.
 	struct {
@@ -486,6 +496,12 @@ void BufferView::setMathRow(MathData const * cell, MathRow const & mrow)
 }
 
 
+MathRowMemo & BufferView::mathRowMemo()
+{
+	return d->math_row_memo_;
+}
+
+
 Buffer & BufferView::buffer()
 {
 	return buffer_;
@@ -554,9 +570,23 @@ void BufferView::processUpdateFlags(Update::flags flags)
 	LYXERR(Debug::PAINTING, "BufferView::processUpdateFlags( "
 		   << flagsAsString(flags) << ")  buffer: " << &buffer_);
 
+	// Scrolling that has been requested by scrollDocView, if any. It is
+	// taken even if nothing is done below, so that it cannot be added
+	// to a later update.
+	int const scroll_request = d->scroll_request_;
+	d->scroll_request_ = 0;
+
 	// Case when no explicit update is requested.
-	if (flags == Update::None || !ready())
+	if (flags == Update::None)
+		return;
+
+	if (!ready()) {
+		// The anchor may have moved without a shift of the pixels on
+		// screen, so that the next redraw has to be a full one.
+		if (d->update_strategy_ == ScrollUpdate)
+			d->update_strategy_ = FullScreenUpdate;
 		return;
+	}
 
 	/* FIXME We would like to avoid doing this here, since it is very
 	 * expensive and is called in updateBuffer already. However, even
@@ -566,6 +596,9 @@ void BufferView::processUpdateFlags(Update::flags flags)
 	 */
 	buffer_.updateMacros();
 
+	// Vertical amount by which the contents of the screen move
+	int scroll_shift = 0;
+
 	// First check whether the metrics and inset positions should be updated
 	if (flags & Update::Force) {
 		// This will compute all metrics and positions.
@@ -589,7 +622,8 @@ void BufferView::processUpdateFlags(Update::flags flags)
 	}
 	else if (flags & Update::ForceDraw)
 		// This will compute only the needed metrics and update positions.
-		updateMetrics(false);
+		// The anchor may have been corrected if we scrolled too far.
+		scroll_shift = updateMetrics(false) - scroll_request;
 
 	// Then make sure that the screen contains the cursor if needed
 	if (flags & Update::FitCursor) {
@@ -610,6 +644,20 @@ void BufferView::processUpdateFlags(Update::flags flags)
 		flags = (flags & ~Update::FitCursor) | Update::ForceDraw;
 	}
 
+	/* When the only thing that happened since the last redraw is
+	 * scrolling, the frontend can shift the pixels already on screen
+	 * and only the part that was not visible before has to be
+	 * painted. This is not possible when something else is waiting
+	 * to be redrawn.
+	 */
+	bool const scroll_only = scroll_request != 0 && flags == Update::ForceDraw
+		&& (d->update_flags_ == Update::None
+		    || d->update_strategy_ == ScrollUpdate)
+		&& theApp()->drawStrategy() != DrawStrategy::Full;
+	if (scroll_only)
+		d->scroll_offset_ = (d->update_strategy_ == ScrollUpdate
+		                     ? d->scroll_offset_ : 0) + scroll_shift;
+
 	if (theApp()->drawStrategy() == DrawStrategy::Full)
 		flags = flags | Update::ForceDraw;
 
@@ -623,7 +671,9 @@ void BufferView::processUpdateFlags(Update::flags flags)
 	LATTEST((d->update_flags_ & ~(Update::None | Update::SinglePar
 	                              | Update::Decoration | Update::ForceDraw)) == 0);
 
-	if (d->update_flags_ & Update::ForceDraw)
+	if (scroll_only && abs(d->scroll_offset_) < height_)
+		d->update_strategy_ = ScrollUpdate;
+	else if (d->update_flags_ & Update::ForceDraw)
 		d->update_strategy_ = FullScreenUpdate;
 	else if (d->update_flags_ & Update::Decoration)
 		d->update_strategy_ = DecorationUpdate;
@@ -796,6 +846,7 @@ void BufferView::scrollDocView(int const pixels)
 	     &&  tm.last().second->bottom() - pixels >= 0) {
 		LYXERR(Debug::SCROLLING, "small skip");
 		d->anchor_ypos_ -= pixels;
+		d->scroll_request_ = pixels;
 		processUpdateFlags(Update::ForceDraw);
 		return;
 	}
@@ -3302,6 +3353,7 @@ void BufferView::updateMetrics()
 
 int BufferView::updateMetrics(bool force)
 {
+	LYXTRACE("BufferView::updateMetrics");
 	if (!ready())
 		return 0;
 
@@ -3353,6 +3405,11 @@ int BufferView::updateMetrics(bool force)
 		tm.updateMetrics(d->anchor_pit_, d->anchor_ypos_, height_);
 	}
 
+	pair<int, int> const math_stats = d->math_row_memo_.statistics();
+	if (math_stats.first || math_stats.second)
+		LYXERR(Debug::MATHED, "Math cell layouts: " << math_stats.first
+		       << " reused, " << math_stats.second << " recorded");
+
 	// The global adjustment that have been made above
 	int const correction = d->anchor_ypos_ - old_ypos;
 
@@ -3761,6 +3818,27 @@ void BufferView::checkCursorScrollOffset()
 }
 
 
+bool BufferView::scrollBlitPending() const
+{
+	return d->update_strategy_ == ScrollUpdate;
+}
+
+
+int BufferView::scrollBlitOffset() const
+{
+	return d->update_strategy_ == ScrollUpdate ? d->scroll_offset_ : 0;
+}
+
+
+void BufferView::discardScrollBlit()
+{
+	if (d->update_strategy_ != ScrollUpdate)
+		return;
+	d->update_strategy_ = FullScreenUpdate;
+	d->scroll_offset_ = 0;
+}
+
+
 bool BufferView::busy() const
 {
 	return buffer().undo().activeUndoGroup();
@@ -3830,6 +3908,24 @@ void BufferView::draw(frontend::Painter & pain, bool paint_caret)
 		tm.draw(pi, 0, y);
 
 		break;
+
+	case ScrollUpdate: {
+		LYXERR(Debug::PAINTING, "Strategy: ScrollUpdate ("
+		       << d->scroll_offset_ << " pixels)");
+		pi.full_repaint = false;
+		// The frontend has already shifted the previous contents of
+		// the screen. Only the newly exposed band has to be redrawn.
+		int const dy = d->scroll_offset_;
+		int const y1 = dy > 0 ? 0 : height_ + dy;
+		int const y2 = dy > 0 ? dy : height_;
+		if (!pain.isNull() && y1 < y2) {
+			pain.fillRectangle(0, y1, width_, y2 - y1,
+				pi.backgroundColor(&buffer_.inset()));
+			d->text_metrics_[&text].setRowsChanged(y1, y2);
+		}
+		tm.draw(pi, 0, y);
+		break;
+	}
 	}
 
 	// Possibly grey out below
@@ -3870,6 +3966,7 @@ void BufferView::draw(frontend::Painter & pain, bool paint_caret)
 	if (!pain.isNull()) {
 		// reset the update flags, everything has been done
 		d->update_flags_ = Update::None;
+		d->scroll_offset_ = 0;
 	}
 
 	// If a caret has to be painted, mark its text row as dirty to
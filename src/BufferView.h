@@ -46,6 +46,7 @@ class InsetMathNest;
 class Length;
 class MathData;
 class MathRow;
+class MathRowMemo;
 class Point;
 class Text;
 class TextMetrics;
@@ -235,6 +236,19 @@ public:
 	void scroll(int pixels);
 	/// Scroll the view by a number of pixels.
 	void scrollDocView(int pixels);
+	/** True if the next redraw only has to account for a vertical
+	 * scroll of the view. The frontend is then expected to shift the
+	 * pixels that are already on screen by scrollBlitOffset(), since
+	 * only the newly exposed part will be painted.
+	 */
+	bool scrollBlitPending() const;
+	/// The number of pixels by which the contents of the screen have
+	/// moved (positive when they move down) if scrollBlitPending(),
+	/// 0 otherwise.
+	int scrollBlitOffset() const;
+	/// Make sure that the next redraw repaints the whole screen,
+	/// when the frontend cannot shift its contents.
+	void discardScrollBlit();
 	/// Set the cursor position based on the scrollbar one.
 	void setCursorFromScrollbar();
 
@@ -337,6 +351,8 @@ public:
 	MathRow const & mathRow(MathData const * cell) const;
 	///
 	void setMathRow(MathData const * cell, MathRow const & mrow);
+	/// The layouts of math cells that can be reused, see MathData::metrics()
+	MathRowMemo & mathRowMemo();
 
 	///
 	Point getPos(DocIterator const & dit) const;
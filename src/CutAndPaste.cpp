@@ -64,6 +64,7 @@
 #include "frontends/alert.h"
 #include "frontends/Clipboard.h"
 
+#include <memory>
 #include <string>
 #include <tuple>
 
@@ -646,6 +647,91 @@ Buffer * copyToTempBuffer(ParagraphList const & paragraphs, DocumentClassConstPt
 }
 
 
+/// The contents of the system clipboard in LyX and XHTML format. They are
+/// generated from a temporary buffer when they are requested first.
+class ClipboardContents {
+public:
+	///
+	explicit ClipboardContents(Buffer * buffer) : buffer_(buffer) {}
+	///
+	~ClipboardContents() { delete buffer_; }
+	///
+	string const & lyx()
+	{
+		if (!lyx_done_) {
+			prepare();
+			// Make sure MarkAsExporting is deleted before buffer is
+			MarkAsExporting mex(buffer_);
+			ostringstream oslyx;
+			if (buffer_->write(oslyx))
+				lyx_ = oslyx.str();
+			lyx_done_ = true;
+			release();
+		}
+		return lyx_;
+	}
+	///
+	docstring const & html()
+	{
+		if (!html_done_) {
+			prepare();
+			MarkAsExporting mex(buffer_);
+			odocstringstream oshtml;
+			OutputParams runparams(encodings.fromLyXName("utf8"));
+			// We do not need to produce images, etc.
+			runparams.dryrun = true;
+			// We are not interested in errors (bug 8866)
+			runparams.silent = true;
+			buffer_->writeLyXHTMLSource(oshtml, runparams, Buffer::FullSource);
+			html_ = oshtml.str();
+			html_done_ = true;
+			release();
+		}
+		return html_;
+	}
+
+private:
+	///
+	void prepare()
+	{
+		if (prepared_)
+			return;
+		// The Buffer is being used to export. This is necessary so that the
+		// updateMacros call will record the needed information.
+		MarkAsExporting mex(buffer_);
+		buffer_->updateBuffer(Buffer::UpdateMaster, OutputUpdate);
+		buffer_->updateMacros();
+		buffer_->updateMacroInstances(OutputUpdate);
+		prepared_ = true;
+	}
+	/// Save that memory once all formats are generated
+	void release()
+	{
+		if (lyx_done_ && html_done_) {
+			delete buffer_;
+			buffer_ = nullptr;
+		}
+	}
+	///
+	Buffer * buffer_;
+	///
+	bool prepared_ = false;
+	///
+	bool lyx_done_ = false;
+	///
+	string lyx_;
+	///
+	bool html_done_ = false;
+	///
+	docstring html_;
+};
+
+
+/// The contents that were put on the system clipboard last, if the
+/// clipboard still holds them
+weak_ptr<ClipboardContents> clipboard_contents;
+
+
 void putClipboard(ParagraphList const & paragraphs,
 		  DocInfoPair docinfo, docstring const & plaintext,
 		  BufferParams const & bp)
@@ -663,36 +749,14 @@ void putClipboard(ParagraphList const & paragraphs,
 	for (Author const & a : bp.authors())
 		buffer->params().authors().record(a);
 
-	// Make sure MarkAsExporting is deleted before buffer is
-	{
-		// The Buffer is being used to export. This is necessary so that the
-		// updateMacros call will record the needed information.
-		MarkAsExporting mex(buffer);
-
-		buffer->updateBuffer(Buffer::UpdateMaster, OutputUpdate);
-		buffer->updateMacros();
-		buffer->updateMacroInstances(OutputUpdate);
-
-		// LyX's own format
-		string lyx;
-		ostringstream oslyx;
-		if (buffer->write(oslyx))
-			lyx = oslyx.str();
-
-		// XHTML format
-		odocstringstream oshtml;
-		OutputParams runparams(encodings.fromLyXName("utf8"));
-		// We do not need to produce images, etc.
-		runparams.dryrun = true;
-		// We are not interested in errors (bug 8866)
-		runparams.silent = true;
-		buffer->writeLyXHTMLSource(oshtml, runparams, Buffer::FullSource);
-
-		theClipboard().put(lyx, oshtml.str(), plaintext);
-	}
-
-	// Save that memory
-	delete buffer;
+	// The LyX and XHTML formats are expensive for large selections, and
+	// many applications only want plain text. The clipboard keeps the
+	// contents alive as long as it needs them.
+	auto const contents = make_shared<ClipboardContents>(buffer);
+	clipboard_contents = contents;
+	theClipboard().put([contents](){ return contents->lyx(); },
+	                   [contents](){ return contents->html(); },
+	                   plaintext);
 }
 
 
@@ -834,15 +898,48 @@ void switchBetweenClasses(DocumentClassConstPtr const & oldone,
 }
 
 
+namespace {
+
+/// Layouts of \p in that \p dclass does not know are added to it by
+/// switchBetweenClasses(). If \p dclass is the class of the buffer of
+/// \p in and other documents share it, give the buffer its own copy
+/// first, and return that.
+DocumentClassConstPtr ownDocumentClass(DocumentClassConstPtr const & dclass,
+                                       InsetText & in)
+{
+	Buffer & buffer = in.buffer();
+	if (!dclass->isShared() || buffer.params().documentClassPtr() != dclass)
+		return dclass;
+	bool unknown = false;
+	ParIterator const pend = par_iterator_end(in);
+	for (ParIterator it = par_iterator_begin(in); it != pend && !unknown; ++it)
+		unknown = !dclass->hasLayout(it->layout().name());
+	if (!unknown)
+		return dclass;
+
+	DocumentClassConstPtr const shared = buffer.params().unshareDocumentClass();
+	DocumentClassConstPtr const own = buffer.params().documentClassPtr();
+	// The paragraphs of the buffer itself still refer to the shared class
+	InsetText & main = static_cast<InsetText &>(buffer.inset());
+	if (&in != &main)
+		switchBetweenClasses(shared, own, main);
+	return own;
+}
+
+} // namespace
+
+
 void switchBetweenClasses(DocumentClassConstPtr const & oldone,
-		DocumentClassConstPtr const & newone, InsetText & in, ErrorList & errorlist)
+		DocumentClassConstPtr const & newclass, InsetText & in, ErrorList & errorlist)
 {
 	errorlist.clear();
 
 	LBUFERR(!in.paragraphs().empty());
-	if (oldone == newone)
+	if (oldone == newclass)
 		return;
 
+	// Unknown layouts are added to the new class below
+	DocumentClassConstPtr const newone = ownDocumentClass(newclass, in);
 	DocumentClass const & oldtc = *oldone;
 	DocumentClass const & newtc = *newone;
 
@@ -1225,6 +1322,15 @@ void clearCutStack()
 }
 
 
+void flushClipboard()
+{
+	if (shared_ptr<ClipboardContents> contents = clipboard_contents.lock()) {
+		contents->lyx();
+		contents->html();
+	}
+}
+
+
 docstring selection(size_t sel_index, DocInfoPair docinfo, bool for_math)
 {
 	if (sel_index >= theCuts.size())
@@ -96,6 +96,9 @@ bool selection();
 void clearSelection();
 /// Clear our cut stack.
 void clearCutStack();
+/// Generate the formats of the system clipboard contents that were not
+/// requested yet, so that they are available after LyX quits.
+void flushClipboard();
 /// Paste the current selection at \p cur
 /// Does handle undo. Does only work in text, not mathed.
 void pasteSelection(Cursor & cur, ErrorList &);
@@ -136,6 +136,14 @@ void ExportData::addExternalFile(string const & format,
 }
 
 
+void ExportData::addExternalFiles(ExportData const & other)
+{
+	for (auto const & fmt : other.externalfiles_)
+		for (ExportedFile const & file : fmt.second)
+			addExternalFile(fmt.first, file.sourceName, file.exportName);
+}
+
+
 vector<ExportedFile> const
 ExportData::externalFiles(string const & format) const
 {
@@ -81,6 +81,8 @@ public:
 	 */
 	void addExternalFile(std::string const & format,
 			     support::FileName const & sourceName);
+	/// add all referenced files of \p other, for all formats
+	void addExternalFiles(ExportData const & other);
 	/// get referenced files for \p format
 	std::vector<ExportedFile> const
 		externalFiles(std::string const & format) const;
@@ -16,6 +16,7 @@
 #include <config.h>
 
 #include "LaTeX.h"
+#include "LaTeXLogMatch.h"
 
 #include "Buffer.h"
 #include "BufferList.h"
@@ -44,6 +45,7 @@
 
 
 using namespace std;
+using namespace lyx::latexlog;
 using namespace lyx::support;
 
 namespace lyx {
@@ -707,27 +709,27 @@ void LaTeX::scanAuxFile(FileName const & fname, AuxInfo & aux_info)
 
 	ifstream ifs(fname.toFilesystemEncoding().c_str());
 	string token;
-	static regex const reg1("\\\\citation\\{([^}]+)\\}");
-	static regex const reg2("\\\\bibdata\\{([^}]+)\\}");
-	static regex const reg3("\\\\bibstyle\\{([^}]+)\\}");
-	static regex const reg4("\\\\@input\\{([^}]+)\\}");
+	string data;
 
 	while (getline(ifs, token)) {
 		token = rtrim(token, "\r");
-		smatch sub;
+		// We are only interested in a few macros at the start of the line
+		if (!prefixIs(token, "\\citation{") && !prefixIs(token, "\\bib")
+		    && !prefixIs(token, "\\@input{"))
+			continue;
 		// FIXME UNICODE: We assume that citation keys and filenames
 		// in the aux file are in the file system encoding.
 		token = to_utf8(from_filesystem8bit(token));
-		if (regex_match(token, sub, reg1)) {
-			string data = sub.str(1);
+		// "\\citation\\{([^}]+)\\}"
+		if (matchBraced(token, "\\citation", data)) {
 			while (!data.empty()) {
 				string citation;
 				data = split(data, citation, ',');
 				LYXERR(Debug::OUTFILE, "Citation: " << citation);
 				aux_info.citations.insert(citation);
 			}
-		} else if (regex_match(token, sub, reg2)) {
-			string data = sub.str(1);
+		// "\\bibdata\\{([^}]+)\\}"
+		} else if (matchBraced(token, "\\bibdata", data)) {
 			// data is now all the bib files separated by ','
 			// get them one by one and pass them to the helper
 			while (!data.empty()) {
@@ -737,16 +739,17 @@ void LaTeX::scanAuxFile(FileName const & fname, AuxInfo & aux_info)
 				LYXERR(Debug::OUTFILE, "BibTeX database: `" << database << '\'');
 				aux_info.databases.insert(database);
 			}
-		} else if (regex_match(token, sub, reg3)) {
-			string style = sub.str(1);
+		// "\\bibstyle\\{([^}]+)\\}"
+		} else if (matchBraced(token, "\\bibstyle", data)) {
+			string style = data;
 			// token is now the style file
 			// pass it to the helper
 			style = changeExtension(style, "bst");
 			LYXERR(Debug::OUTFILE, "BibTeX style: `" << style << '\'');
 			aux_info.styles.insert(style);
-		} else if (regex_match(token, sub, reg4)) {
-			string const file2 = sub.str(1);
-			scanAuxFile(makeAbsPath(file2), aux_info);
+		// "\\@input\\{([^}]+)\\}"
+		} else if (matchBraced(token, "\\@input", data)) {
+			scanAuxFile(makeAbsPath(data), aux_info);
 		}
 	}
 }
@@ -826,6 +829,7 @@ int getLineNumber(const string &token){
 
 int LaTeX::scanLogFile(TeXErrors & terr)
 {
+	LYXTRACE("LaTeX::scanLogFile");
 	int last_line = -1;
 	int line_count = 1;
 	int retval = NO_ERRORS;
@@ -838,9 +842,6 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 	// encoding of the TeX file (T1, TU etc.). See #10728.
 	ifstream ifs(fn.toFilesystemEncoding().c_str());
 	bool fle_style = false;
-	static regex const file_line_error(".+\\.\\D+:[0-9]+: (.+)");
-	static regex const child_file("[^0-9]*([0-9]+[A-Za-z]*_.+\\.tex).*");
-	static regex const undef_ref(".*Reference `(\\w+)\\' on page.*");
 	// Flag for 'File ended while scanning' message.
 	// We need to wait for subsequent processing.
 	string wait_for_error;
@@ -853,14 +854,11 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 
 	string token;
 	string ml_token;
+	string ref;
 	while (getline(ifs, token)) {
-		// MikTeX sometimes inserts \0 in the log file. They can't be
-		// removed directly with the existing string utility
-		// functions, so convert them first to \r, and remove all
-		// \r's afterwards, since we need to remove them anyway.
-		token = subst(token, '\0', '\r');
-		token = subst(token, "\r", "");
-		smatch sub;
+		// MikTeX sometimes inserts \0 in the log file. Remove them
+		// together with all \r's, since we need to remove them anyway.
+		stripLogLine(token);
 
 		LYXERR(Debug::OUTFILE, "Log line: " << token);
 
@@ -876,11 +874,10 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 				++pnest;
 				size_t j = token.find('(', i + 1);
 				size_t len = j == string::npos
-						? token.substr(i + 1).length()
+						? token.length() - i - 1
 						: j - i - 1;
-				string const substr = token.substr(i + 1, len);
-				if (regex_match(substr, sub, child_file)) {
-					string const name = sub.str(1);
+				string name;
+				if (matchChildFile(token, i + 1, i + 1 + len, name)) {
 					// Sometimes also masters have a name that matches
 					// (if their name starts with a number and _)
 					if (name != file.onlyFileName()) {
@@ -962,8 +959,7 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 					ml_token.clear();
 					continue;
 				}
-				if (regex_match(ml_token, sub, undef_ref)) {
-					string const ref = sub.str(1);
+				if (matchUndefRef(ml_token, ref)) {
 					Buffer const * buf = theBufferList().getBufferFromTmp(file.absFileName());
 					if (!buf || !buf->masterBuffer()->activeLabel(from_utf8(ref))) {
 						terr.insertRef(getLineNumber(ml_token), from_ascii("Reference undefined"),
@@ -976,8 +972,7 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 			} else if (contains(token, "Reference `")
 				   && contains(token, "on input line")
 				   && contains(token, "undefined")) {
-				if (regex_match(token, sub, undef_ref)) {
-					string const ref = sub.str(1);
+				if (matchUndefRef(token, ref)) {
 					Buffer const * buf = theBufferList().getBufferFromTmp(file.absFileName());
 					if (!buf || !buf->masterBuffer()->activeLabel(from_utf8(ref))) {
 						terr.insertRef(getLineNumber(token), from_ascii("Reference undefined"),
@@ -1035,7 +1030,7 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 			}
 		} else if (prefixIs(token, "! ")
 			    || (fle_style
-				&& regex_match(token, sub, file_line_error)
+				&& matchFileLineError(token)
 				&& !contains(token, "pdfTeX warning"))) {
 			   // Ok, we have something that looks like a TeX Error
 			   // but what do we really have.
@@ -1045,7 +1040,7 @@ int LaTeX::scanLogFile(TeXErrors & terr)
 			if (prefixIs(token, "! "))
 				desc = string(token, 2);
 			else if (fle_style)
-				desc = sub.str();
+				desc = token;
 			if (contains(token, "LaTeX Error:"))
 				retval |= LATEX_ERROR;
 
@@ -1320,8 +1315,9 @@ bool handleFoundFile(string const & ff, DepTable & head)
 	if (absname.exists() && !absname.isDirectory()) {
 		// FIXME: This regex contained glo, but glo is used by the old
 		// version of nomencl.sty. Do we need to put it back?
-		static regex const unwanted("^.*\\.(aux|log|dvi|bbl|ind)$");
-		if (regex_match(onlyfile, unwanted)) {
+		if (suffixIs(onlyfile, ".aux") || suffixIs(onlyfile, ".log")
+		    || suffixIs(onlyfile, ".dvi") || suffixIs(onlyfile, ".bbl")
+		    || suffixIs(onlyfile, ".ind")) {
 			LYXERR(Debug::DEPEND, "We don't want " << onlyfile
 				<< " in the dep file");
 		} else if (suffixIs(onlyfile, ".tex")) {
@@ -1354,52 +1350,49 @@ bool completeFilename(string const & ff, DepTable & head)
 }
 
 
-int iterateLine(string const & token, regex const & reg, string const & opening,
+// Searches for "<opening>([^<excl>]+)(.)" on the line
+int iterateLine(string const & token, char const * excl, string const & opening,
 		string const & closing, int fragment_pos, DepTable & head)
 {
-	smatch what;
-	string::const_iterator first = token.begin();
-	string::const_iterator end = token.end();
+	size_t first = 0;
 	bool fragment = false;
 	string last_match;
+	string what1;
+	string what2;
 
-	while (regex_search(first, end, what, reg)) {
+	while (searchDelimited(token, first, opening[0], excl, what1, what2)) {
 		// if we have a dot, try to handle as file
-		if (contains(what.str(1), '.')) {
-			first = what[0].second;
-			if (what.str(2) == closing) {
-				handleFoundFile(what.str(1), head);
+		if (contains(what1, '.')) {
+			if (what2 == closing) {
+				handleFoundFile(what1, head);
 				// since we had a closing bracket,
 				// do not investigate further
 				fragment = false;
-			} else if (what.str(2) == opening) {
+			} else if (what2 == opening) {
 				// if we have another opening bracket,
 				// we might have a nested file chain
 				// as is (file.ext (subfile.ext))
-				fragment = !handleFoundFile(rtrim(what.str(1)), head);
+				fragment = !handleFoundFile(rtrim(what1), head);
 				// decrease first position by one in order to
 				// consider the opening delimiter on next iteration
-				if (first > token.begin())
+				if (first > 0)
 					--first;
 			} else
 				// if we have no closing bracket,
 				// try to handle as file nevertheless
-				fragment = !handleFoundFile(
-					what.str(1) + what.str(2), head);
+				fragment = !handleFoundFile(what1 + what2, head);
 		}
 		// if we do not have a dot, check if the line has
 		// a closing bracket (else, we suspect a line break)
-		else if (what.str(2) != closing) {
-			first = what[0].second;
+		else if (what2 != closing) {
 			fragment = true;
 		} else {
 			// we have a closing bracket, so the content
 			// is not a file name.
 			// no need to investigate further
-			first = what[0].second;
 			fragment = false;
 		}
-		last_match = what.str(1);
+		last_match = what1;
 	}
 
 	// We need to consider the result from previous line iterations:
@@ -1433,37 +1426,38 @@ void LaTeX::deplog(DepTable & head)
 	// This function reads the LaTeX log file end extracts all the
 	// external files used by the LaTeX run. The files are then
 	// entered into the dependency file.
+	LYXTRACE("LaTeX::deplog");
 
 	string const logfile =
 		onlyFileName(changeExtension(file.absFileName(), ".log"));
 
-	static regex const reg1("File: (.+).*");
-	static regex const reg2("No file (.+)(.).*");
-	static regex const reg3a("\\\\openout[0-9]+.*=.*`(.+)(..).*");
-	// LuaTeX has a slightly different output
-	static regex const reg3b("\\\\openout[0-9]+.*=\\s*(.+)");
+	// We look for the following kind of lines (see the matchers above):
+	//   "File: file.ext"
+	//   "No file file.ext."
+	//   "\openout<nr> = `file.ext'." or "\openout<nr> = file.ext" (LuaTeX)
+	//   "Writing index file file.ext"
+	//   "Writing glossary file file.ext" or "Writing nomenclature file file.ext"
+	//   "\tf@toc=\write<nr>"
+	// and file names enclosed in <...> or (...) anywhere on the line.
+	//
 	// If an index should be created, MikTex does not write a line like
 	//    \openout# = 'sample.idx'.
 	// but instead only a line like this into the log:
 	//   Writing index file sample.idx
-	static regex const reg4("Writing index file (.+).*");
-	static regex const regoldnomencl("Writing glossary file (.+).*");
-	static regex const regnomencl(".*Writing nomenclature file (.+).*");
+	//
 	// If a toc should be created, MikTex does not write a line like
 	//    \openout# = `sample.toc'.
 	// but only a line like this into the log:
 	//    \tf@toc=\write#
 	// This line is also written by tetex.
 	// This line is not present if no toc should be created.
-	static regex const miktexTocReg("\\\\tf@toc=\\\\write.*");
-	// file names can be enclosed in <...> (anywhere on the line)
-	static regex const reg5(".*<[^>]+.*");
-	// and also (...) anywhere on the line
-	static regex const reg6(".*\\([^)]+.*");
 
 	FileName const fn = makeAbsPath(logfile);
 	ifstream ifs(fn.toFilesystemEncoding().c_str());
 	string lastline;
+	string token;
+	string arg;
+	string tail;
 	while (ifs) {
 		// Ok, the scanning of files here is not sufficient.
 		// Sometimes files are named by "File: xxx" only
@@ -1472,14 +1466,10 @@ void LaTeX::deplog(DepTable & head)
 		// Also, file names might be broken across lines. Therefore
 		// we mark (potential) fragments and merge those lines.
 		bool fragment = false;
-		string token;
 		getline(ifs, token);
-		// MikTeX sometimes inserts \0 in the log file. They can't be
-		// removed directly with the existing string utility
-		// functions, so convert them first to \r, and remove all
-		// \r's afterwards, since we need to remove them anyway.
-		token = subst(token, '\0', '\r');
-		token = subst(token, "\r", "");
+		// MikTeX sometimes inserts \0 in the log file. Remove them
+		// together with all \r's, since we need to remove them anyway.
+		stripLogLine(token);
 		if (token.empty() || token == ")") {
 			lastline = string();
 			continue;
@@ -1494,8 +1484,6 @@ void LaTeX::deplog(DepTable & head)
 		// Here we exclude some cases where we are sure
 		// that there is no continued filename
 		if (!lastline.empty()) {
-			static regex const package_info("Package \\w+ Info: .*");
-			static regex const package_warning("Package \\w+ Warning: .*");
 			if (prefixIs(token, "File:") || prefixIs(token, "(Font)")
 			    || prefixIs(token, "Package:")
 			    || prefixIs(token, "Language:")
@@ -1503,8 +1491,8 @@ void LaTeX::deplog(DepTable & head)
 			    || prefixIs(token, "LaTeX Font Info:")
 			    || prefixIs(token, "\\openout[")
 			    || prefixIs(token, "))")
-			    || regex_match(token, package_info)
-			    || regex_match(token, package_warning))
+			    || matchPackageMessage(token, "Info")
+			    || matchPackageMessage(token, "Warning"))
 				lastline = string();
 		}
 
@@ -1516,51 +1504,51 @@ void LaTeX::deplog(DepTable & head)
 			token.erase(0, token.length() - 251);
 		}
 
-		smatch sub;
-
 		// (1) "File: file.ext"
-		if (regex_match(token, sub, reg1)) {
+		if (matchPrefixed(token, "File: ", arg)) {
 			// is this a fragmental file name?
-			fragment = !completeFilename(sub.str(1), head);
+			fragment = !completeFilename(arg, head);
 			// However, ...
 			if (suffixIs(token, ")"))
 				// no fragment for sure
 				fragment = false;
 		// (2) "No file file.ext"
-		} else if (regex_match(token, sub, reg2)) {
+		} else if (matchPrefixed(token, "No file ", arg) && arg.size() > 1) {
 			// file names must contains a dot, line ends with dot
-			if (contains(sub.str(1), '.') && sub.str(2) == ".")
-				fragment = !handleFoundFile(sub.str(1), head);
+			tail = arg.substr(arg.size() - 1);
+			arg.pop_back();
+			if (contains(arg, '.') && tail == ".")
+				fragment = !handleFoundFile(arg, head);
 			else
 				// we suspect a line break
 				fragment = true;
 		// (3)(a) "\openout<nr> = `file.ext'."
-		} else if (regex_match(token, sub, reg3a)) {
+		} else if (matchOpenoutQuoted(token, arg, tail)) {
 			// search for closing '. at the end of the line
-			if (sub.str(2) == "\'.")
-				fragment = !handleFoundFile(sub.str(1), head);
+			if (tail == "\'.")
+				fragment = !handleFoundFile(arg, head);
 			else
 				// potential fragment
 				fragment = true;
 		// (3)(b) "\openout<nr> = file.ext" (LuaTeX)
-		} else if (regex_match(token, sub, reg3b)) {
+		} else if (matchOpenoutPlain(token, arg)) {
 			// file names must contains a dot
-			if (contains(sub.str(1), '.'))
-				fragment = !handleFoundFile(sub.str(1), head);
+			if (contains(arg, '.'))
+				fragment = !handleFoundFile(arg, head);
 			else
 				// potential fragment
 				fragment = true;
 		// (4) "Writing index file file.ext"
-		} else if (regex_match(token, sub, reg4))
+		} else if (matchPrefixed(token, "Writing index file ", arg))
 			// fragmential file name?
-			fragment = !completeFilename(sub.str(1), head);
+			fragment = !completeFilename(arg, head);
 		// (5) "Writing nomenclature file file.ext"
-		else if (regex_match(token, sub, regnomencl) ||
-			   regex_match(token, sub, regoldnomencl))
+		else if (matchInfix(token, "Writing nomenclature file ", arg)
+			 || matchPrefixed(token, "Writing glossary file ", arg))
 			// fragmental file name?
-			fragment= !completeFilename(sub.str(1), head);
+			fragment= !completeFilename(arg, head);
 		// (6) "\tf@toc=\write<nr>" (for MikTeX)
-		else if (regex_match(token, sub, miktexTocReg))
+		else if (prefixIs(token, "\\tf@toc=\\write"))
 			fragment = !handleFoundFile(onlyFileName(changeExtension(
 						file.absFileName(), ".toc")), head);
 		else
@@ -1571,10 +1559,9 @@ void LaTeX::deplog(DepTable & head)
 		// (7) "<file.ext>"
 		// We can have several of these on one line
 		// (and in addition to those above)
-		if (regex_match(token, sub, reg5)) {
+		if (hasDelimitedContent(token, '<', '>')) {
 			// search for strings in <...>
-			static regex const reg5_1("<([^>]+)(.)");
-			fragment_pos = iterateLine(token, reg5_1, "<", ">",
+			fragment_pos = iterateLine(token, ">", "<", ">",
 						   fragment_pos, head);
 			fragment = (fragment_pos != -1);
 		}
@@ -1584,10 +1571,9 @@ void LaTeX::deplog(DepTable & head)
 		// this must be queried separated, because of
 		// cases such as "File: file.ext (type eps)"
 		// where "File: file.ext" would be skipped
-		if (regex_match(token, sub, reg6)) {
+		if (hasDelimitedContent(token, '(', ')')) {
 			// search for strings in (...)
-			static regex const reg6_1("\\(([^()]+)(.)");
-			fragment_pos = iterateLine(token, reg6_1, "(", ")",
+			fragment_pos = iterateLine(token, "()", "(", ")",
 						   fragment_pos, head);
 			fragment = (fragment_pos != -1);
 		}
@@ -0,0 +1,262 @@
+/**
+ * \file LaTeXLogMatch.cpp
+ * This file is part of LyX, the document processor.
+ * Licence details can be found in the file COPYING.
+ *
+ * Full author contact details are available in file CREDITS.
+ */
+
+#include <config.h>
+
+#include "LaTeXLogMatch.h"
+
+#include "support/lstrings.h"
+
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+using namespace lyx::support;
+
+namespace lyx {
+namespace latexlog {
+
+namespace {
+
+bool isDigit(char c)
+{
+	return c >= '0' && c <= '9';
+}
+
+
+// \w
+bool isWordChar(char c)
+{
+	return isDigit(c) || c == '_'
+		|| (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+
+// \s
+bool isSpace(char c)
+{
+	return c == ' ' || c == '\t' || c == '\n' || c == '\v'
+		|| c == '\f' || c == '\r';
+}
+
+
+/// "\\openout[0-9]+.*": returns the position after the number or npos.
+size_t matchOpenout(string const & s)
+{
+	if (!prefixIs(s, "\\openout") || s.size() < 9 || !isDigit(s[8]))
+		return string::npos;
+	size_t i = 9;
+	while (i < s.size() && isDigit(s[i]))
+		++i;
+	return i;
+}
+
+} // namespace
+
+
+void stripLogLine(string & line)
+{
+	line.erase(remove_if(line.begin(), line.end(),
+	                     [](char c) { return c == '\0' || c == '\r'; }),
+	           line.end());
+}
+
+
+bool matchPrefixed(string const & s, char const * pre, string & arg)
+{
+	size_t const len = strlen(pre);
+	if (s.size() <= len || s.compare(0, len, pre) != 0)
+		return false;
+	arg = s.substr(len);
+	return true;
+}
+
+
+bool matchInfix(string const & s, char const * str, string & arg)
+{
+	size_t const len = strlen(str);
+	for (size_t pos = s.rfind(str); pos != string::npos;
+	     pos = pos == 0 ? string::npos : s.rfind(str, pos - 1)) {
+		if (pos + len < s.size()) {
+			arg = s.substr(pos + len);
+			return true;
+		}
+	}
+	return false;
+}
+
+
+bool matchBraced(string const & s, char const * pre, string & arg)
+{
+	size_t const len = strlen(pre);
+	if (s.size() < len + 3 || s.compare(0, len, pre) != 0
+	    || s[len] != '{' || s.back() != '}')
+		return false;
+	size_t const close = s.find('}', len + 1);
+	if (close != s.size() - 1)
+		return false;
+	arg = s.substr(len + 1, close - len - 1);
+	return true;
+}
+
+
+bool matchChildFile(string const & s, size_t b, size_t e, string & name)
+{
+	size_t i = b;
+	while (i < e && !isDigit(s[i]))
+		++i;
+	size_t const start = i;
+	if (start == e)
+		return false;
+	while (i < e && isDigit(s[i]))
+		++i;
+	while (i < e && ((s[i] >= 'a' && s[i] <= 'z') || (s[i] >= 'A' && s[i] <= 'Z')))
+		++i;
+	if (i == e || s[i] != '_')
+		return false;
+	// ".+" is greedy, so we want the last ".tex" in the range
+	// that leaves at least one character after the underscore.
+	if (e - i < 6)
+		return false;
+	size_t const ext = s.rfind(".tex", e - 4);
+	if (ext == string::npos || ext < i + 2)
+		return false;
+	name = s.substr(start, ext + 4 - start);
+	return true;
+}
+
+
+bool matchFileLineError(string const & s)
+{
+	for (size_t c = s.find(':', 2); c != string::npos; c = s.find(':', c + 1)) {
+		size_t i = c + 1;
+		while (i < s.size() && isDigit(s[i]))
+			++i;
+		if (i == c + 1 || i + 2 >= s.size() || s[i] != ':' || s[i + 1] != ' ')
+			continue;
+		// now look back for a dot followed by non-digits only
+		for (size_t j = c - 1; j >= 1 && !isDigit(s[j]); --j) {
+			if (s[j] == '.' && j + 2 <= c)
+				return true;
+		}
+	}
+	return false;
+}
+
+
+bool matchUndefRef(string const & s, string & ref)
+{
+	static string const start = "Reference `";
+	static string const end = "' on page";
+	// ".*" is greedy, so we start from the last occurrence
+	size_t pos = s.rfind(start);
+	while (pos != string::npos) {
+		size_t const b = pos + start.size();
+		size_t i = b;
+		while (i < s.size() && isWordChar(s[i]))
+			++i;
+		if (i > b && s.compare(i, end.size(), end) == 0) {
+			ref = s.substr(b, i - b);
+			return true;
+		}
+		if (pos == 0)
+			break;
+		pos = s.rfind(start, pos - 1);
+	}
+	return false;
+}
+
+
+bool matchPackageMessage(string const & s, char const * kind)
+{
+	if (!prefixIs(s, "Package "))
+		return false;
+	size_t i = 8;
+	while (i < s.size() && isWordChar(s[i]))
+		++i;
+	if (i == 8 || s[i] != ' ')
+		return false;
+	size_t const len = strlen(kind);
+	return s.compare(i + 1, len, kind) == 0
+		&& s.compare(i + 1 + len, 2, ": ") == 0;
+}
+
+
+bool matchOpenoutQuoted(string const & s, string & name, string & tail)
+{
+	size_t const b = matchOpenout(s);
+	if (b == string::npos)
+		return false;
+	size_t const eq = s.find('=', b);
+	if (eq == string::npos)
+		return false;
+	// ".*" is greedy: take the last backtick that leaves room for (.+)(..)
+	size_t q = s.rfind('`');
+	while (q != string::npos && q > eq && q + 4 > s.size())
+		q = s.rfind('`', q - 1);
+	if (q == string::npos || q < eq)
+		return false;
+	name = s.substr(q + 1, s.size() - q - 3);
+	tail = s.substr(s.size() - 2);
+	return true;
+}
+
+
+bool matchOpenoutPlain(string const & s, string & name)
+{
+	size_t const b = matchOpenout(s);
+	if (b == string::npos)
+		return false;
+	// ".*" is greedy: take the last '=' that is followed by something
+	size_t eq = s.rfind('=');
+	while (eq != string::npos && eq >= b && eq + 1 == s.size())
+		eq = eq == 0 ? string::npos : s.rfind('=', eq - 1);
+	if (eq == string::npos || eq < b)
+		return false;
+	size_t i = eq + 1;
+	while (i < s.size() && isSpace(s[i]))
+		++i;
+	// "\\s*" gives back one character if needed by "(.+)"
+	if (i == s.size())
+		--i;
+	name = s.substr(i);
+	return true;
+}
+
+
+bool hasDelimitedContent(string const & s, char open, char close)
+{
+	for (size_t p = s.find(open); p != string::npos && p + 1 < s.size();
+	     p = s.find(open, p + 1))
+		if (s[p + 1] != close)
+			return true;
+	return false;
+}
+
+
+bool searchDelimited(string const & s, size_t & first, char open,
+                     char const * excl, string & name, string & delim)
+{
+	for (size_t p = s.find(open, first); p != string::npos;
+	     p = s.find(open, p + 1)) {
+		size_t q = s.find_first_of(excl, p + 1);
+		if (q == string::npos)
+			// backtrack: the last character has to match "(.)"
+			q = s.size() - 1;
+		if (q <= p + 1)
+			continue;
+		name = s.substr(p + 1, q - p - 1);
+		delim = s.substr(q, 1);
+		first = q + 1;
+		return true;
+	}
+	return false;
+}
+
+} // namespace latexlog
+} // namespace lyx
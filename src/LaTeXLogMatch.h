@@ -0,0 +1,78 @@
+// -*- C++ -*-
+/**
+ * \file LaTeXLogMatch.h
+ * This file is part of LyX, the document processor.
+ * Licence details can be found in the file COPYING.
+ *
+ * Full author contact details are available in file CREDITS.
+ */
+
+#ifndef LATEXLOGMATCH_H
+#define LATEXLOGMATCH_H
+
+#include <string>
+
+
+namespace lyx {
+
+/**
+ * Matchers for the lines of LaTeX log and aux files.
+ *
+ * The log and aux files are scanned after every LaTeX run, and the log of
+ * a large document can easily have hundreds of thousands of lines. The
+ * patterns we look for are simple enough to be matched by hand, which is
+ * much faster than running a bunch of std::regex on every single line.
+ * Each matcher documents the regular expression it replaces (with
+ * regex_match() semantics, unless noted otherwise), and gives the same
+ * results. This is checked by tests/check_LaTeXLogMatch.
+ */
+namespace latexlog {
+
+/// Remove the \0 characters inserted by MikTeX and all \r in one go.
+void stripLogLine(std::string & line);
+
+/// "<pre>(.+).*": \p arg is everything after \p pre.
+bool matchPrefixed(std::string const & s, char const * pre, std::string & arg);
+
+/// ".*<str>(.+).*": \p arg is everything after the last \p str.
+bool matchInfix(std::string const & s, char const * str, std::string & arg);
+
+/// "<pre>\\{([^}]+)\\}": \p arg is the braced argument.
+bool matchBraced(std::string const & s, char const * pre, std::string & arg);
+
+/// "[^0-9]*([0-9]+[A-Za-z]*_.+\\.tex).*" in s[b, e): name of a child
+/// document as produced by LyX in the temp dir (e.g. 0_home_user_child.tex).
+bool matchChildFile(std::string const & s, size_t b, size_t e,
+                    std::string & name);
+
+/// ".+\\.\\D+:[0-9]+: (.+)": a file:line:error style message.
+bool matchFileLineError(std::string const & s);
+
+/// ".*Reference `(\\w+)\\' on page.*": \p ref is the undefined label.
+bool matchUndefRef(std::string const & s, std::string & ref);
+
+/// "Package \\w+ <kind>: .*"
+bool matchPackageMessage(std::string const & s, char const * kind);
+
+/// "\\openout[0-9]+.*=.*`(.+)(..).*"
+bool matchOpenoutQuoted(std::string const & s, std::string & name,
+                        std::string & tail);
+
+/// "\\openout[0-9]+.*=\\s*(.+)" (LuaTeX)
+bool matchOpenoutPlain(std::string const & s, std::string & name);
+
+/// ".*<open>[^<close>]+.*": is there an opening delimiter that is
+/// not immediately followed by the closing one?
+bool hasDelimitedContent(std::string const & s, char open, char close);
+
+/// "<open>([^<excl>]+)(.)" searched (regex_search()) in s from \p first
+/// on. On success, \p name and \p delim are the two groups and \p first
+/// points behind the match.
+bool searchDelimited(std::string const & s, size_t & first, char open,
+                     char const * excl, std::string & name,
+                     std::string & delim);
+
+} // namespace latexlog
+} // namespace lyx
+
+#endif // LATEXLOGMATCH_H
@@ -188,6 +188,8 @@ void LayoutFileList::reset(LayoutFileIndex const & classname)
 			       tc->isTeXClassAvailable());
 	classmap_[classname] = tmpl;
 	delete tc;
+	// the classes made from the old one must not be reused
+	clearDocumentClassCache();
 }
 
 
@@ -391,10 +391,16 @@ void LyX::prepareExit()
 	// Clear the clipboard and selection stack:
 	cap::clearCutStack();
 	cap::clearSelection();
+	// The system clipboard may still need our buffers
+	if (use_gui)
+		cap::flushClipboard();
 
 	// Write the index file of the converter cache
 	ConverterCache::get().writeIndex();
 
+	// Write the trace spans recorded so far
+	Trace::write();
+
 	// closing buffer may throw exceptions, but we ignore them since we
 	// are quitting.
 	try {
@@ -1194,6 +1200,18 @@ int parse_dbg(string const & arg, string const &, string &)
 }
 
 
+int parse_trace(string const & arg, string const &, string &)
+{
+	if (arg.empty()) {
+		Alert::error(_("No trace file"),
+			_("Missing file name for -trace switch"));
+		exit(1);
+	}
+	Trace::enable(arg);
+	return 1;
+}
+
+
 int parse_help(string const &, string const &, string &)
 {
 	cout <<
@@ -1206,6 +1224,8 @@ int parse_help(string const &, string const &, string &)
 		  "\t-dbg feature[,feature]...\n"
 		  "                  select the features to debug.\n"
 		  "                  Type `lyx -dbg' to see the list of features\n"
+		  "\t-trace file       record timings of LyX operations, and write them\n"
+		  "                  to file in Chrome trace event format on exit\n"
 		  "\t-x [--execute] command\n"
 		  "                  where command is a lyx command.\n"
 		  "\t-e [--export] fmt\n"
@@ -1404,6 +1424,7 @@ void LyX::easyParse(int & argc, char * argv[])
 	map<string, cmd_helper> cmdmap;
 
 	cmdmap["-dbg"] = parse_dbg;
+	cmdmap["-trace"] = parse_trace;
 	cmdmap["-help"] = parse_help;
 	cmdmap["--help"] = parse_help;
 	cmdmap["-version"] = parse_version;
@@ -60,7 +60,7 @@ namespace {
 
 // The format should also be updated in configure.py, and conversion code
 // should be added to prefs2prefs_prefs.py.
-static unsigned int const LYXRC_FILEFORMAT = 39; // spitz: \color_scheme {system|light|dark}
+static unsigned int const LYXRC_FILEFORMAT = 40; // latex_export_threads
 // when adding something to this array keep it sorted!
 LexerKeyword lyxrcTags[] = {
 	{ "\\accept_compound", LyXRC::RC_ACCEPT_COMPOUND },
@@ -143,6 +143,7 @@ LexerKeyword lyxrcTags[] = {
 	{ "\\language_custom_package", LyXRC::RC_LANGUAGE_CUSTOM_PACKAGE },
 	{ "\\language_global_options", LyXRC::RC_LANGUAGE_GLOBAL_OPTIONS },
 	{ "\\language_package_selection", LyXRC::RC_LANGUAGE_PACKAGE_SELECTION },
+	{ "\\latex_export_threads", LyXRC::RC_LATEX_EXPORT_THREADS },
 	{ "\\load_session", LyXRC::RC_LOADSESSION },
 	{ "\\mac_dontswap_ctrl_meta", LyXRC::RC_MAC_DONTSWAP_CTRL_META },
 	{ "\\mac_like_cursor_movement", LyXRC::RC_MAC_LIKE_CURSOR_MOVEMENT },
@@ -1036,6 +1037,11 @@ LyXRC::ReturnValues LyXRC::read(Lexer & lexrc, bool check_format)
 			lexrc >> path_prefix;
 			break;
 
+		case RC_LATEX_EXPORT_THREADS:
+			lexrc >> latex_export_threads;
+			if (latex_export_threads == 0)
+				latex_export_threads = 1;
+			break;
 		case RC_USE_CONVERTER_CACHE:
 			lexrc >> use_converter_cache;
 			break;
@@ -1593,6 +1599,15 @@ void LyXRC::write(ostream & os, bool ignore_system_lyxrc, string const & name) c
 		if (tag != RC_LAST)
 			break;
 		// fall through
+	case RC_LATEX_EXPORT_THREADS:
+		if (ignore_system_lyxrc ||
+		    latex_export_threads != system_lyxrc.latex_export_threads) {
+			os << "\\latex_export_threads "
+			   << latex_export_threads << '\n';
+		}
+		if (tag != RC_LAST)
+			break;
+		// fall through
 	case RC_USE_CONVERTER_CACHE:
 		if (ignore_system_lyxrc ||
 		    use_converter_cache != system_lyxrc.use_converter_cache) {
@@ -3019,6 +3034,7 @@ void actOnUpdatedPrefs(LyXRC const & lyxrc_orig, LyXRC const & lyxrc_new)
 	case LyXRC::RC_LANGUAGE_GLOBAL_OPTIONS:
 	case LyXRC::RC_LANGUAGE_CUSTOM_PACKAGE:
 	case LyXRC::RC_LANGUAGE_PACKAGE_SELECTION:
+	case LyXRC::RC_LATEX_EXPORT_THREADS:
 	case LyXRC::RC_LYXRCFORMAT:
 	case LyXRC::RC_MAC_DONTSWAP_CTRL_META:
 	case LyXRC::RC_MAC_LIKE_CURSOR_MOVEMENT:
@@ -3342,6 +3358,10 @@ string const LyXRC::getDescription(LyXRCTags tag)
 		str = _("De-select if you don't want babel to be used when the language of the document is the default language.");
 		break;
 
+	case RC_LATEX_EXPORT_THREADS:
+		str = _("The number of threads used to generate the LaTeX code of large documents. Use 1 to disable parallel generation.");
+		break;
+
 	case RC_USELASTFILEPOS:
 		str = _("De-select if you do not want LyX to scroll to saved position.");
 		break;
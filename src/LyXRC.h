@@ -121,6 +121,7 @@ public:
 		RC_LANGUAGE_GLOBAL_OPTIONS,
 		RC_LANGUAGE_CUSTOM_PACKAGE,
 		RC_LANGUAGE_PACKAGE_SELECTION,
+		RC_LATEX_EXPORT_THREADS,
 		RC_LOADSESSION,
 		RC_LYXRCFORMAT,
 		RC_MACRO_EDIT_STYLE,
@@ -496,6 +497,10 @@ public:
 	 *  A '.' here stands for the current document directory.
 	 */
 	std::string texinputs_prefix = ".";
+	/** Number of threads used to generate the LaTeX body of a document.
+	 *  1 means serial generation.
+	 */
+	unsigned int latex_export_threads = 1;
 	/// Use the cache for file converters?
 	bool use_converter_cache = true;
 	/// Forbid use of external converters with 'needauth' option
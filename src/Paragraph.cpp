@@ -40,6 +40,7 @@
 #include "ParagraphParameters.h"
 #include "Session.h"
 #include "SpellChecker.h"
+#include "Statistics.h"
 #include "texstream.h"
 #include "TexRow.h"
 #include "Text.h"
@@ -499,10 +500,13 @@ public:
 	///
 	TextContainer text_;
 
-	typedef set<docstring> Words;
-	typedef map<string, Words> LangWordsMap;
+	/// The interned words of the paragraph with their languages,
+	/// without duplicates and grouped by language
+	typedef vector<pair<Language const *, docstring const *>> Words;
 	///
-	LangWordsMap words_;
+	Words words_;
+	/// The cached counts of Statistics, see statisticsCache()
+	ParagraphStatistics stats_;
 	///
 	Layout const * layout_;
 	///
@@ -537,6 +541,8 @@ Paragraph::Private::Private(Private const & p, Paragraph * owner)
 	  begin_of_body_(p.begin_of_body_), text_(p.text_), words_(p.words_),
 	  layout_(p.layout_), id_(make_id())
 {
+	for (auto const & word : words_)
+		acquireWord(word.second);
 	requestSpellCheck(p.text_.size());
 }
 
@@ -549,6 +555,8 @@ Paragraph::Private::Private(Private const & p, Paragraph * owner,
 	  begin_of_body_(p.begin_of_body_), words_(p.words_),
 	  layout_(p.layout_), id_(make_id())
 {
+	for (auto const & word : words_)
+		acquireWord(word.second);
 	if (beg >= pos_type(p.text_.size()))
 		return;
 	text_ = p.text_.substr(beg, end - beg);
@@ -681,6 +689,7 @@ void Paragraph::setChange(Change const & change)
 {
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	// beware of the imaginary end-of-par character!
 	d->changes_.set(change, 0, size() + 1);
@@ -710,6 +719,7 @@ void Paragraph::setChange(pos_type pos, Change const & change)
 {
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	LASSERT(pos >= 0 && pos <= size(), return);
 	d->changes_.set(change, pos);
@@ -732,6 +742,7 @@ void Paragraph::acceptChanges(pos_type start, pos_type end)
 {
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	LASSERT(start >= 0 && start <= size(), return);
 	LASSERT(end > start && end <= size() + 1, return);
@@ -772,6 +783,7 @@ void Paragraph::rejectChanges(pos_type start, pos_type end)
 
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	for (pos_type pos = start; pos < end; ++pos) {
 		switch (lookupChange(pos).type) {
@@ -810,6 +822,8 @@ void Paragraph::Private::insertChar(pos_type pos, char_type c,
 
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*owner_);
+	// The counts of Statistics change as well
+	stats_.valid = false;
 
 	// track change
 	changes_.insert(change, pos);
@@ -850,6 +864,7 @@ bool Paragraph::insertInset(pos_type pos, Inset * inset,
 
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	// Paragraph::insertInset() can be used in cut/copy/paste operation where
 	// d->inset_owner_ is not set yet.
@@ -875,6 +890,7 @@ bool Paragraph::eraseChar(pos_type pos, bool trackChanges)
 
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	// keep the logic here in sync with the logic of isMergedOnEndOfParDeletion()
 
@@ -1880,6 +1896,7 @@ void Paragraph::appendChar(char_type c, Font const & font,
 {
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	// track change
 	d->changes_.insert(change, d->text_.size());
@@ -1895,6 +1912,7 @@ void Paragraph::appendString(docstring const & s, Font const & font,
 {
 	// Make sure that Buffer::hasChangesPresent is updated
 	ChangesMonitor cm(*this);
+	d->stats_.valid = false;
 
 	pos_type end = s.size();
 	size_t oldsize = d->text_.size();
@@ -4928,15 +4946,17 @@ bool Paragraph::isSeparator(pos_type pos) const
 
 void Paragraph::deregisterWords()
 {
-	Private::LangWordsMap::const_iterator itl = d->words_.begin();
-	Private::LangWordsMap::const_iterator ite = d->words_.end();
-	for (; itl != ite; ++itl) {
-		WordList & wl = theWordList(itl->first);
-		Private::Words::const_iterator it = (itl->second).begin();
-		Private::Words::const_iterator et = (itl->second).end();
-		for (; it != et; ++it)
-			wl.remove(*it);
+	Language const * lang = nullptr;
+	WordList * wl = nullptr;
+	for (auto const & word : d->words_) {
+		if (word.first != lang) {
+			lang = word.first;
+			wl = &theWordList(lang->lang());
+		}
+		wl->remove(word.second);
+		releaseWord(word.second);
 	}
+	// keep the capacity for the next collectWords()
 	d->words_.clear();
 }
 
@@ -4980,6 +5000,9 @@ void Paragraph::locateWord(pos_type & from, pos_type & to,
 
 void Paragraph::collectWords()
 {
+	docstring word;
+	// Lock the shared word pool only once for all words
+	WordInterner interner;
 	for (pos_type pos = 0; pos < size(); ++pos) {
 		if (isWordSeparator(pos))
 			continue;
@@ -4998,28 +5021,59 @@ void Paragraph::collectWords()
 			continue;
 		FontList::const_iterator cit = d->fontlist_.fontIterator(from);
 		if (cit == d->fontlist_.end())
-			return;
+			break;
 		Language const * lang = cit->font().language();
-		docstring const word = asString(from, pos, AS_STR_NONE);
-		d->words_[lang->lang()].insert(word);
+		// Same as asString(from, pos, AS_STR_NONE), but reusing the
+		// buffer. Interning does not allocate for known words.
+		word.clear();
+		for (pos_type i = from; i < pos; ++i) {
+			char_type const c = d->text_[i];
+			if (isPrintable(c) || c == '\t')
+				word += c;
+		}
+		d->words_.push_back(make_pair(lang, interner.intern(word)));
+	}
+	// Interned words are equal iff their addresses are
+	sort(d->words_.begin(), d->words_.end(),
+	     [](Private::Words::value_type const & a,
+	        Private::Words::value_type const & b) {
+		     less<void const *> const lt;
+		     if (a.first != b.first)
+			     return lt(a.first, b.first);
+		     return lt(a.second, b.second);
+	     });
+	// Remove the duplicates, giving back their references
+	Private::Words::iterator out = d->words_.begin();
+	for (auto const & word : d->words_) {
+		if (out != d->words_.begin() && *(out - 1) == word)
+			releaseWord(word.second);
+		else
+			*out++ = word;
 	}
+	d->words_.erase(out, d->words_.end());
 }
 
 
 void Paragraph::registerWords()
 {
-	Private::LangWordsMap::const_iterator itl = d->words_.begin();
-	Private::LangWordsMap::const_iterator ite = d->words_.end();
-	for (; itl != ite; ++itl) {
-		WordList & wl = theWordList(itl->first);
-		Private::Words::const_iterator it = (itl->second).begin();
-		Private::Words::const_iterator et = (itl->second).end();
-		for (; it != et; ++it)
-			wl.insert(*it);
+	Language const * lang = nullptr;
+	WordList * wl = nullptr;
+	for (auto const & word : d->words_) {
+		if (word.first != lang) {
+			lang = word.first;
+			wl = &theWordList(lang->lang());
+		}
+		wl->insert(word.second);
 	}
 }
 
 
+ParagraphStatistics & Paragraph::statisticsCache() const
+{
+	return d->stats_;
+}
+
+
 void Paragraph::updateWords()
 {
 	deregisterWords();
@@ -5240,6 +5294,7 @@ SpellChecker::Result Paragraph::spellCheck(pos_type & from, pos_type & to,
 
 void Paragraph::anonymize()
 {
+	d->stats_.valid = false;
 	// This is a very crude anonymization for now
 	for (char_type & c : d->text_)
 		if (isLetterChar(c) || isNumber(c))
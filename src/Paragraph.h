@@ -45,6 +45,7 @@ class Layout;
 class Font;
 class OutputParams;
 class ParagraphParameters;
+struct ParagraphStatistics;
 class TocBackend;
 class WordLangTuple;
 class XMLStream;
@@ -489,6 +490,9 @@ public:
 		word_location const loc, bool const ignore_deleted = false) const;
 	///
 	void updateWords();
+	/// The counts of Statistics for this paragraph. They are
+	/// invalidated whenever the contents of the paragraph change.
+	ParagraphStatistics & statisticsCache() const;
 
 	/// Spellcheck word at position \p from and fill in found misspelled word
 	/// and \p suggestions if \p do_suggestion is true.
@@ -18,6 +18,8 @@
 #include "Text.h"
 #include "Cursor.h"
 
+#include "LyXRC.h"
+
 #include "support/lassert.h"
 #include "support/debug.h"
 #include "support/lstrings.h"
@@ -28,6 +30,24 @@ namespace lyx {
 
 using namespace support;
 
+namespace {
+
+/// Changes whenever settings that influence the counts of a paragraph
+/// change. The cached counts of all paragraphs are outdated then.
+int generation()
+{
+	static int generation = 0;
+	static docstring esc_chars;
+	// The escape chars of the spell checker are no word separators
+	if (esc_chars != lyxrc.spellchecker_esc_chars) {
+		esc_chars = lyxrc.spellchecker_esc_chars;
+		++generation;
+	}
+	return generation;
+}
+
+} // namespace
+
 
 void Statistics::update(CursorData const & cur, bool skip)
 {
@@ -94,26 +114,73 @@ void Statistics::update(Paragraph const & par, pos_type from, pos_type to)
 {
 	if (to == -1)
 		to = par.size();
+	if (from != 0 || to != par.size()) {
+		count(par, from, to, nullptr);
+		return;
+	}
+
+	// Only paragraphs that changed since the last time are counted again
+	ParagraphStatistics & cache = par.statisticsCache();
+	if (cache.valid && cache.skip_no_output == skip_no_output_
+	    && cache.generation == generation() && add(cache))
+		return;
+	count(par, 0, to, &cache);
+}
+
+
+void Statistics::count(Paragraph const & par, pos_type from, pos_type to,
+                       ParagraphStatistics * cache)
+{
+	// The counts before, and the counts of the insets, to find out
+	// what the paragraph itself contributes
+	Statistics const before = *this;
+	int inset_words = 0;
+	int inset_chars = 0;
+	int inset_blanks = 0;
+	bool first = true;
+	if (cache) {
+		cache->insets.clear();
+		cache->starts_word = false;
+	}
 
 	for (pos_type pos = from ; pos < to ; ++pos) {
 		Inset const * ins = par.isInset(pos) ? par.getInset(pos) : nullptr;
 		// Stuff that we skip
 		if (par.isDeleted(pos))
 			continue;
-		if (ins && skip_no_output_ && !ins->producesOutput())
+		if (ins && skip_no_output_ && !ins->producesOutput()) {
+			if (cache)
+				cache->insets.push_back({ins, ins->isLetter(), false,
+				                         inword_, inword_});
 			continue;
+		}
 
 		// words
-		if (par.isWordSeparator(pos))
+		bool const separator = par.isWordSeparator(pos);
+		if (first) {
+			if (cache)
+				cache->starts_word = !separator;
+			first = false;
+		}
+		if (separator)
 			inword_ = false;
 		else if (!inword_) {
 			++word_count;
 			inword_ = true;
 		}
 
-		if (ins)
+		if (ins) {
+			ParagraphStatistics::InsetEntry entry = {
+				ins, ins->isLetter(), true, inword_, false };
+			Statistics const outside = *this;
 			ins->updateStatistics(*this);
-		else {
+			inset_words += word_count - outside.word_count;
+			inset_chars += char_count - outside.char_count;
+			inset_blanks += blank_count - outside.blank_count;
+			entry.inword_after = inword_;
+			if (cache)
+				cache->insets.push_back(entry);
+		} else {
 			char_type const c = par.getChar(pos);
 			if (isPrintableNonspace(c))
 				++char_count;
@@ -121,9 +188,51 @@ void Statistics::update(Paragraph const & par, pos_type from, pos_type to)
 				++blank_count;
 		}
 	}
+
+	if (cache) {
+		// The first word was not counted if we were inside a word
+		bool const continued = before.inword_ && cache->starts_word;
+		cache->word_count = word_count - before.word_count - inset_words
+			+ (continued ? 1 : 0);
+		cache->char_count = char_count - before.char_count - inset_chars;
+		cache->blank_count = blank_count - before.blank_count - inset_blanks;
+		cache->skip_no_output = skip_no_output_;
+		cache->generation = generation();
+		cache->valid = true;
+	}
 	inword_ = false;
 }
 
 
+bool Statistics::add(ParagraphStatistics const & cache)
+{
+	// Insets can change without changing the paragraph
+	for (auto const & entry : cache.insets)
+		if (entry.inset->isLetter() != entry.letter
+		    || (skip_no_output_
+		        && entry.inset->producesOutput() != entry.counted))
+			return false;
+
+	Statistics result = *this;
+	if (result.inword_ && cache.starts_word)
+		--result.word_count;
+	result.word_count += cache.word_count;
+	result.char_count += cache.char_count;
+	result.blank_count += cache.blank_count;
+	// The contents of the insets have their own caches
+	for (auto const & entry : cache.insets) {
+		if (!entry.counted)
+			continue;
+		result.inword_ = entry.inword_before;
+		entry.inset->updateStatistics(result);
+		if (result.inword_ != entry.inword_after)
+			return false;
+	}
+	result.inword_ = false;
+	*this = result;
+	return true;
+}
+
+
 } // namespace lyx
 
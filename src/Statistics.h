@@ -15,13 +15,53 @@
 #include "support/docstring.h"
 #include "support/types.h"
 
+#include <vector>
+
 namespace lyx {
 
 class CursorData;
 class CursorSlice;
+class Inset;
 class Text;
 class Paragraph;
 
+
+/// The counts of a paragraph itself, without the insets it contains.
+/// Every paragraph keeps one of these, see Paragraph::statisticsCache(),
+/// and invalidates it when its contents change.
+struct ParagraphStatistics {
+	/// An inset of the paragraph, and the state when it was counted
+	struct InsetEntry {
+		///
+		Inset const * inset;
+		/// Was it a letter?
+		bool letter;
+		/// Was it counted (see Statistics::skip_no_output_)?
+		bool counted;
+		/// Were we inside a word before it was counted...
+		bool inword_before;
+		/// ...and after?
+		bool inword_after;
+	};
+	///
+	bool valid = false;
+	/// The settings the counts are valid for
+	bool skip_no_output = false;
+	///
+	int generation = 0;
+	/// The number of words, if the paragraph does not continue a word
+	int word_count = 0;
+	///
+	int char_count = 0;
+	///
+	int blank_count = 0;
+	/// Does the first counted position start a word?
+	bool starts_word = false;
+	/// The insets, in the order of their positions
+	std::vector<InsetEntry> insets;
+};
+
+
 // Class used to compute letters/words statistics on buffer or selection
 class Statistics {
 public:
@@ -51,8 +91,15 @@ private:
 	 * \param from: starting position
 	 * \param to: end position. If it is equal to -1, then the end is
 	 *    the end of the paragraph.
+	 * Whole paragraphs are counted using their cached counts.
 	 */
 	void update(Paragraph const & par, pos_type from = 0, pos_type to = -1);
+	/// Count chars and words between two positions of a paragraph,
+	/// and fill \p cache if it is not null
+	void count(Paragraph const & par, pos_type from, pos_type to,
+	           ParagraphStatistics * cache);
+	/// Add the counts of \p cache, or return false if it is outdated
+	bool add(ParagraphStatistics const & cache);
 
 	// Indicate whether parts that produce no output should be counted.
 	bool skip_no_output_ = false;
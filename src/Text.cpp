@@ -448,8 +448,13 @@ void Text::readParToken(Paragraph & par, Lexer & lex,
 		// When we apply an unknown layout to a document, we add this layout to the textclass
 		// of this document. For example, when you apply class article to a beamer document,
 		// all unknown layouts such as frame will be added to document class article so that
-		// these layouts can keep their original names.
-		bool const added_one = tclass.addLayoutIfNeeded(layoutname);
+		// these layouts can keep their original names. A class that
+		// other documents share is not modified, this document gets its
+		// own copy instead. The paragraphs read so far are switched to it
+		// by Buffer::readDocument().
+		if (!tclass.hasLayout(layoutname))
+			bp.unshareDocumentClass();
+		bool const added_one = bp.documentClass().addLayoutIfNeeded(layoutname);
 		if (added_one) {
 			// Warn the user.
 			docstring const s = bformat(_("Layout `%1$s' was not found."), layoutname);
@@ -27,18 +27,29 @@
 #include "frontends/alert.h"
 
 #include "support/lassert.h"
+#include "support/checksum.h"
+#include "support/convert.h"
 #include "support/debug.h"
 #include "support/FileName.h"
 #include "support/filetools.h"
 #include "support/gettext.h"
 #include "support/Lexer.h"
 #include "support/lstrings.h"
+#include "support/mutex.h"
 #include "support/os.h"
+#include "support/Package.h"
 #include "support/TempFile.h"
 
+#include <QRunnable>
+#include <QThreadPool>
+
 #include <algorithm>
+#include <ctime>
 #include <fstream>
+#include <iomanip>
+#include <map>
 #include <sstream>
+#include <tuple>
 
 #ifdef ERROR
 #undef ERROR
@@ -284,12 +295,133 @@ LexerKeyword textClassTags[] = {
 	{ "tocdepth",          TC_TOCDEPTH }
 };
 
+
+// The layout files converted by layout2layout.py are kept in a cache in
+// the user directory, so that the conversion only runs once per file.
+// The first line of a cached file is a comment that records the
+// checksum of the original file.
+
+string const layout_cache_header = "# LyX layout cache ";
+
+
+FileName layoutCacheFile(FileName const & filename)
+{
+	if (package().user_support().empty())
+		return FileName();
+	FileName const dir(addName(package().user_support().absFileName(), "layoutcache"));
+	if (!dir.exists() && !dir.createDirectory(0700)) {
+		LYXERR(Debug::TCLASS, "Could not create layout cache directory " << dir);
+		return FileName();
+	}
+	ostringstream os;
+	os << setw(10) << setfill('0') << checksum(filename.absFileName())
+	   << '_' << LAYOUT_FORMAT << ".layout";
+	return FileName(addName(dir.absFileName(), os.str()));
+}
+
+
+/// Makes sure that \p cache contains the conversion of \p filename to
+/// LAYOUT_FORMAT. \return false if the conversion failed.
+bool updateLayoutCache(FileName const & filename, FileName const & cache)
+{
+	string const header = layout_cache_header
+		+ convert<string>(filename.checksum());
+	{
+		ifstream is(cache.toFilesystemEncoding().c_str());
+		string line;
+		if (getline(is, line) && line == header) {
+			LYXERR(Debug::TCLASS, "Using cached conversion of " << filename);
+			return true;
+		}
+	}
+
+	TempFile tmp("convertXXXXXX.layout");
+	FileName const tempfile = tmp.name();
+	if (!layout2layout(filename, tempfile))
+		return false;
+
+	// Write to a temporary file first, so that a cache file is always
+	// complete
+	FileName const cache_tmp(cache.absFileName() + ".tmp");
+	{
+		ifstream is(tempfile.toFilesystemEncoding().c_str());
+		ofstream os(cache_tmp.toFilesystemEncoding().c_str());
+		os << header << '\n' << is.rdbuf();
+		if (!is || !os)
+			return false;
+	}
+	if (!cache_tmp.moveTo(cache)) {
+		LYXERR(Debug::TCLASS, "Could not write layout cache " << cache);
+		cache_tmp.removeFile();
+		return false;
+	}
+	return true;
+}
+
+
+/// Is \p filename in a format different from LAYOUT_FORMAT?
+bool needsConversion(FileName const & filename)
+{
+	Lexer lexrc(textClassTags);
+	lexrc.setFile(filename);
+	return !lexrc.isOK() || lexrc.lex() != TC_FORMAT || !lexrc.next()
+		|| lexrc.getInteger() != LAYOUT_FORMAT;
+}
+
+
+/// Fills the layout cache for a file in a thread of the pool
+class LayoutCacheUpdater : public QRunnable
+{
+public:
+	///
+	explicit LayoutCacheUpdater(FileName const & filename)
+		: filename_(filename) {}
+	///
+	void run() override
+	{
+		FileName const cache = layoutCacheFile(filename_);
+		if (!cache.empty())
+			updateLayoutCache(filename_, cache);
+	}
+private:
+	///
+	FileName const filename_;
+};
+
+
+/// Converts in parallel the files of \p files that need it, so that
+/// reading them later only uses the layout cache.
+void prefetchConversions(vector<FileName> const & files)
+{
+	vector<FileName> todo;
+	for (FileName const & f : files)
+		if (!f.empty() && needsConversion(f))
+			todo.push_back(f);
+	if (todo.size() < 2)
+		// No need for threads
+		return;
+
+	LYXERR(Debug::TCLASS, "Converting " << todo.size() << " layout files in parallel");
+	QThreadPool pool;
+	for (FileName const & f : todo)
+		// the pool takes ownership
+		pool.start(new LayoutCacheUpdater(f));
+	pool.waitForDone();
+}
+
 } // namespace
 
 
-bool TextClass::convertLayoutFormat(support::FileName const & filename, ReadType rt)
+bool TextClass::convertLayoutFormat(support::FileName const & filename,
+                                    ReadType rt, bool use_cache)
 {
 	LYXERR(Debug::TCLASS, "Converting layout file to " << LAYOUT_FORMAT);
+	if (use_cache) {
+		FileName const cache = layoutCacheFile(filename);
+		if (!cache.empty())
+			return updateLayoutCache(filename, cache)
+				&& readWithoutConv(cache, rt) == OK;
+	}
 	TempFile tmp("convertXXXXXX.layout");
 	FileName const tempfile = tmp.name();
 	bool success = layout2layout(filename, tempfile);
@@ -357,7 +489,7 @@ bool TextClass::read(FileName const & filename, ReadType rt)
 	if (retval != FORMAT_MISMATCH)
 		return retval == OK;
 
-	bool const worx = convertLayoutFormat(filename, rt);
+	bool const worx = convertLayoutFormat(filename, rt, true);
 	if (!worx)
 		LYXERR0 ("Unable to convert " << filename <<
 			" to format " << LAYOUT_FORMAT);
@@ -1969,12 +2101,69 @@ Layout TextClass::createBasicLayout(docstring const & name, bool unknown) const
 }
 
 
-DocumentClassPtr getDocumentClass(LayoutFile const & baseClass, LayoutModuleList const & modlist,
-		string const & cengine, bool clone, bool internal)
+namespace {
+
+/// The document classes made by getDocumentClass() in this session.
+/// Building a document class means reading all the module files, and
+/// the same combination is usually requested many times (each buffer,
+/// each change of the document settings, each clone).
+struct DocumentClassCache
+{
+	/// What a document class is made of
+	struct Key {
+		///
+		LayoutFile const * base;
+		///
+		bool base_loaded;
+		/// the module and cite engine files, with their modification time
+		vector<pair<string, time_t>> files;
+		///
+		string cengine;
+		///
+		bool operator<(Key const & k) const
+		{
+			return tie(base, base_loaded, files, cengine)
+				< tie(k.base, k.base_loaded, k.files, k.cengine);
+		}
+	};
+	///
+	map<Key, DocumentClassConstPtr> classes;
+	///
+	Mutex mutex;
+};
+
+
+DocumentClassCache & documentClassCache()
+{
+	static DocumentClassCache cache;
+	return cache;
+}
+
+
+void clearSharedDocumentClasses();
+
+} // namespace
+
+
+void clearDocumentClassCache()
+{
+	DocumentClassCache & dcc = documentClassCache();
+	Mutex::Locker lock(&dcc.mutex);
+	dcc.classes.clear();
+	clearSharedDocumentClasses();
+}
+
+
+namespace {
+
+/// Find the module and cite engine files of a document class, and make
+/// the key under which the class is cached. \p modfiles gets the module
+/// files with the module names for error messages.
+DocumentClassCache::Key classKey(LayoutFile const & baseClass,
+		LayoutModuleList const & modlist, string const & cengine,
+		bool show_warnings, vector<pair<FileName, string>> & modfiles,
+		FileName & cengine_file)
 {
-	bool const show_warnings = !clone && !internal;
-	DocumentClassPtr doc_class =
-	    DocumentClassPtr(new DocumentClass(baseClass));
 	for (auto const & mod : modlist) {
 		LyXModule * lm = theModuleList[mod];
 		if (!lm) {
@@ -2000,51 +2189,227 @@ DocumentClassPtr getDocumentClass(LayoutFile const & baseClass, LayoutModuleList
 				from_utf8(mod), prereqs);
 			frontend::Alert::warning(_("Package not available"), msg, true);
 		}
-		FileName layout_file = libFileSearch("layouts", lm->getFilename());
-		if (!doc_class->read(layout_file, TextClass::MODULE)) {
+		modfiles.push_back(make_pair(libFileSearch("layouts", lm->getFilename()), mod));
+	}
+
+	if (!cengine.empty()) {
+		LyXCiteEngine * ce = theCiteEnginesList[cengine];
+		if (!ce) {
+			if (show_warnings) {
+				docstring const msg =
+					bformat(_("The cite engine %1$s has been requested by\n"
+					"this document but has not been found in the list of\n"
+					"available engines. If you recently installed it, you\n"
+					"probably need to reconfigure LyX.\n"), from_utf8(cengine));
+				frontend::Alert::warning(_("Cite Engine not available"), msg);
+			}
+		} else if (!ce->isAvailable() && show_warnings) {
+			docstring const prereqs = from_utf8(getStringFromVector(ce->prerequisites(), "\n\t"));
 			docstring const msg =
-				bformat(_("Error reading module %1$s\n"), from_utf8(mod));
-			frontend::Alert::warning(_("Read Error"), msg);
+				bformat(_("The cite engine %1$s requires a package that is not\n"
+					"available in your LaTeX installation, or a converter that\n"
+					"you have not installed. LaTeX output may not be possible.\n"
+					"Missing prerequisites:\n"
+						"\t%2$s\n"
+					"See section 3.1.2.3 (Modules) of the User's Guide for more information."),
+				from_utf8(cengine), prereqs);
+			frontend::Alert::warning(_("Package not available"), msg, true);
+		} else
+			cengine_file = libFileSearch("citeengines", ce->getFilename());
+	}
+
+	DocumentClassCache::Key key;
+	key.base = &baseClass;
+	key.base_loaded = baseClass.loaded();
+	for (auto const & mf : modfiles)
+		key.files.push_back(make_pair(mf.first.absFileName(),
+		                              mf.first.lastModified()));
+	if (!cengine_file.empty()) {
+		key.cengine = cengine;
+		key.files.push_back(make_pair(cengine_file.absFileName(),
+		                              cengine_file.lastModified()));
+	}
+	return key;
+}
+
+} // namespace
+
+
+DocumentClassPtr getDocumentClass(LayoutFile const & baseClass, LayoutModuleList const & modlist,
+		string const & cengine, bool clone, bool internal)
+{
+	vector<pair<FileName, string>> modfiles;
+	FileName cengine_file;
+	DocumentClassCache::Key const key = classKey(baseClass, modlist, cengine,
+		!clone && !internal, modfiles, cengine_file);
+
+	// Reuse the class made earlier from the same files
+	DocumentClassCache & dcc = documentClassCache();
+	{
+		Mutex::Locker lock(&dcc.mutex);
+		auto const it = dcc.classes.find(key);
+		if (it != dcc.classes.end()) {
+			LYXERR(Debug::TCLASS, "Reusing document class " << baseClass.name());
+			return DocumentClassPtr(new DocumentClass(*it->second));
 		}
 	}
 
-	if (cengine.empty())
-		return doc_class;
+	// Old format files are converted by a python script. Do this for
+	// all of them at once.
+	vector<FileName> files;
+	for (auto const & mf : modfiles)
+		files.push_back(mf.first);
+	if (!cengine_file.empty())
+		files.push_back(cengine_file);
+	prefetchConversions(files);
 
-	LyXCiteEngine * ce = theCiteEnginesList[cengine];
-	if (!ce) {
-		if (show_warnings) {
+	DocumentClassPtr doc_class =
+	    DocumentClassPtr(new DocumentClass(baseClass));
+	bool success = true;
+	for (auto const & mf : modfiles) {
+		if (!doc_class->read(mf.first, TextClass::MODULE)) {
 			docstring const msg =
-				bformat(_("The cite engine %1$s has been requested by\n"
-				"this document but has not been found in the list of\n"
-				"available engines. If you recently installed it, you\n"
-				"probably need to reconfigure LyX.\n"), from_utf8(cengine));
-			frontend::Alert::warning(_("Cite Engine not available"), msg);
+				bformat(_("Error reading module %1$s\n"), from_utf8(mf.second));
+			frontend::Alert::warning(_("Read Error"), msg);
+			success = false;
 		}
-	} else if (!ce->isAvailable() && show_warnings) {
-		docstring const prereqs = from_utf8(getStringFromVector(ce->prerequisites(), "\n\t"));
+	}
+
+	if (!cengine_file.empty()
+	    && !doc_class->read(cengine_file, TextClass::CITE_ENGINE)) {
 		docstring const msg =
-			bformat(_("The cite engine %1$s requires a package that is not\n"
-				"available in your LaTeX installation, or a converter that\n"
-				"you have not installed. LaTeX output may not be possible.\n"
-				"Missing prerequisites:\n"
-					"\t%2$s\n"
-				"See section 3.1.2.3 (Modules) of the User's Guide for more information."),
-			from_utf8(cengine), prereqs);
-		frontend::Alert::warning(_("Package not available"), msg, true);
-	} else {
-		FileName layout_file = libFileSearch("citeengines", ce->getFilename());
-		if (!doc_class->read(layout_file, TextClass::CITE_ENGINE)) {
-			docstring const msg =
-				bformat(_("Error reading cite engine %1$s\n"), from_utf8(cengine));
-			frontend::Alert::warning(_("Read Error"), msg);
+			bformat(_("Error reading cite engine %1$s\n"), from_utf8(cengine));
+		frontend::Alert::warning(_("Read Error"), msg);
+		success = false;
+	}
+
+	if (success) {
+		Mutex::Locker lock(&dcc.mutex);
+		dcc.classes[key] = DocumentClassConstPtr(new DocumentClass(*doc_class));
+	}
+	return doc_class;
+}
+
+
+namespace {
+
+/// The document classes that are currently used by documents. Documents
+/// with the same base class, modules, cite engine and local layout use
+/// the same DocumentClass object, which is only referenced here, so that
+/// it goes away with the last document that uses it.
+struct SharedDocumentClasses
+{
+	///
+	struct Key {
+		///
+		DocumentClassCache::Key files;
+		/// the local layouts, in reading order
+		vector<string> local_layouts;
+		///
+		bool operator<(Key const & k) const
+		{
+			return tie(files, local_layouts) < tie(k.files, k.local_layouts);
+		}
+	};
+	///
+	struct Entry {
+		///
+		weak_ptr<DocumentClass const> dclass;
+		/// The number of layouts when the class was made. Unknown layouts
+		/// found in a document are only added to an unshared copy (see
+		/// BufferParams::unshareDocumentClass()), this is a safety net
+		/// against handing out a modified class.
+		size_t layouts;
+	};
+	///
+	map<Key, Entry> classes;
+	///
+	Mutex mutex;
+};
+
+
+SharedDocumentClasses & sharedDocumentClasses()
+{
+	static SharedDocumentClasses shared;
+	return shared;
+}
+
+
+void clearSharedDocumentClasses()
+{
+	SharedDocumentClasses & sdc = sharedDocumentClasses();
+	Mutex::Locker lock(&sdc.mutex);
+	sdc.classes.clear();
+}
+
+} // namespace
+
+
+DocumentClassConstPtr getSharedDocumentClass(LayoutFile const & baseClass,
+		LayoutModuleList const & modlist, string const & cengine,
+		vector<string> const & local_layouts, bool internal, bool & local_ok)
+{
+	SharedDocumentClasses::Key key;
+	vector<pair<FileName, string>> modfiles;
+	FileName cengine_file;
+	key.files = classKey(baseClass, modlist, cengine, !internal,
+	                     modfiles, cengine_file);
+	for (string const & ll : local_layouts)
+		if (!ll.empty())
+			key.local_layouts.push_back(ll);
+
+	SharedDocumentClasses & sdc = sharedDocumentClasses();
+	{
+		Mutex::Locker lock(&sdc.mutex);
+		auto const it = sdc.classes.find(key);
+		if (it != sdc.classes.end()) {
+			DocumentClassConstPtr const dc = it->second.dclass.lock();
+			if (dc && dc->layoutCount() == it->second.layouts) {
+				LYXERR(Debug::TCLASS, "Sharing document class " << baseClass.name());
+				local_ok = true;
+				return dc;
+			}
+			sdc.classes.erase(it);
 		}
 	}
 
+	// The warnings have been given above already
+	DocumentClassPtr doc_class =
+		getDocumentClass(baseClass, modlist, cengine, false, true);
+	local_ok = true;
+	for (string const & ll : key.local_layouts) {
+		TextClass::ReturnValues const ret = doc_class->read(ll, TextClass::MODULE);
+		if (ret != TextClass::OK && ret != TextClass::OK_OLDFORMAT) {
+			local_ok = false;
+			break;
+		}
+	}
+	// Do not let other documents inherit the errors
+	if (!local_ok)
+		return doc_class;
+
+	Mutex::Locker lock(&sdc.mutex);
+	// Drop the classes that are not used anymore
+	for (auto it = sdc.classes.begin(); it != sdc.classes.end();) {
+		if (it->second.dclass.expired())
+			it = sdc.classes.erase(it);
+		else
+			++it;
+	}
+	doc_class->shared_ = true;
+	sdc.classes[key] = { doc_class, doc_class->layoutCount() };
 	return doc_class;
 }
 
 
+DocumentClassPtr copyDocumentClass(DocumentClass const & dclass)
+{
+	DocumentClassPtr copy(new DocumentClass(dclass));
+	copy->shared_ = false;
+	return copy;
+}
+
+
 /////////////////////////////////////////////////////////////////////////
 //
 // DocumentClass
@@ -387,8 +387,11 @@ private:
 	bool deleteLayout(docstring const &);
 	///
 	bool deleteInsetLayout(docstring const &);
-	///
-	bool convertLayoutFormat(support::FileName const &, ReadType);
+	/// Converts the file with layout2layout.py and reads the result.
+	/// If \p use_cache is true, the conversion is kept in the layout
+	/// cache of the user directory.
+	bool convertLayoutFormat(support::FileName const &, ReadType,
+	                         bool use_cache = false);
 	/// Reads the layout file without running layout2layout.
 	ReturnValues readWithoutConv(support::FileName const & filename, ReadType rt);
 	/// \return true for success.
@@ -448,8 +451,12 @@ public:
 	/// happen).  -- Idea JMarc, comment MV
 	InsetLayout const & insetLayout(docstring const & name) const;
 	/// add a new layout \c name if it does not exist in layoutlist_
-	/// \return whether we had to add one.
+	/// \return whether we had to add one. This must not be called for a
+	/// shared class, see BufferParams::unshareDocumentClass().
 	bool addLayoutIfNeeded(docstring const & name) const;
+	/// Whether several documents may use this class, see
+	/// getSharedDocumentClass().
+	bool isShared() const { return shared_; }
 	/// Forced layouts in layout file syntax
 	std::string forcedLayouts() const;
 
@@ -572,6 +579,16 @@ private:
 		getDocumentClass(LayoutFile const &, LayoutModuleList const &,
 				 std::string const &,
 				 bool clone, bool internal);
+	///
+	friend DocumentClassConstPtr
+		getSharedDocumentClass(LayoutFile const &, LayoutModuleList const &,
+				       std::string const &,
+				       std::vector<std::string> const &,
+				       bool internal, bool & local_ok);
+	///
+	friend DocumentClassPtr copyDocumentClass(DocumentClass const &);
+	///
+	bool shared_ = false;
 };
 
 
@@ -584,6 +601,24 @@ DocumentClassPtr getDocumentClass(LayoutFile const & baseClass,
 			std::string const & cengine = std::string(),
 			bool clone = false, bool internal = false);
 
+/// Get the document class with the local layouts \p local_layouts read
+/// in addition. Documents that ask for the same class, modules, cite engine
+/// and local layouts share the returned object, which must therefore not
+/// be modified (see BufferParams::unshareDocumentClass()). \p local_ok
+/// tells whether the local layouts could be read.
+DocumentClassConstPtr getSharedDocumentClass(LayoutFile const & baseClass,
+			LayoutModuleList const & modlist,
+			std::string const & cengine,
+			std::vector<std::string> const & local_layouts,
+			bool internal, bool & local_ok);
+
+/// Make a copy of \p dclass that is not shared with other documents.
+DocumentClassPtr copyDocumentClass(DocumentClass const & dclass);
+
+/// Forget the document classes made by getDocumentClass(). This is
+/// needed when layout files are reloaded.
+void clearDocumentClassCache();
+
 /// convert page sides option to text 1 or 2
 std::ostream & operator<<(std::ostream & os, PageSides p);
 
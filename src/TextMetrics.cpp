@@ -164,6 +164,25 @@ void TextMetrics::setRowChanged(pit_type pit, pos_type pos)
 }
 
 
+void TextMetrics::setRowsChanged(int const y1, int const y2)
+{
+	for (auto & pm_pair : par_metrics_) {
+		ParagraphMetrics & pm = pm_pair.second;
+		if (!pm.hasPosition() || pm.bottom() <= y1 || pm.top() >= y2)
+			continue;
+		int y = pm.position();
+		for (size_t i = 0; i != pm.rows().size(); ++i) {
+			Row & row = pm.rows()[i];
+			if (i)
+				y += row.ascent();
+			if (y + row.descent() > y1 && y - row.ascent() < y2)
+				row.changed(true);
+			y += row.descent();
+		}
+	}
+}
+
+
 Dimension const & TextMetrics::dim(pit_type pit) const
 {
 	auto pmc_it = par_metrics_.find(pit);
@@ -489,6 +508,7 @@ bool TextMetrics::isRTLBoundary(pit_type pit, pos_type pos,
 
 bool TextMetrics::redoParagraph(pit_type const pit, bool const align_rows)
 {
+	LYXTRACE("TextMetrics::redoParagraph");
 	Paragraph const & par = text_->getPar(pit);
 	// This gets the dimension if it exists and an empty one otherwise.
 	Dimension old_dim = dim(pit);
@@ -64,6 +64,9 @@ public:
 	bool isFirstRow(Row const & row) const;
 	///
 	void setRowChanged(pit_type pit, pos_type pos);
+	/// Mark as changed all rows that intersect the vertical screen
+	/// range [\p y1, \p y2).
+	void setRowsChanged(int y1, int y2);
 
 	/// Dimension of the entire text.
 	Dimension const & dim() const { return dim_; }
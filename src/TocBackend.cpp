@@ -30,6 +30,8 @@
 #include "support/lassert.h"
 #include "support/lstrings.h"
 
+#include <algorithm>
+
 using namespace std;
 
 
@@ -81,6 +83,53 @@ FuncRequest TocItem::action() const
 }
 
 
+///////////////////////////////////////////////////////////////////////////
+//
+// TocIndex implementation
+//
+///////////////////////////////////////////////////////////////////////////
+
+TocIndex::TocIndex(Toc const & toc)
+	: toc_(&toc), size_(toc.size())
+{
+	for (size_t i = 0; i != toc.size(); ++i)
+		positions_[&toc[i].dit()[0].inset()].sorted.push_back(i);
+
+	for (auto & p : positions_) {
+		vector<size_t> & sorted = p.second.sorted;
+		stable_sort(sorted.begin(), sorted.end(),
+			[&toc](size_t i, size_t j) { return toc[i].dit() < toc[j].dit(); });
+		vector<size_t> & last = p.second.last;
+		last.reserve(sorted.size());
+		for (size_t i : sorted)
+			last.push_back(last.empty() ? i : max(last.back(), i));
+	}
+}
+
+
+Toc::const_iterator TocIndex::find(Toc const & toc, DocIterator const & dit) const
+{
+	LASSERT(isIndexOf(toc), return TocBackend::findItem(toc, dit));
+	if (toc.empty())
+		return toc.end();
+
+	DocIterator const dit_text = dit.getInnerText();
+	auto const pit = positions_.find(&dit_text[0].inset());
+	if (pit == positions_.end())
+		return toc.begin();
+
+	// The last item (in Toc order) that is not after dit_text. Like
+	// TocBackend::findItem(), we never return another item than begin()
+	// when nothing is found.
+	vector<size_t> const & sorted = pit->second.sorted;
+	auto const it = upper_bound(sorted.begin(), sorted.end(), dit_text,
+		[&toc](DocIterator const & d, size_t i) { return d < toc[i].dit(); });
+	if (it == sorted.begin())
+		return toc.begin();
+	return toc.begin() + pit->second.last[it - sorted.begin() - 1];
+}
+
+
 ///////////////////////////////////////////////////////////////////////////
 //
 // TocBackend implementation
@@ -215,6 +264,7 @@ void TocBackend::reset()
 	for (auto const & t: tocs_)
 		t.second->clear();
 	tocs_.clear();
+	indices_.clear();
 	builders_.clear();
 	resetOutlinerNames();
 }
@@ -238,7 +288,11 @@ Toc::const_iterator TocBackend::item(string const & type,
 	// Is the type supported?
 	// We will try to make the best of it in release mode
 	LASSERT(toclist_it != tocs_.end(), toclist_it = tocs_.begin());
-	return findItem(*toclist_it->second, dit);
+	Toc const & toc = *toclist_it->second;
+	TocIndex & index = indices_[toclist_it->first];
+	if (!index.isIndexOf(toc))
+		index = TocIndex(toc);
+	return index.find(toc, dit);
 }
 
 
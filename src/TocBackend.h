@@ -111,6 +111,40 @@ private:
 };
 
 
+/// Index of the positions of the items of a Toc. It allows finding the
+/// item before a document position without walking through the Toc.
+class TocIndex
+{
+public:
+	///
+	TocIndex() {}
+	/// The index becomes invalid when \p toc is changed.
+	explicit TocIndex(Toc const & toc);
+	/// Same as TocBackend::findItem(toc, dit), in logarithmic time.
+	Toc::const_iterator find(Toc const & toc, DocIterator const & dit) const;
+	/// Whether the index has been made for \p toc. Items are never removed
+	/// from a Toc, so the size tells whether it has changed.
+	bool isIndexOf(Toc const & toc) const
+	{
+		return toc_ == &toc && size_ == toc.size();
+	}
+private:
+	/// The items of one document
+	struct Positions {
+		/// the item numbers, sorted by position
+		std::vector<size_t> sorted;
+		/// the largest item number in sorted[0..i]
+		std::vector<size_t> last;
+	};
+	/// Positions of the items, by main text inset
+	std::map<Inset const *, Positions> positions_;
+	///
+	Toc const * toc_ = nullptr;
+	///
+	size_t size_ = 0;
+};
+
+
 /// Class to build and access the Tocs of a particular buffer.
 class TocBackend
 {
@@ -162,6 +196,8 @@ private:
 	void resetOutlinerNames();
 	///
 	TocList tocs_;
+	/// Indices of the Tocs, made when needed by item()
+	mutable std::map<std::string, TocIndex> indices_;
 	///
 	std::map<std::string, std::unique_ptr<TocBuilder>> builders_;
 	/// Stores localised outliner names from this buffer and its children
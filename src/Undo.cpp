@@ -570,12 +570,14 @@ void Undo::finishUndo()
 
 bool Undo::undoAction(CursorData & cur)
 {
+	LYXTRACE("Undo::undoAction");
 	return d->undoRedoAction(cur, true);
 }
 
 
 bool Undo::redoAction(CursorData & cur)
 {
+	LYXTRACE("Undo::redoAction");
 	return d->undoRedoAction(cur, false);
 }
 
@@ -21,6 +21,7 @@
 
 #include "support/convert.h"
 #include "support/debug.h"
+#include "support/FileMonitor.h"
 #include "support/filetools.h"
 #include "support/gettext.h"
 #include "support/lstrings.h"
@@ -39,6 +40,23 @@ using namespace lyx::support;
 
 namespace lyx {
 
+namespace {
+
+/// Whether the file of \p buffer is writable, i.e. locked by the user when
+/// the file uses locking. getStatus() asks for this all the time, so the
+/// status known by the file monitor of the buffer is used if possible.
+bool isLockedMonitored(Buffer const * buffer)
+{
+	FileStatus const & status = buffer->fileStatus();
+	if (status.known)
+		return !status.readonly;
+	FileName fn(buffer->absFileName());
+	fn.refresh();
+	return !fn.isReadOnly();
+}
+
+} // namespace
+
 
 int VCS::doVCCommandCall(string const & cmd, FileName const & path)
 {
@@ -903,7 +921,7 @@ bool CVS::isLocked() const
 bool CVS::checkInEnabled()
 {
 	if (vcstatus_ != NOLOCKING)
-		return isLocked();
+		return isLockedMonitored(owner_);
 	else
 		return true;
 }
@@ -946,7 +964,7 @@ string CVS::checkOut()
 bool CVS::checkOutEnabled()
 {
 	if (vcstatus_ != NOLOCKING)
-		return !isLocked();
+		return !isLockedMonitored(owner_);
 	else
 		return true;
 }
@@ -1366,7 +1384,7 @@ SVN::checkIn(vector<support::FileName> const & f, string const & msg, string & l
 bool SVN::checkInEnabled()
 {
 	if (locked_mode_)
-		return isLocked();
+		return isLockedMonitored(owner_);
 	else
 		return true;
 }
@@ -1491,7 +1509,7 @@ string SVN::checkOut()
 bool SVN::checkOutEnabled()
 {
 	if (locked_mode_)
-		return !isLocked();
+		return !isLockedMonitored(owner_);
 	else
 		return true;
 }
@@ -15,16 +15,109 @@
 #include "support/debug.h"
 #include "support/docstring.h"
 #include "support/lassert.h"
+#include "support/mutex.h"
 #include "support/weighted_btree.h"
 
 #include <QThreadStorage>
 
 #include <map>
+#include <unordered_map>
+#include <vector>
 
 using namespace std;
 
 namespace lyx {
 
+namespace {
+
+/// FNV-1a, std::hash is not available for all our char_type variants
+struct WordHash {
+	size_t operator()(docstring const & w) const
+	{
+		size_t h = 2166136261u;
+		for (char_type c : w)
+			h = (h ^ size_t(c)) * 16777619u;
+		return h;
+	}
+};
+
+
+/// Compares interned words by content
+struct WordLess {
+	bool operator()(docstring const * a, docstring const * b) const
+	{
+		return *a < *b;
+	}
+};
+
+
+/// The interned words with their reference counts. The pool is shared by
+/// all threads, since paragraphs (and their words) are copied to cloned
+/// buffers.
+struct WordPool {
+	///
+	unordered_map<docstring, size_t, WordHash> words;
+	///
+	Mutex mutex;
+};
+
+
+WordPool & wordPool()
+{
+	// Never destroyed, since paragraphs and word lists may give back
+	// their words after the static objects are gone
+	static WordPool * pool = new WordPool;
+	return *pool;
+}
+
+} // namespace
+
+
+WordInterner::WordInterner() : lock_(&wordPool().mutex)
+{}
+
+
+docstring const * WordInterner::intern(docstring const & w)
+{
+	unordered_map<docstring, size_t, WordHash> & words = wordPool().words;
+	// Look up first: emplace() would build a node with a copy of the
+	// word even if it is known already
+	auto it = words.find(w);
+	if (it == words.end())
+		it = words.emplace(w, 0).first;
+	++it->second;
+	// The elements of an unordered_map do not move on rehashing
+	return &it->first;
+}
+
+
+docstring const * internWord(docstring const & w)
+{
+	return WordInterner().intern(w);
+}
+
+
+void acquireWord(docstring const * w)
+{
+	WordPool & pool = wordPool();
+	Mutex::Locker lock(&pool.mutex);
+	auto const it = pool.words.find(*w);
+	LASSERT(it != pool.words.end() && &it->first == w, return);
+	++it->second;
+}
+
+
+void releaseWord(docstring const * w)
+{
+	WordPool & pool = wordPool();
+	Mutex::Locker lock(&pool.mutex);
+	auto const it = pool.words.find(*w);
+	LASSERT(it != pool.words.end() && &it->first == w, return);
+	if (--it->second == 0)
+		pool.words.erase(it);
+}
+
+
 ///
 typedef map<string, unique_ptr<WordList>> GlobalWordList;
 // Each thread uses its own word list, but only the one of the GUI thread is
@@ -48,22 +141,43 @@ WordList & theWordList(string const & lang)
 
 ///
 struct WordList::Impl {
+	/// Remove the words that do not occur anymore
+	void purge();
 	///
 	size_t c_;
 	///
-	typedef stx::weighted_btree<docstring, size_t, int> Words;
-	///
+	typedef stx::weighted_btree<docstring const *, size_t, int,
+		pair<docstring const *, int>, WordLess> Words;
+	/// The words with the number of their occurrences. Each word
+	/// holds a reference to the interned word.
 	Words words_;
+	/// The number of words that do not occur anymore
+	size_t unused_ = 0;
 };
 
 
+void WordList::Impl::purge()
+{
+	vector<docstring const *> unused;
+	unused.reserve(unused_);
+	for (Words::const_iterator it = words_.begin(); it != words_.end(); ++it)
+		if (it.data() == 0)
+			unused.push_back(it.key());
+	for (docstring const * w : unused) {
+		words_.erase(w);
+		releaseWord(w);
+	}
+	unused_ = 0;
+}
+
+
 WordList::WordList() : d(make_unique<Impl>())
 {
 	d->c_ = 0;
 
 #if 0
 	for (size_t i = 1000000; i > 0; --i) {
-		d->words_.insert("a" + convert<docstring>(i), size_t(1), stx::Void());
+		d->words_.insert(internWord("a" + convert<docstring>(i)), size_t(1), stx::Void());
 	}
 #endif
 }
@@ -76,9 +190,15 @@ docstring const & WordList::word(size_t idx) const
 
 	// We use the key() method here, and not something like it->first
 	// because the btree only returns (iterator-) temporary value pairs.
-	// If we returned the first component of those here, we get an
-	// invalid reference and therefore strange crashes.
-	return it.key();
+	return *it.key();
+}
+
+
+WordList::~WordList()
+{
+	for (Impl::Words::const_iterator it = d->words_.begin();
+	     it != d->words_.end(); ++it)
+		releaseWord(it.key());
 }
 
 
@@ -88,29 +208,34 @@ size_t WordList::size() const
 }
 
 
-void WordList::insert(docstring const & w)
+void WordList::insert(docstring const * w)
 {
 	Impl::Words::iterator it = d->words_.find(w);
-	if (it == d->words_.end())
+	if (it == d->words_.end()) {
+		acquireWord(w);
 		d->words_.insert(w, size_t(1), 1);
-	else {
-		it.data()++;
+	} else {
+		if (it.data()++ == 0)
+			--d->unused_;
 		d->words_.change_weight(it, 1);
 	}
 }
 
 
-void WordList::remove(docstring const & w)
+void WordList::remove(docstring const * w)
 {
 	Impl::Words::iterator it = d->words_.find(w);
 	if (it != d->words_.end()) {
-		it.data()--;
+		if (--it.data() == 0)
+			++d->unused_;
 		d->words_.change_weight(it, 0);
 		// We will not erase here, but instead we just leave it
 		// in the btree with weight 0. This avoid too much
-		// reorganisation of the tree all the time.
-		//if (it.data() == 0)
-		//	d->words_.erase(w);
+		// reorganisation of the tree all the time. The words that
+		// do not occur anymore are removed in one go when they are
+		// the majority, so that the interned words can be freed.
+		if (d->unused_ > 1000 && 2 * d->unused_ > d->words_.size())
+			d->purge();
 	}
 }
 
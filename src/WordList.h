@@ -13,24 +13,53 @@
 #define WORDLIST_H
 
 #include "support/docstring.h"
+#include "support/mutex.h"
 #include "support/mute_warning.h"
 
 #include <memory>
 
 namespace lyx {
 
+/// Return the copy of \p w that is shared by all paragraphs and word
+/// lists, and add a reference to it. Equal words are interned only once,
+/// so that they can be compared by address. Each reference must be given
+/// back with releaseWord().
+docstring const * internWord(docstring const & w);
+/// Add a reference to the interned word \p w
+void acquireWord(docstring const * w);
+/// Give back a reference to the interned word \p w. It is freed with
+/// the last reference.
+void releaseWord(docstring const * w);
+
+
+/// Interns several words under a single lock of the shared pool, which
+/// is held for the lifetime of the object.
+class WordInterner {
+public:
+	///
+	WordInterner();
+	/// Same as internWord()
+	docstring const * intern(docstring const & w);
+private:
+	///
+	Mutex::Locker lock_;
+};
+
+
 class WordList {
 public:
 	///
 	WordList();
 	///
+	~WordList();
+	///
 	docstring const & word(size_t idx) const;
 	///
 	size_t size() const;
-	///
-	void insert(docstring const & w);
-	///
-	void remove(docstring const & w);
+	/// \p w must be interned
+	void insert(docstring const * w);
+	/// \p w must be interned
+	void remove(docstring const * w);
 
 private:
 	struct Impl;
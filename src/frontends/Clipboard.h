@@ -14,6 +14,8 @@
 #ifndef BASE_CLIPBOARD_H
 #define BASE_CLIPBOARD_H
 
+#include <functional>
+
 namespace lyx {
 
 class Cursor;
@@ -75,6 +77,15 @@ public:
 	 * the clipboard.
 	 */
 	virtual void put(std::string const & lyx, docstring const & html, docstring const & text) = 0;
+	/**
+	 * Like put() above, but the LyX and HTML formats are only generated
+	 * by calling \p lyx and \p html when they are requested, e.g. by
+	 * the application the user pastes into. Copying large selections is
+	 * fast this way. \p lyx and \p html may be called several times.
+	 */
+	virtual void put(std::function<std::string()> const & lyx,
+	                 std::function<docstring()> const & html,
+	                 docstring const & text) = 0;
 
 	/// Put a general string on the system clipboard (not LyX text)
 	virtual void put(std::string const & text) const = 0;
@@ -34,6 +34,9 @@ public:
 	/// Update fonts after zoom, dpi, font names, or norm change
 	// (basically by deleting all cached values)
 	void update();
+	/// Incremented by each call to update(). Allows to detect that
+	/// cached font dimensions became invalid.
+	int generation() const;
 
 	/// Is the given font available ?
 	bool available(FontInfo const & f);
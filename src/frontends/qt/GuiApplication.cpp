@@ -83,12 +83,14 @@
 #include "support/linkback/LinkBackProxy.h"
 #endif
 
+#include <map>
 #include <queue>
 #include <tuple>
 
 #include <QByteArray>
 #include <QBitmap>
 #include <QDateTime>
+#include <QElapsedTimer>
 #include <QEvent>
 #include <QFileOpenEvent>
 #include <QFileInfo>
@@ -102,6 +104,7 @@
 #include <QList>
 #include <QMenuBar>
 #include <QMimeData>
+#include <QMouseEvent>
 #include <QObject>
 #include <QPainter>
 #include <QPixmap>
@@ -1093,6 +1096,40 @@ struct GuiApplication::Private
 	/// The result of last dispatch action
 	DispatchResult dispatch_result_;
 
+	/// Clears the status cache before and after a dispatch, and disables
+	/// it meanwhile, since the status may change at any point
+	class DispatchGuard {
+	public:
+		explicit DispatchGuard(Private & d) : d_(d)
+		{
+			d_.status_cache_.clear();
+			++d_.dispatch_depth_;
+		}
+		~DispatchGuard()
+		{
+			--d_.dispatch_depth_;
+			d_.status_cache_.clear();
+		}
+	private:
+		Private & d_;
+	};
+	/// The key of a cached getStatus() result
+	typedef tuple<FuncCode, FuncRequest::Origin, docstring> StatusKey;
+	/// The results of getStatus() since the last invalidation
+	map<StatusKey, FuncStatus> status_cache_;
+	/// The view the cached results belong to
+	GuiView const * status_view_ = nullptr;
+	/// Nothing is cached while a dispatch is running
+	int dispatch_depth_ = 0;
+	/// Nested getStatus() calls are not timed separately
+	int status_depth_ = 0;
+	/// getStatus() calls since the last key press (for Debug::ACTION)
+	int status_calls_ = 0;
+	/// How many of them were answered from the cache
+	int status_hits_ = 0;
+	/// The time they needed
+	qint64 status_nsecs_ = 0;
+
 	/// Multiple views container.
 	/**
 	* Warning: This must not be a smart pointer as the destruction of the
@@ -1278,6 +1315,46 @@ void Application::applyPrefs()
 }
 
 FuncStatus GuiApplication::getStatus(FuncRequest const & cmd) const
+{
+	// Toolbars, menus and dialogs ask for the same functions again and
+	// again. The results can be reused until anything happens that
+	// could change them, see dispatch() and notify(). Mouse requests
+	// and requests for another view are not cached.
+	bool const cacheable = d->dispatch_depth_ == 0
+		&& !cmd.view_origin() && cmd.button() == mouse_button::none
+		&& cmd.x() == 0 && cmd.y() == 0;
+	if (cacheable && d->status_view_ != current_view_) {
+		d->status_cache_.clear();
+		d->status_view_ = current_view_;
+	}
+	Private::StatusKey const key(cmd.action(), cmd.origin(), cmd.argument());
+	bool const timed = d->status_depth_ == 0
+		&& lyxerr.debugging(Debug::ACTION);
+	QElapsedTimer timer;
+	if (timed)
+		timer.start();
+	++d->status_calls_;
+	if (cacheable) {
+		auto const it = d->status_cache_.find(key);
+		if (it != d->status_cache_.end()) {
+			++d->status_hits_;
+			if (timed)
+				d->status_nsecs_ += timer.nsecsElapsed();
+			return it->second;
+		}
+	}
+	++d->status_depth_;
+	FuncStatus const status = computeStatus(cmd);
+	--d->status_depth_;
+	if (cacheable)
+		d->status_cache_[key] = status;
+	if (timed)
+		d->status_nsecs_ += timer.nsecsElapsed();
+	return status;
+}
+
+
+FuncStatus GuiApplication::computeStatus(FuncRequest const & cmd) const
 {
 	FuncStatus status;
 
@@ -1749,6 +1826,7 @@ void GuiApplication::validateCurrentView()
 void GuiApplication::dispatch(FuncRequest const & cmd, DispatchResult & dr)
 {
 	LYXERR(Debug::ACTION, "cmd: " << cmd);
+	Private::DispatchGuard guard(*d);
 
 	// we have not done anything wrong yet.
 	dr.setError(false);
@@ -2432,6 +2510,16 @@ void GuiApplication::processKeySym(KeySymbol const & keysym, KeyModifier state)
 		return;
 	}
 
+	if (d->status_calls_ > 0) {
+		LYXERR(Debug::ACTION, "getStatus() since the last key: "
+		       << d->status_calls_ << " calls, " << d->status_hits_
+		       << " from the cache, "
+		       << d->status_nsecs_ / 1000 << " microseconds");
+		d->status_calls_ = 0;
+		d->status_hits_ = 0;
+		d->status_nsecs_ = 0;
+	}
+
 	char_type encoded_last_key = keysym.getUCSEncoded();
 
 	// Do a one-deep top-level lookup for
@@ -3032,6 +3120,32 @@ bool GuiApplication::event(QEvent * e)
 
 bool GuiApplication::notify(QObject * receiver, QEvent * event)
 {
+	// Any event could change the status of functions, e.g. mouse clicks
+	// move the cursor, and timers finish exports. Only the events that
+	// are known to be harmless keep the status cache.
+	switch (event->type()) {
+	case QEvent::Paint:
+	case QEvent::UpdateRequest:
+	case QEvent::LayoutRequest:
+	case QEvent::Enter:
+	case QEvent::Leave:
+	case QEvent::HoverEnter:
+	case QEvent::HoverLeave:
+	case QEvent::HoverMove:
+	case QEvent::ToolTip:
+	case QEvent::StatusTip:
+	case QEvent::Polish:
+	case QEvent::PolishRequest:
+	case QEvent::ChildPolished:
+		break;
+	case QEvent::MouseMove:
+		if (static_cast<QMouseEvent *>(event)->buttons() == Qt::NoButton)
+			break;
+		// fall through
+	default:
+		d->status_cache_.clear();
+	}
+
 	try {
 		return QApplication::notify(receiver, event);
 	}
@@ -256,6 +256,8 @@ private Q_SLOTS:
 	void onApplicationStateChanged(Qt::ApplicationState state);
 
 private:
+	/// getStatus() without the cache
+	FuncStatus computeStatus(FuncRequest const & cmd) const;
 	///
 	void validateCurrentView();
 	///
@@ -34,6 +34,7 @@
 #include "support/docstring.h"
 #include "support/gettext.h"
 #include "support/lstrings.h"
+#include "support/textutils.h"
 
 #include <QCloseEvent>
 #include <QMenu>
@@ -41,10 +42,14 @@
 #include <QShowEvent>
 #include <QStandardItemModel>
 #include <QVariant>
+#include <QtConcurrentRun>
 
 #undef KeyPress
 
 #include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
 #include <regex>
 #include <vector>
 
@@ -86,6 +91,250 @@ static vector<lyx::docstring> to_docstring_vector(QStringList const & qlist)
 }
 
 
+/// The BibTeX information in a form that can be searched quickly.
+/// It does not refer to the BiblioInfo, so that searches can run in a
+/// worker thread while the document changes.
+class CitationIndex {
+public:
+	/// The texts searched for one choice in the fields combo
+	struct Column {
+		/// As they are, for case sensitive search
+		vector<string> texts;
+		/// In lowercase, for case insensitive search
+		vector<string> lowered;
+	};
+	///
+	explicit CitationIndex(BiblioInfo const & bi);
+	/// Is this the index of the current contents of \p bi?
+	bool isIndexOf(BiblioInfo const & bi) const
+		{ return &bi == info_ && bi.generation() == generation_; }
+	/// The number of entries
+	size_t size() const { return keys_.size(); }
+	///
+	QString const & key(size_t i) const { return keys_[i]; }
+	///
+	docstring const & entryType(size_t i) const { return entry_types_[i]; }
+	/// The keys of the entries
+	Column const & keyColumn() const { return *key_column_; }
+	/// The texts searched for \p field, or for all fields if
+	/// \p field is empty, or for the keys. The column is built on
+	/// first use, \p bi must be the indexed BiblioInfo.
+	shared_ptr<Column const> column(BiblioInfo const & bi,
+		bool only_keys, docstring const & field);
+	/// Count for each entry how many of \p words begin one of the
+	/// words of its key, author, title or year.
+	vector<int> wordMatches(vector<string> const & words) const;
+	/// The lowercase words of \p s
+	static vector<string> words(docstring const & s);
+private:
+	///
+	BiblioInfo const * info_;
+	///
+	unsigned long generation_;
+	///
+	vector<docstring> dkeys_;
+	///
+	vector<QString> keys_;
+	///
+	vector<docstring> entry_types_;
+	/// The words of the key, author, title and year of the entries,
+	/// sorted, with the entries they occur in
+	vector<pair<string, vector<unsigned int>>> words_;
+	///
+	shared_ptr<Column const> key_column_;
+	/// The columns of the fields, the empty field is all fields
+	map<docstring, shared_ptr<Column const>> field_columns_;
+};
+
+
+CitationIndex::CitationIndex(BiblioInfo const & bi)
+	: info_(&bi), generation_(bi.generation()), dkeys_(bi.getKeys())
+{
+	key_column_ = column(bi, true, docstring());
+	map<string, vector<unsigned int>> words;
+	keys_.reserve(dkeys_.size());
+	entry_types_.reserve(dkeys_.size());
+	for (unsigned int i = 0; i != dkeys_.size(); ++i) {
+		docstring const & key = dkeys_[i];
+		keys_.push_back(toqstr(key));
+		BiblioInfo::const_iterator const it = bi.find(key);
+		if (it == bi.end()) {
+			entry_types_.push_back(docstring());
+			continue;
+		}
+		BibTeXInfo const & data = it->second;
+		entry_types_.push_back(data.entryType());
+		docstring const text = key + ' ' + data["author"] + ' '
+			+ data["title"] + ' ' + data.getYear();
+		for (string const & word : CitationIndex::words(text)) {
+			vector<unsigned int> & entries = words[word];
+			if (entries.empty() || entries.back() != i)
+				entries.push_back(i);
+		}
+	}
+	words_.reserve(words.size());
+	for (auto & word : words)
+		words_.emplace_back(word.first, std::move(word.second));
+}
+
+
+shared_ptr<CitationIndex::Column const> CitationIndex::column(
+	BiblioInfo const & bi, bool only_keys, docstring const & field)
+{
+	shared_ptr<Column const> & col =
+		only_keys ? key_column_ : field_columns_[field];
+	if (col)
+		return col;
+	auto newcol = make_shared<Column>();
+	newcol->texts.reserve(dkeys_.size());
+	newcol->lowered.reserve(dkeys_.size());
+	for (docstring const & key : dkeys_) {
+		docstring text;
+		if (only_keys)
+			text = key;
+		else {
+			BiblioInfo::const_iterator const it = bi.find(key);
+			if (it != bi.end())
+				text = field.empty()
+					? key + ' ' + it->second.allData()
+					: it->second[field];
+		}
+		newcol->texts.push_back(to_utf8(text));
+		newcol->lowered.push_back(to_utf8(lowercase(text)));
+	}
+	col = newcol;
+	return col;
+}
+
+
+vector<int> CitationIndex::wordMatches(vector<string> const & words) const
+{
+	vector<int> counts(size(), 0);
+	vector<bool> found(size());
+	for (string const & word : words) {
+		found.assign(size(), false);
+		auto it = lower_bound(words_.begin(), words_.end(), word,
+			[](pair<string, vector<unsigned int>> const & w,
+			   string const & s) { return w.first < s; });
+		for (; it != words_.end() && prefixIs(it->first, word); ++it)
+			for (unsigned int const i : it->second)
+				found[i] = true;
+		for (size_t i = 0; i != size(); ++i)
+			if (found[i])
+				++counts[i];
+	}
+	return counts;
+}
+
+
+vector<string> CitationIndex::words(docstring const & s)
+{
+	vector<string> result;
+	docstring word;
+	for (char_type const c : lowercase(s)) {
+		if (isLetterChar(c) || isDigitASCII(c)) {
+			word += c;
+		} else if (!word.empty()) {
+			result.push_back(to_utf8(word));
+			word.clear();
+		}
+	}
+	if (!word.empty())
+		result.push_back(to_utf8(word));
+	return result;
+}
+
+
+/// A search in a CitationIndex, which may run in a worker thread
+class CitationSearch {
+public:
+	/// Run the search
+	void run();
+	///
+	shared_ptr<CitationIndex const> index;
+	/// The texts to search in
+	shared_ptr<CitationIndex::Column const> column;
+	/// The entries to search in, in the order of the index
+	vector<unsigned int> candidates;
+	/// The entry type to show, empty for all
+	docstring entry_type;
+	/// Show all entries of the type
+	bool match_all = false;
+	/// The text searched for, lowercase if not case_sensitive and
+	/// not reg_exp
+	string expression;
+	/// The lowercase expression and its words, used for ranking
+	string lowered;
+	///
+	vector<string> words;
+	///
+	bool only_keys = false;
+	///
+	docstring field;
+	///
+	bool case_sensitive = false;
+	///
+	bool reg_exp = false;
+	/// The compiled expression if reg_exp
+	regex re;
+	/// Set when the result is not needed anymore
+	atomic<bool> canceled { false };
+	/// Set when run() is done
+	atomic<bool> finished { false };
+	/// The matching entries, the best ones first
+	vector<unsigned int> result;
+};
+
+
+void CitationSearch::run()
+{
+	vector<string> const & texts = (case_sensitive || reg_exp)
+		? column->texts : column->lowered;
+	size_t count = 0;
+	for (unsigned int const i : candidates) {
+		if ((++count & 1023) == 0 && canceled)
+			return;
+		if (!entry_type.empty() && index->entryType(i) != entry_type)
+			continue;
+		if (match_all) {
+			result.push_back(i);
+			continue;
+		}
+		string const & text = texts[i];
+		if (text.empty())
+			continue;
+		if (!reg_exp) {
+			if (text.find(expression) != string::npos)
+				result.push_back(i);
+			continue;
+		}
+		try {
+			if (regex_search(text, re))
+				result.push_back(i);
+		} catch (regex_error const &) {
+			result.clear();
+			break;
+		}
+	}
+
+	// Entries whose key begins with the search string come first,
+	// then those where most of its words begin a word of the key,
+	// author, title or year.
+	if (!match_all && !reg_exp && !canceled && result.size() > 1) {
+		vector<string> const & keys = index->keyColumn().lowered;
+		vector<int> rank = index->wordMatches(words);
+		for (unsigned int const i : result)
+			if (prefixIs(keys[i], lowered))
+				rank[i] += int(words.size()) + 1;
+		stable_sort(result.begin(), result.end(),
+			[&rank](unsigned int a, unsigned int b) {
+				return rank[a] > rank[b];
+			});
+	}
+	finished = true;
+}
+
+
 GuiCitation::GuiCitation(GuiView & lv)
 	: DialogView(lv, "citation", qt_("Citation")),
 	  style_(QString()), params_(insetCode("citation"))
@@ -157,6 +406,8 @@ GuiCitation::GuiCitation(GuiView & lv)
 		this, SLOT(caseChanged()));
 	connect(instant_, SIGNAL(triggered(bool)),
 		this, SLOT(instantChanged(bool)));
+	connect(&search_watcher_, SIGNAL(finished()),
+		this, SLOT(searchFinished()));
 
 	selectedLV->horizontalHeader()->setSectionResizeMode(QHeaderView::Stretch);
 
@@ -834,53 +1085,86 @@ void GuiCitation::findKey(BiblioInfo const & bi,
 	docstring const & field, docstring const & entry_type,
 	bool case_sensitive, bool reg_exp, bool reset)
 {
-	// FIXME THREAD
-	// This should be moved to a class member.
-	// Used for optimisation: store last searched string.
-	static QString last_searched_string;
-	// Used to disable the above optimisation.
-	static bool last_case_sensitive;
-	static bool last_reg_exp;
-	// Reset last_searched_string in case of changed option.
-	if (last_case_sensitive != case_sensitive
-		|| last_reg_exp != reg_exp) {
-			LYXERR(Debug::GUI, "GuiCitation::findKey: optimisation disabled!");
-		last_searched_string.clear();
+	if (!index_ || !index_->isIndexOf(bi))
+		index_ = make_shared<CitationIndex>(bi);
+
+	auto search = make_shared<CitationSearch>();
+	search->index = index_;
+	search->column = index_->column(bi, only_keys, field);
+	search->entry_type = entry_type;
+	search->match_all = str.isEmpty();
+	search->only_keys = only_keys;
+	search->field = field;
+	search->case_sensitive = case_sensitive;
+	search->reg_exp = reg_exp;
+	docstring const expr = trim(qstring_to_ucs4(str));
+	search->lowered = to_utf8(lowercase(expr));
+	search->words = CitationIndex::words(expr);
+	if (case_sensitive || reg_exp)
+		search->expression = to_utf8(expr);
+	else
+		search->expression = search->lowered;
+	if (reg_exp && !search->expression.empty()) {
+		try {
+			search->re.assign(search->expression, case_sensitive ?
+				regex_constants::ECMAScript : regex_constants::icase);
+		} catch (regex_error const & e) {
+			// regex throws an exception if the regular expression is not
+			// valid.
+			LYXERR(Debug::GUI, e.what());
+			search->expression.clear();
+		}
 	}
-	// save option for next search.
-	last_case_sensitive = case_sensitive;
-	last_reg_exp = reg_exp;
 
-	Qt::CaseSensitivity qtcase = case_sensitive ?
-			Qt::CaseSensitive: Qt::CaseInsensitive;
-	QStringList keys;
-	// If new string (str) contains the last searched one...
-	if (!reset &&
-		!last_searched_string.isEmpty() &&
-		str.size() > 1 &&
-		str.contains(last_searched_string, qtcase))
-		// ... then only search within already found list.
-		keys = available_model_.stringList();
-	else
-		// ... else search all keys.
-		keys = all_keys_;
-	// save searched string for next search.
-	last_searched_string = str;
+	// If the new string contains the last searched one, only the
+	// keys found then can match. If the string is blank or an invalid
+	// regular expression, nothing can match.
+	shared_ptr<CitationSearch> const last = search_;
+	if (!reset && !reg_exp && last && last->finished
+	    && last->index == index_ && !last->reg_exp
+	    && !last->match_all && !last->expression.empty()
+	    && last->only_keys == only_keys && last->field == field
+	    && last->case_sensitive == case_sensitive
+	    && last->entry_type == entry_type
+	    && search->expression.find(last->expression) != string::npos) {
+		search->candidates = last->result;
+		sort(search->candidates.begin(), search->candidates.end());
+	} else if (search->match_all || !search->expression.empty()) {
+		search->candidates.resize(index_->size());
+		for (unsigned int i = 0; i != index_->size(); ++i)
+			search->candidates[i] = i;
+	}
 
-	QStringList result;
+	// A newer search makes the running one useless
+	if (last)
+		last->canceled = true;
+	search_ = search;
+	// Searching a few thousand entries is fast enough
+	if (search->candidates.size() < 5000) {
+		search->run();
+		showSearchResult();
+	} else
+		search_watcher_.setFuture(
+			QtConcurrent::run([search]() { search->run(); }));
+}
 
-	// First, filter by entry_type, which will be faster than
-	// what follows, so we may get to do that on less.
-	vector<docstring> keyVector = to_docstring_vector(keys);
-	filterByEntryType(bi, keyVector, entry_type);
 
-	if (str.isEmpty())
-		result = to_qstring_list(keyVector);
-	else
-		result = to_qstring_list(searchKeys(bi, keyVector, only_keys,
-			qstring_to_ucs4(str), field, case_sensitive, reg_exp));
+void GuiCitation::searchFinished()
+{
+	if (!search_ || !search_->finished)
+		return;
+	showSearchResult();
+	updateControls();
+}
 
-	available_model_.setStringList(result);
+
+void GuiCitation::showSearchResult()
+{
+	QStringList keys;
+	for (unsigned int const i : search_->result)
+		if (!search_->index->key(i).isEmpty())
+			keys.append(search_->index->key(i));
+	available_model_.setStringList(keys);
 }
 
 
@@ -953,101 +1237,6 @@ void GuiCitation::clearParams()
 }
 
 
-void GuiCitation::filterByEntryType(BiblioInfo const & bi,
-	vector<docstring> & keyVector, docstring const & entry_type)
-{
-	if (entry_type.empty())
-		return;
-
-	vector<docstring> result;
-	for (auto const & key : keyVector) {
-		BiblioInfo::const_iterator cit = bi.find(key);
-		if (cit == bi.end())
-			continue;
-		if (cit->second.entryType() == entry_type)
-			result.push_back(key);
-	}
-	keyVector = result;
-}
-
-
-// Escape special chars.
-// All characters are literals except: '.|*?+(){}[]^$\'
-// These characters are literals when preceded by a "\", which is done here
-// @todo: This function should be moved to support, and then the test in tests
-//        should be moved there as well.
-static docstring escape_special_chars(docstring const & expr)
-{
-	// Search for all chars '.|*?+(){}[^$]\'
-	// Note that '[', ']', and '\' must be escaped.
-	static const regex reg("[.|*?+(){}^$\\[\\]\\\\]");
-
-	// $& is an ECMAScript format expression that expands to all
-	// of the current match
-	// To prefix a matched expression with a single literal backslash, we
-	// need to escape it for the C++ compiler and use:
-	// FIXME: UNICODE
-	return from_utf8(regex_replace(to_utf8(expr), reg, string("\\$&")));
-}
-
-
-vector<docstring> GuiCitation::searchKeys(BiblioInfo const & bi,
-	vector<docstring> const & keys_to_search, bool only_keys,
- 	docstring const & search_expression, docstring const & field,
-	bool case_sensitive, bool re)
-{
-	vector<docstring> foundKeys;
-
-	docstring expr = trim(search_expression);
-	if (expr.empty())
-		return foundKeys;
-
-	if (!re)
-		// We must escape special chars in the search_expr so that
-		// it is treated as a simple string by regex.
-		expr = escape_special_chars(expr);
-
-	regex reg_exp;
-	try {
-		reg_exp.assign(to_utf8(expr), case_sensitive ?
-			regex_constants::ECMAScript : regex_constants::icase);
-	} catch (regex_error const & e) {
-		// regex throws an exception if the regular expression is not
-		// valid.
-		LYXERR(Debug::GUI, e.what());
-		return vector<docstring>();
-	}
-
-	for (auto const & key : keys_to_search) {
-		BiblioInfo::const_iterator info = bi.find(key);
-		if (info == bi.end())
-			continue;
-
-		BibTeXInfo const & kvm = info->second;
-		string sdata;
-		if (only_keys)
-			sdata = to_utf8(key);
-		else if (field.empty())
-			sdata = to_utf8(key) + ' ' + to_utf8(kvm.allData());
-		else
-			sdata = to_utf8(kvm[field]);
-
-		if (sdata.empty())
-			continue;
-
-		try {
-			if (regex_search(sdata, reg_exp))
-				foundKeys.push_back(key);
-		}
-		catch (regex_error const & e) {
-			LYXERR(Debug::GUI, e.what());
-			return vector<docstring>();
-		}
-	}
-	return foundKeys;
-}
-
-
 void GuiCitation::dispatchParams()
 {
 	std::string const lfun = InsetCommand::params2string(params_);
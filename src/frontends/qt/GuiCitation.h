@@ -22,16 +22,21 @@
 
 #include "BiblioInfo.h"
 
+#include <QFutureWatcher>
 #include <QStandardItemModel>
 #include <QStringList>
 #include <QStringListModel>
 
+#include <memory>
+
 namespace lyx {
 
 class CitationStyle;
 
 namespace frontend {
 
+class CitationIndex;
+class CitationSearch;
 class FancyLineEdit;
 class GuiSelectionManager;
 
@@ -65,6 +70,8 @@ private Q_SLOTS:
 	void updateStyles();
 	/// performs a limited update, suitable for internal call
 	void updateControls();
+	/// show the result of a search that ran in the background
+	void searchFinished();
 
 
 private:
@@ -84,7 +91,7 @@ private:
 	void showEvent(QShowEvent * e) override;
 	///
 	void closeEvent(QCloseEvent * e) override;
-	/// prepares a call to GuiCitation::searchKeys when we
+	/// prepares a call to GuiCitation::findKey when we
 	/// are ready to search the BibTeX entries
 	void findText(QString const & text, bool reset = false);
 	/// check whether key is already selected
@@ -123,7 +130,9 @@ private:
 	/// Get post texts of qualified lists
 	std::vector<docstring> getPostTexts();
 
-	/// Find keys containing a string.
+	/// Find keys containing a string. Large searches run in the
+	/// background, and the list of available keys is updated when
+	/// they are done.
 	void findKey(
 		BiblioInfo const & bi, //< optimize by passing this
 		QString const & str, //< string expression
@@ -143,21 +152,8 @@ private:
 	void applyParams(int const choice, bool const full, bool const force,
 					  QString before, QString after);
 
-	///
-	void filterByEntryType(BiblioInfo const & bi,
-		std::vector<docstring> & keyVector, docstring const & entryType);
-
-	/// Search a given string within the passed keys.
-	/// \return the vector of matched keys.
-	std::vector<docstring> searchKeys(
-		BiblioInfo const & bi, //< optimize by passing this
-		std::vector<docstring> const & keys_to_search, //< Keys to search.
-		bool only_keys, //< whether to search only the keys
-		docstring const & search_expression, //< Search expression (regex possible)
-		docstring const & field, //< field to search, empty for all fields
-		bool case_sensitive = false, //< set to true is the search should be case sensitive
-		bool regex = false //< \set to true if \c search_expression is a regex
-		); //
+	/// Show the result of search_ in the list of available keys
+	void showSearchResult();
 
 	/// The BibTeX information available to the dialog
 	/// Calls to this method will lead to checks of modification times and
@@ -186,6 +182,13 @@ private:
 	QStandardItemModel selected_model_;
 	/// All keys.
 	QStringList all_keys_;
+	/// The searchable form of the BibTeX information,
+	/// rebuilt when the information changes
+	std::shared_ptr<CitationIndex> index_;
+	/// The last search
+	std::shared_ptr<CitationSearch> search_;
+	/// Watches search_ if it runs in the background
+	QFutureWatcher<void> search_watcher_;
 	/// Cited keys.
 	QStringList cited_keys_;
 	///
@@ -62,6 +62,58 @@ namespace lyx {
 
 namespace frontend {
 
+namespace {
+
+/// Mime data whose LyX and HTML formats are generated on request
+class LazyMimeData : public QMimeData
+{
+public:
+	///
+	LazyMimeData(function<string()> const & lyx,
+	             function<docstring()> const & html)
+		: lyx_(lyx), html_(html)
+	{}
+	///
+	QStringList formats() const override
+	{
+		return QMimeData::formats() << lyxMimeType() << "text/html";
+	}
+	///
+	bool hasFormat(QString const & mimeType) const override
+	{
+		return formats().contains(mimeType);
+	}
+
+protected:
+	///
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+	QVariant retrieveData(QString const & mimeType, QMetaType type) const override
+#else
+	QVariant retrieveData(QString const & mimeType, QVariant::Type type) const override
+#endif
+	{
+		if (mimeType == lyxMimeType()) {
+			LYXERR(Debug::CLIPBOARD, "Generating the LyX format");
+			string const lyx = lyx_();
+			return QByteArray(lyx.c_str(), lyx.size());
+		}
+		if (mimeType == "text/html") {
+			LYXERR(Debug::CLIPBOARD, "Generating the HTML format");
+			return toqstr(html_());
+		}
+		return QMimeData::retrieveData(mimeType, type);
+	}
+
+private:
+	///
+	function<string()> lyx_;
+	///
+	function<docstring()> html_;
+};
+
+} // namespace
+
+
 static QMimeData const * read_clipboard()
 {
 	LYXERR(Debug::CLIPBOARD, "Getting Clipboard");
@@ -454,6 +506,24 @@ void GuiClipboard::put(string const & lyx, docstring const & html, docstring con
 }
 
 
+void GuiClipboard::put(function<string()> const & lyx,
+                       function<docstring()> const & html,
+                       docstring const & text)
+{
+	LYXERR(Debug::CLIPBOARD, "GuiClipboard::put(<lazy> <lazy> `"
+			      << to_utf8(text) << "')");
+	LazyMimeData * data = new LazyMimeData(lyx, html);
+	// Without clipboard ownership we recognize internal data through
+	// its checksum, so we need the LyX format right away.
+	if (!hasInternal())
+		checksum = support::checksum(lyx());
+	// Don't test for text.empty() since we want to be able to clear the
+	// clipboard.
+	data->setText(toqstr(text));
+	qApp->clipboard()->setMimeData(data, QClipboard::Clipboard);
+}
+
+
 bool GuiClipboard::hasTextContents(Clipboard::TextType type) const
 {
 	switch (type) {
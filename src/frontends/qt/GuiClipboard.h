@@ -72,6 +72,9 @@ public:
 	docstring const getAsText(TextType type) const override;
 	void put(std::string const & text) const override;
 	void put(std::string const & lyx, docstring const & html, docstring const & text) override;
+	void put(std::function<std::string()> const & lyx,
+	         std::function<docstring()> const & html,
+	         docstring const & text) override;
 	bool hasGraphicsContents(GraphicsType type = AnyGraphicsType) const override;
 	bool hasTextContents(TextType type = AnyTextType) const override;
 	bool isInternal() const override;
@@ -96,6 +96,9 @@ size_t const nr_symbol_fonts = sizeof(symbol_fonts) / sizeof(symbol_fonts[0]);
 static GuiFontInfo *
 fontinfo_[NUM_FAMILIES][NUM_SERIES][NUM_SHAPE][NUM_SIZE][NUM_STYLE];
 
+/// the number of times the fontinfo_ table was cleared
+static int fontinfo_generation_ = 0;
+
 
 // returns a reference to the pointer type (GuiFontInfo *) in the
 // fontinfo_ table.
@@ -257,6 +260,13 @@ void FontLoader::update()
 					delete fontinfo_[i1][i2][i3][i4][i5];
 					fontinfo_[i1][i2][i3][i4][i5] = 0;
 				}
+	++fontinfo_generation_;
+}
+
+
+int FontLoader::generation() const
+{
+	return fontinfo_generation_;
 }
 
 
@@ -40,6 +40,9 @@
 #include <QTextDocument>
 #include <QTimer>
 #include <QVariant>
+#include <QtConcurrentRun>
+
+#include <algorithm>
 
 using namespace std;
 
@@ -69,6 +72,8 @@ ViewSourceWidget::ViewSourceWidget(QWidget * parent)
 	// setting a document at this point trigger an assertion in Qt
 	// so we disable the signals here:
 	document_->blockSignals(true);
+	// setText() edits the document in place, which must not be undoable
+	document_->setUndoRedoEnabled(false);
 	viewSourceTV->setDocument(document_);
 	// reset selections
 	setText();
@@ -82,27 +87,56 @@ ViewSourceWidget::ViewSourceWidget(QWidget * parent)
 
 	// catch double click events
 	viewSourceTV->viewport()->installEventFilter(this);
+
+	connect(&generator_, SIGNAL(finished()),
+		this, SLOT(sourceGenerated()));
 }
 
 
-void ViewSourceWidget::getContent(BufferView const & view,
-			Buffer::OutputWhat output, docstring & str, string const & format,
-			bool master)
+ViewSourceWidget::~ViewSourceWidget()
 {
-	// get the *top* level paragraphs that contain the cursor,
-	// or the selected text
-	pit_type par_begin;
-	pit_type par_end;
+	// The worker thread uses a clone of the buffer, which refers to
+	// the original buffer.
+	generator_.waitForFinished();
+}
 
-	if (!view.cursor().selection()) {
-		par_begin = view.cursor().bottom().pit();
+
+bool ViewSourceWidget::SourceKey::operator==(SourceKey const & key) const
+{
+	return buffer == key.buffer && id == key.id && format == key.format
+		&& output == key.output && par_begin == key.par_begin
+		&& par_end == key.par_end && master == key.master
+		&& texrow_info == key.texrow_info;
+}
+
+
+namespace {
+
+// get the *top* level paragraphs that contain the cursor,
+// or the selected text
+void paragraphRange(Cursor const & cur, pit_type & par_begin, pit_type & par_end)
+{
+	if (!cur.selection()) {
+		par_begin = cur.bottom().pit();
 		par_end = par_begin;
 	} else {
-		par_begin = view.cursor().selectionBegin().bottom().pit();
-		par_end = view.cursor().selectionEnd().bottom().pit();
+		par_begin = cur.selectionBegin().bottom().pit();
+		par_end = cur.selectionEnd().bottom().pit();
 	}
 	if (par_begin > par_end)
 		swap(par_begin, par_end);
+}
+
+} // namespace
+
+
+void ViewSourceWidget::getContent(BufferView const & view,
+			Buffer::OutputWhat output, docstring & str, string const & format,
+			bool master)
+{
+	pit_type par_begin;
+	pit_type par_end;
+	paragraphRange(view.cursor(), par_begin, par_end);
 	odocstringstream ostr;
 	texrow_ = view.buffer()
 		.getSourceCode(ostr, format, par_begin, par_end + 1, output, master);
@@ -111,13 +145,68 @@ void ViewSourceWidget::getContent(BufferView const & view,
 }
 
 
+ViewSourceWidget::GeneratedSource ViewSourceWidget::generateAndDestroy(
+	Buffer * clone, string const & format, Buffer::OutputWhat output,
+	bool master)
+{
+	GeneratedSource res;
+	odocstringstream ostr;
+	res.texrow = clone->getSourceCode(ostr, format, 0, 0, output, master);
+	//ensure that the last line can always be selected in its full width
+	res.str = ostr.str() + "\n";
+	// the cloning operation will have produced a clone of the entire set of
+	// documents, starting from the master. so we must delete those.
+	delete const_cast<Buffer *>(clone->masterBuffer());
+	return res;
+}
+
+
 bool ViewSourceWidget::setText(QString const & qstr)
 {
-	bool const changed = document_->toPlainText() != qstr;
 	viewSourceTV->setExtraSelections(QList<QTextEdit::ExtraSelection>());
-	if (changed)
+	if (text_ == qstr)
+		return false;
+
+	// Replace only what changed, so that the highlighter only processes
+	// the modified lines.
+	int const length = min(text_.length(), qstr.length());
+	int prefix = 0;
+	while (prefix < length && text_.at(prefix) == qstr.at(prefix))
+		++prefix;
+	int suffix = 0;
+	while (suffix < length - prefix
+	       && text_.at(text_.length() - 1 - suffix)
+	          == qstr.at(qstr.length() - 1 - suffix))
+		++suffix;
+	// do not cut surrogate pairs
+	if (prefix > 0 && text_.at(prefix - 1).isHighSurrogate())
+		--prefix;
+	if (suffix > 0 && text_.at(text_.length() - suffix).isLowSurrogate())
+		--suffix;
+
+	if (2 * (prefix + suffix) <= qstr.length())
+		// mostly new contents
 		document_->setPlainText(qstr);
-	return changed;
+	else {
+		QTextCursor c(document_);
+		c.setPosition(prefix);
+		c.setPosition(text_.length() - suffix, QTextCursor::KeepAnchor);
+		c.insertText(qstr.mid(prefix, qstr.length() - prefix - suffix));
+	}
+	text_ = qstr;
+	return true;
+}
+
+
+void ViewSourceWidget::reset()
+{
+	// The worker thread uses a clone of the buffer, which refers to
+	// the original buffer.
+	generator_.waitForFinished();
+	running_key_ = SourceKey();
+	shown_key_ = SourceKey();
+	texrow_.reset();
+	setText();
 }
 
 
@@ -144,7 +233,10 @@ int ViewSourceWidget::updateDelay() const
 	const int long_delay = 400;
 	const int short_delay = 60;
 	// a shorter delay if just the current paragraph is shown
-	return (contentsCO->currentIndex() == 0) ? short_delay : long_delay;
+	if (contentsCO->currentIndex() == 0)
+		return short_delay;
+	// do not try to generate the source more often than it takes
+	return int(max(qint64(long_delay), generation_time_));
 }
 
 
@@ -170,135 +262,202 @@ void GuiViewSource::realUpdateView()
 void ViewSourceWidget::updateView(BufferView const * bv)
 {
 	if (!bv) {
-		setText();
+		reset();
 		setEnabled(false);
 		return;
 	}
 
 	setEnabled(true);
 
+	SourceKey key;
+	key.buffer = &bv->buffer();
+	key.id = bv->buffer().id();
+	key.format = view_format_;
+	key.output = Buffer::CurrentParagraph;
+	if (contentsCO->currentIndex() == 1)
+		key.output = Buffer::FullSource;
+	else if (contentsCO->currentIndex() == 2)
+		key.output = Buffer::OnlyPreamble;
+	else if (contentsCO->currentIndex() == 3)
+		key.output = Buffer::OnlyBody;
+	if (key.output == Buffer::CurrentParagraph)
+		paragraphRange(bv->cursor(), key.par_begin, key.par_end);
+	key.master = masterPerspectiveCB->isChecked();
+	// output tex<->row correspondences in the source panel if the "-dbg latex"
+	// option is given.
+	key.texrow_info = guiApp->currentView()->develMode()
+		&& lyx::lyxerr.debugging(Debug::OUTFILE);
+
+	// Regenerate the source only if it can have changed. Otherwise, only
+	// the highlighting of the cursor has to be updated.
+	if (!(key == shown_key_)) {
+		if (key.output != Buffer::CurrentParagraph) {
+			// This can take long, and is therefore done on a clone
+			// of the buffer in a worker thread. If one is already
+			// running, sourceGenerated() will ask for an update.
+			if (!generator_.isRunning()) {
+				Buffer * clone = bv->buffer().cloneWithChildren();
+				if (!clone) {
+					LYXERR0("Error cloning the Buffer.");
+					return;
+				}
+				running_key_ = key;
+				generation_timer_.start();
+				generator_.setFuture(QtConcurrent::run(
+					&ViewSourceWidget::generateAndDestroy, clone,
+					key.format, key.output, key.master));
+			}
+			return;
+		}
+		// the source being generated is not needed anymore
+		running_key_ = SourceKey();
+		docstring content;
+		getContent(*bv, key.output, content, key.format, key.master);
+		showContent(content, key);
+	}
+
+	if (texrow_)
+		highlightCursor(*bv);
+}
+
+
+void ViewSourceWidget::sourceGenerated()
+{
+	generation_time_ = generation_timer_.elapsed();
+	// Is the result still wanted?
+	if (!running_key_.buffer)
+		return;
+	GeneratedSource const res = generator_.result();
+	texrow_ = res.texrow;
+	showContent(res.str, running_key_);
+	running_key_ = SourceKey();
+	// The buffer may have changed in the meantime, and the cursor has to
+	// be highlighted.
+	contentsChanged();
+}
+
+
+void ViewSourceWidget::showContent(docstring const & content,
+                                   SourceKey const & key)
+{
 	// we will try to get that much space around the cursor
 	int const v_margin = 3;
 	int const h_margin = 10;
 	// we will try to preserve this
 	int const h_scroll = viewSourceTV->horizontalScrollBar()->value();
 
-	Buffer::OutputWhat output = Buffer::CurrentParagraph;
-	if (contentsCO->currentIndex() == 1)
-		output = Buffer::FullSource;
-	else if (contentsCO->currentIndex() == 2)
-		output = Buffer::OnlyPreamble;
-	else if (contentsCO->currentIndex() == 3)
-		output = Buffer::OnlyBody;
-
-	docstring content;
-	getContent(*bv, output, content, view_format_,
-	           masterPerspectiveCB->isChecked());
-	QString old = document_->toPlainText();
+	shown_key_ = key;
+	QString const old = text_;
 	QString qcontent = toqstr(content);
-	if (guiApp->currentView()->develMode()) {
-		// output tex<->row correspondences in the source panel if the "-dbg latex"
-		// option is given.
-		if (texrow_ && lyx::lyxerr.debugging(Debug::OUTFILE)) {
-			QStringList list = qcontent.split(QChar('\n'));
-			docstring_list dlist;
-			for (QStringList::const_iterator it = list.begin(); it != list.end(); ++it)
-				dlist.push_back(from_utf8(fromqstr(*it)));
-			texrow_->prepend(dlist);
-			qcontent.clear();
-			for (docstring_list::iterator it = dlist.begin(); it != dlist.end(); ++it)
-				qcontent += toqstr(*it) + '\n';
-		}
+	if (texrow_ && key.texrow_info) {
+		QStringList list = qcontent.split(QChar('\n'));
+		docstring_list dlist;
+		for (QStringList::const_iterator it = list.begin(); it != list.end(); ++it)
+			dlist.push_back(from_utf8(fromqstr(*it)));
+		texrow_->prepend(dlist);
+		qcontent.clear();
+		for (docstring_list::iterator it = dlist.begin(); it != dlist.end(); ++it)
+			qcontent += toqstr(*it) + '\n';
 	}
 
 	// prevent gotoCursor()
 	QSignalBlocker blocker(viewSourceTV);
-	bool const changed = setText(qcontent);
-
-	if (changed && !texrow_) {
-		// position-to-row is unavailable
-		// we jump to the first modification
-		int length = min(old.length(), qcontent.length());
-		int pos = 0;
-		for (; pos < length && old.at(pos) == qcontent.at(pos); ++pos) {}
-		QTextCursor c = QTextCursor(viewSourceTV->document());
-		//get some space below the cursor
-		c.setPosition(pos);
-		c.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor,v_margin);
-		viewSourceTV->setTextCursor(c);
-		//get some space on the right of the cursor
-		viewSourceTV->horizontalScrollBar()->setValue(h_scroll);
-		c.setPosition(pos);
-		const int block = c.blockNumber();
-		for (int i = h_margin; i && block == c.blockNumber(); --i) {
-			c.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor);
-		}
-		c.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor);
-		viewSourceTV->setTextCursor(c);
-		//back to the position
-		c.setPosition(pos);
-		//c.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,1);
-		viewSourceTV->setTextCursor(c);
-
-	} else if (texrow_) {
-		// Use the available position-to-row conversion to highlight
-		// the current selection in the source
-		std::pair<int,int> rows = texrow_->rowFromCursor(bv->cursor());
-		int const beg_row = rows.first;
-		int const end_row = rows.second;
-
-		QTextCursor c = QTextCursor(viewSourceTV->document());
-
-		c.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor,
-					   beg_row - 1);
-		const int beg_sel = c.position();
-		//get some space above the cursor
-		c.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor,
-					   v_margin);
-		viewSourceTV->setTextCursor(c);
-		c.setPosition(beg_sel, QTextCursor::MoveAnchor);
-
-		c.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor,
-					   end_row - beg_row +1);
-		const int end_sel = c.position();
-		//get some space below the cursor
-		c.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor,
-					   v_margin - 1);
-		viewSourceTV->setTextCursor(c);
-		c.setPosition(end_sel, QTextCursor::KeepAnchor);
-
-		viewSourceTV->setTextCursor(c);
-
-		//the real highlighting is done with an ExtraSelection
-		QTextCharFormat format;
-		{
-		// We create a new color with the slightly altered lightness
-		// of the Base and the hue and saturation of the Highlight brush
-		QPalette const palette = viewSourceTV->palette();
-		QBrush extraselbrush = palette.base();
-		int const extrasellightness =
-				(palette.text().color().black() > palette.window().color().black()) ?
-					extraselbrush.color().darker(107).lightness()// light mode
-				      : extraselbrush.color().darker().lightness();// dark mode
-		QColor const highlight = palette.highlight().color().toHsl();
-		QColor const extraselcol = QColor::fromHsl(highlight.hue(),
-							   highlight.hslSaturation(),
-							   extrasellightness);
-		extraselbrush.setColor(extraselcol);
-		format.setBackground(extraselbrush);
-		}
-		format.setProperty(QTextFormat::FullWidthSelection, true);
-		QTextEdit::ExtraSelection sel;
-		sel.format = format;
-		sel.cursor = c;
-		viewSourceTV->setExtraSelections(
-			QList<QTextEdit::ExtraSelection>() << sel);
+	if (!setText(qcontent) || texrow_)
+		return;
+
+	// position-to-row is unavailable
+	// we jump to the first modification
+	int length = min(old.length(), qcontent.length());
+	int pos = 0;
+	for (; pos < length && old.at(pos) == qcontent.at(pos); ++pos) {}
+	QTextCursor c = QTextCursor(viewSourceTV->document());
+	//get some space below the cursor
+	c.setPosition(pos);
+	c.movePosition(QTextCursor::Down, QTextCursor::MoveAnchor,v_margin);
+	viewSourceTV->setTextCursor(c);
+	//get some space on the right of the cursor
+	viewSourceTV->horizontalScrollBar()->setValue(h_scroll);
+	c.setPosition(pos);
+	const int block = c.blockNumber();
+	for (int i = h_margin; i && block == c.blockNumber(); --i) {
+		c.movePosition(QTextCursor::Right, QTextCursor::MoveAnchor);
+	}
+	c.movePosition(QTextCursor::Left, QTextCursor::MoveAnchor);
+	viewSourceTV->setTextCursor(c);
+	//back to the position
+	c.setPosition(pos);
+	//c.movePosition(QTextCursor::Right, QTextCursor::KeepAnchor,1);
+	viewSourceTV->setTextCursor(c);
+}
+
+
+void ViewSourceWidget::highlightCursor(BufferView const & bv)
+{
+	// we will try to get that much space around the cursor
+	int const v_margin = 3;
+	// we will try to preserve this
+	int const h_scroll = viewSourceTV->horizontalScrollBar()->value();
 
-		//clean up
-		c.clearSelection();
-		viewSourceTV->setTextCursor(c);
-		viewSourceTV->horizontalScrollBar()->setValue(h_scroll);
-	} // else if (texrow)
+	// prevent gotoCursor()
+	QSignalBlocker blocker(viewSourceTV);
+
+	// Use the available position-to-row conversion to highlight
+	// the current selection in the source
+	std::pair<int,int> rows = texrow_->rowFromCursor(bv.cursor());
+	int const beg_row = rows.first;
+	int const end_row = rows.second;
+
+	QTextCursor c = QTextCursor(viewSourceTV->document());
+
+	c.movePosition(QTextCursor::NextBlock, QTextCursor::MoveAnchor,
+				   beg_row - 1);
+	const int beg_sel = c.position();
+	//get some space above the cursor
+	c.movePosition(QTextCursor::PreviousBlock, QTextCursor::MoveAnchor,
+				   v_margin);
+	viewSourceTV->setTextCursor(c);
+	c.setPosition(beg_sel, QTextCursor::MoveAnchor);
+
+	c.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor,
+				   end_row - beg_row +1);
+	const int end_sel = c.position();
+	//get some space below the cursor
+	c.movePosition(QTextCursor::NextBlock, QTextCursor::KeepAnchor,
+				   v_margin - 1);
+	viewSourceTV->setTextCursor(c);
+	c.setPosition(end_sel, QTextCursor::KeepAnchor);
+
+	viewSourceTV->setTextCursor(c);
+
+	//the real highlighting is done with an ExtraSelection
+	QTextCharFormat format;
+	{
+	// We create a new color with the slightly altered lightness
+	// of the Base and the hue and saturation of the Highlight brush
+	QPalette const palette = viewSourceTV->palette();
+	QBrush extraselbrush = palette.base();
+	int const extrasellightness =
+			(palette.text().color().black() > palette.window().color().black()) ?
+				extraselbrush.color().darker(107).lightness()// light mode
+			      : extraselbrush.color().darker().lightness();// dark mode
+	QColor const highlight = palette.highlight().color().toHsl();
+	QColor const extraselcol = QColor::fromHsl(highlight.hue(),
+						   highlight.hslSaturation(),
+						   extrasellightness);
+	extraselbrush.setColor(extraselcol);
+	format.setBackground(extraselbrush);
+	}
+	format.setProperty(QTextFormat::FullWidthSelection, true);
+	QTextEdit::ExtraSelection sel;
+	sel.format = format;
+	sel.cursor = c;
+	viewSourceTV->setExtraSelections(
+		QList<QTextEdit::ExtraSelection>() << sel);
+
+	//clean up
+	c.clearSelection();
+	viewSourceTV->setTextCursor(c);
+	viewSourceTV->horizontalScrollBar()->setValue(h_scroll);
 }
 
 
@@ -429,7 +588,7 @@ GuiViewSource::GuiViewSource(GuiView & parent,
 
 void GuiViewSource::onBufferViewChanged()
 {
-	widget_->setText();
+	widget_->reset();
 	widget_->setEnabled(static_cast<bool>(bufferview()));
 }
 
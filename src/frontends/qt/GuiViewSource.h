@@ -20,8 +20,13 @@
 #include "DockView.h"
 
 #include <QDockWidget>
+#include <QElapsedTimer>
+#include <QFutureWatcher>
 #include <QString>
 
+#include <memory>
+#include <string>
+
 
 class QTextDocument;
 
@@ -44,8 +49,12 @@ class ViewSourceWidget : public QWidget, public Ui::ViewSourceUi
 
 public:
 	ViewSourceWidget(QWidget * parent);
+	/// waits for the source code being generated
+	~ViewSourceWidget();
 	/// returns true if the string has changed
 	bool setText(QString const & qstr = QString());
+	/// forget the current contents and the source code being generated
+	void reset();
 	///
 	void saveSession(QSettings & settings, QString const & session_key) const;
 	///
@@ -74,10 +83,50 @@ public Q_SLOTS:
 Q_SIGNALS:
 	void needUpdate() const;
 
+private Q_SLOTS:
+	/// show the source code generated in the background
+	void sourceGenerated();
+
 private:
+	/// What the source code is generated from
+	struct SourceKey {
+		///
+		Buffer const * buffer = nullptr;
+		/// the id of the buffer at generation time
+		int id = -1;
+		///
+		std::string format;
+		///
+		Buffer::OutputWhat output = Buffer::FullSource;
+		///
+		pit_type par_begin = 0;
+		///
+		pit_type par_end = 0;
+		///
+		bool master = false;
+		/// whether the TexRow information is shown
+		bool texrow_info = false;
+		///
+		bool operator==(SourceKey const & key) const;
+	};
+	/// The result of the generation of the source code
+	struct GeneratedSource {
+		///
+		docstring str;
+		///
+		std::shared_ptr<TexRow> texrow;
+	};
+	/// Get the source code of the whole document from a clone of the
+	/// buffer, and delete the clone. Runs in a worker thread.
+	static GeneratedSource generateAndDestroy(Buffer * clone,
+		std::string const & format, Buffer::OutputWhat output, bool master);
 	/// Get the source code of selected paragraphs, or the whole document.
 	void getContent(BufferView const & view, Buffer::OutputWhat output,
 			   docstring & str, std::string const & format, bool master);
+	/// Show \p content, generated for \p key
+	void showContent(docstring const & content, SourceKey const & key);
+	/// Highlight the source code of the cursor or selection of \p bv
+	void highlightCursor(BufferView const & bv);
 	/// Grab double clicks on the viewport
 	bool eventFilter(QObject * obj, QEvent * event) override;
 	///
@@ -88,7 +137,19 @@ private:
 	std::string view_format_;
 	/// TexRow information from the last source view. If TexRow is unavailable
 	/// for the last format then texrow_ is null.
-	std::unique_ptr<TexRow> texrow_;
+	std::shared_ptr<TexRow> texrow_;
+	/// The contents of document_
+	QString text_;
+	/// What the contents of document_ have been generated from
+	SourceKey shown_key_;
+	/// What the source code being generated is generated from
+	SourceKey running_key_;
+	///
+	QFutureWatcher<GeneratedSource> generator_;
+	/// Measures the time taken by the last generation
+	QElapsedTimer generation_timer_;
+	/// in milliseconds
+	qint64 generation_time_ = 0;
 };
 
 
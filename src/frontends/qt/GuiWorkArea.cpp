@@ -72,6 +72,8 @@
 
 #include <array> //Needed for Windows (preeditCaretOffset())
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #undef KeyPress
@@ -363,9 +365,12 @@ void GuiWorkArea::toggleCaret()
 
 void GuiWorkArea::scheduleRedraw(bool update_metrics)
 {
-	if (!isVisible() || view().busy())
-		// No need to redraw in this case.
+	if (!isVisible() || view().busy()) {
+		// No need to redraw in this case. However, the screen
+		// contents are not going to be shifted.
+		d->buffer_view_->discardScrollBlit();
 		return;
+	}
 
 	// No need to do anything if this is the current view. The BufferView
 	// metrics are already up to date.
@@ -382,7 +387,16 @@ void GuiWorkArea::scheduleRedraw(bool update_metrics)
 	d->resetCaret();
 
 	LYXERR(Debug::WORKAREA, "WorkArea::redraw screen");
-	viewport()->update();
+	// When only scrolling happened, let Qt move the existing pixels;
+	// only the exposed part will be updated. With a backingstore,
+	// the shift happens in paintEvent.
+	int const scroll = d->buffer_view_->scrollBlitOffset();
+	if (!d->use_backingstore_ && d->buffer_view_->scrollBlitPending()) {
+		if (scroll != d->scrolled_)
+			viewport()->scroll(0, scroll - d->scrolled_);
+		d->scrolled_ = scroll;
+	} else
+		viewport()->update();
 
 	/// FIXME: is this still true now that paintEvent does the actual painting?
 	/// \warning: scrollbar updating *must* be done after the BufferView is drawn
@@ -1281,6 +1295,25 @@ QPaintDevice * GuiWorkArea::Private::screenDevice()
 }
 
 
+bool GuiWorkArea::Private::scrollScreen(int const dy)
+{
+	// The shift has to be a whole number of device pixels
+	double const pr = p->pixelRatio();
+	int const dys = int(lround(dy * pr));
+	if (dys != dy * pr || abs(dys) >= screen_.height())
+		return false;
+
+	int const bpl = int(screen_.bytesPerLine());
+	int const h = screen_.height();
+	uchar * bits = screen_.bits();
+	if (dys > 0)
+		memmove(bits + dys * bpl, bits, size_t(h - dys) * bpl);
+	else if (dys < 0)
+		memmove(bits, bits - dys * bpl, size_t(h + dys) * bpl);
+	return true;
+}
+
+
 void GuiWorkArea::Private::updateScreen(QRectF const & rc)
 {
 	if (use_backingstore_) {
@@ -1318,6 +1351,12 @@ void GuiWorkArea::paintEvent(QPaintEvent * ev)
 
 	d->last_pixel_ratio_ = pixelRatio();
 
+	// Reuse what is already on screen when only scrolling happened.
+	int const scroll = d->buffer_view_->scrollBlitOffset();
+	if (d->use_backingstore_ && scroll != 0 && !d->scrollScreen(scroll))
+		d->buffer_view_->discardScrollBlit();
+	d->scrolled_ = 0;
+
 	GuiPainter pain(d->screenDevice(), pixelRatio(), d->lyx_view_->develMode());
 
 	d->buffer_view_->draw(pain, d->caret_visible_);
@@ -108,6 +108,9 @@ struct GuiWorkArea::Private
 	QPaintDevice * screenDevice();
 	/// Put backingstore to screen if necessary
 	void updateScreen(QRectF const & rc);
+	/// Move the contents of the backingstore vertically by \p dy
+	/// pixels. Return false if this is not possible.
+	bool scrollScreen(int dy);
 
 	///
 	GuiWorkArea * p = nullptr;
@@ -120,6 +123,9 @@ struct GuiWorkArea::Private
 	bool use_backingstore_ = false;
 	///
 	QImage screen_;
+	/// Vertical scrolling that has already been applied to the
+	/// viewport since last paint event (when not using backingstore)
+	int scrolled_ = 0;
 
 	/// is the caret currently displayed
 	bool caret_visible_ = false;
@@ -101,6 +101,9 @@ void TocModel::clear()
 	model_->blockSignals(true);
 	model_->clear();
 	toc_ = make_shared<Toc>();
+	index_ = TocIndex(*toc_);
+	items_.clear();
+	depths_.clear();
 	model_->blockSignals(false);
 }
 
@@ -124,15 +127,12 @@ QModelIndex TocModel::modelIndex(DocIterator const & dit) const
 	if (toc_->empty())
 		return QModelIndex();
 
-	unsigned int const toc_index =
-		static_cast<unsigned int>(TocBackend::findItem(*toc_, dit) - toc_->begin());
-
-	QModelIndexList list = model()->match(model()->index(0, 0), Qt::UserRole,
-		QVariant(toc_index), 1,
-		Qt::MatchFlags(Qt::MatchExactly | Qt::MatchRecursive));
-
-	LASSERT(!list.isEmpty(), return QModelIndex());
-	return list[0];
+	size_t const toc_index = index_.find(*toc_, dit) - toc_->begin();
+	LASSERT(toc_index < items_.size(), return QModelIndex());
+	QModelIndex const index = items_[toc_index]->index();
+	if (is_sorted_)
+		return sorted_model_->mapFromSource(index);
+	return index;
 }
 
 
@@ -158,16 +158,47 @@ void TocModel::updateItem(DocIterator const & dit)
 }
 
 
+bool TocModel::hasShape(Toc const & toc) const
+{
+	if (toc.size() != depths_.size())
+		return false;
+	for (size_t i = 0; i != toc.size(); ++i)
+		if (toc[i].depth() != depths_[i])
+			return false;
+	return true;
+}
+
+
 void TocModel::reset(shared_ptr<Toc const> const & toc)
 {
-	toc_ = toc;
-	if (toc_->empty()) {
+	if (toc->empty()) {
+		clear();
+		toc_ = toc;
 		maxdepth_ = 0;
 		mindepth_ = 0;
 		reset();
 		return;
 	}
 
+	if (hasShape(*toc)) {
+		// Usually, an update only changes the text of some items. Then
+		// the tree is kept, and the views only redraw the changed rows.
+		toc_ = toc;
+		index_ = TocIndex(*toc_);
+		for (size_t i = 0; i != toc_->size(); ++i) {
+			TocItem const & item = (*toc_)[i];
+			if (items_[i]->text() != toqstr(item.asString()))
+				setString(item, items_[i]->index());
+		}
+		return;
+	}
+
+	clear();
+	toc_ = toc;
+	index_ = TocIndex(*toc_);
+	items_.resize(toc_->size());
+	depths_.resize(toc_->size());
+
 	model_->blockSignals(true);
 	model_->beginResetModel();
 	model_->insertColumns(0, 1);
@@ -184,6 +215,8 @@ void TocModel::reset(shared_ptr<Toc const> const & toc)
 		QModelIndex top_level_item = model_->index(current_row, 0);
 		setString(item, top_level_item);
 		model_->setData(top_level_item, index, Qt::UserRole);
+		items_[index] = model_->itemFromIndex(top_level_item);
+		depths_[index] = item.depth();
 
 		LYXERR(Debug::GUI, "Toc: at depth " << item.depth()
 			<< ", added item " << item.asString());
@@ -224,6 +257,8 @@ void TocModel::populate(unsigned int & index, QModelIndex const & parent)
 		child_item = model_->index(current_row, 0, parent);
 		setString(item, child_item);
 		model_->setData(child_item, index, Qt::UserRole);
+		items_[index] = model_->itemFromIndex(child_item);
+		depths_[index] = item.depth();
 		populate(index, child_item);
 		if (index >= end)
 			break;
@@ -355,8 +390,8 @@ TocModels::~TocModels(){
 
 void TocModels::reset(BufferView const * bv)
 {
-	clear();
 	if (!bv) {
+		clear();
 		iterator end = models_.end();
 		for (iterator it = models_.begin(); it != end;  ++it)
 			it.value()->reset();
@@ -364,11 +399,20 @@ void TocModels::reset(BufferView const * bv)
 		return;
 	}
 
+	// The models of the remaining Tocs are updated in place below
+	TocBackend const & backend = bv->buffer().masterBuffer()->tocBackend();
+	names_->blockSignals(true);
+	names_->clear();
+	names_->blockSignals(false);
+	iterator end = models_.end();
+	for (iterator it = models_.begin(); it != end;  ++it)
+		if (backend.tocs().find(fromqstr(it.key())) == backend.tocs().end())
+			it.value()->clear();
+
 	names_->blockSignals(true);
 	names_->beginResetModel();
 	names_->insertColumns(0, 1);
 	// In the outliner, add Tocs from the master document
-	TocBackend const & backend = bv->buffer().masterBuffer()->tocBackend();
 	for (auto const & toc : backend.tocs()) {
 		QString const type = toqstr(toc.first);
 
@@ -12,11 +12,15 @@
 #ifndef TOCMODEL_H
 #define TOCMODEL_H
 
-#include "Toc.h"
+#include "TocBackend.h"
 
 #include <QHash>
 #include <QSortFilterProxyModel>
 
+#include <vector>
+
+class QStandardItem;
+
 namespace lyx {
 
 class BufferView;
@@ -66,6 +70,8 @@ public:
 private:
 	///
 	void populate(unsigned int & index, QModelIndex const & parent);
+	/// Whether the items of \p toc have the same depths as the ones shown
+	bool hasShape(Toc const & toc) const;
 	///
 	void setString(TocItem const & item, QModelIndex index);
 	///
@@ -77,6 +83,12 @@ private:
 	///
 	std::shared_ptr<Toc const> toc_;
 	///
+	TocIndex index_;
+	/// The model item of each Toc item
+	std::vector<QStandardItem *> items_;
+	/// The depth of each Toc item
+	std::vector<int> depths_;
+	///
 	int maxdepth_;
 	///
 	int mindepth_;
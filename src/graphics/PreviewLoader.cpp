@@ -572,6 +572,7 @@ void PreviewLoader::Impl::remove(docstring const & latex_snippet)
 
 void PreviewLoader::Impl::startLoading(bool wait)
 {
+	LYXTRACE("PreviewLoader::startLoading");
 	if (pending_.empty() || !pconverter_)
 		return;
 
@@ -736,6 +737,7 @@ double PreviewLoader::displayPixelRatio() const
 
 void PreviewLoader::Impl::finishedGenerating(pid_t pid, int retval)
 {
+	LYXTRACE("PreviewLoader::finishedGenerating");
 	// Paranoia check!
 	InProgressProcesses::iterator git = in_progress_.find(pid);
 	if (git == in_progress_.end()) {
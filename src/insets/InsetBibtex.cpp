@@ -33,6 +33,7 @@
 
 #include "frontends/alert.h"
 
+#include "support/checksum.h"
 #include "support/convert.h"
 #include "support/debug.h"
 #include "support/docstream.h"
@@ -42,12 +43,19 @@
 #include "support/filetools.h"
 #include "support/gettext.h"
 #include "support/lstrings.h"
+#include "support/mutex.h"
 #include "support/os.h"
+#include "support/Package.h"
 #include "support/textutils.h"
 
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iomanip>
 #include <limits>
 #include <map>
 #include <regex>
+#include <sstream>
 #include <utility>
 
 #include <iostream>
@@ -419,11 +427,74 @@ namespace {
 
 	typedef map<docstring, docstring> VarMap;
 
+	/// Buffered reading of a bib file. Getting the characters one
+	/// by one from the ifdocstream itself is slow, so we read them
+	/// in chunks. This mimics the few istream methods that the
+	/// parser needs.
+	class BibStream {
+	public:
+		///
+		explicit BibStream(ifdocstream & ifs) : ifs_(ifs), good_(bool(ifs)) {}
+		/// false when the end of the file has been reached
+		explicit operator bool() const { return good_; }
+		/// read the next character; \p c is unchanged at end of file
+		BibStream & get(char_type & c)
+		{
+			if (pos_ == end_ && !fill())
+				good_ = false;
+			else
+				c = buf_[pos_++];
+			return *this;
+		}
+		/// put back the character that has just been read
+		void putback(char_type)
+		{
+			if (good_ && pos_ > 0)
+				--pos_;
+		}
+		/// skip the rest of the current line
+		void ignoreLine()
+		{
+			char_type c;
+			while (get(c) && c != '\n')
+				;
+		}
+	private:
+		///
+		bool fill()
+		{
+			if (!good_)
+				return false;
+			// Keep the last character around for putback()
+			pos_ = 0;
+			if (end_ > 0) {
+				buf_[0] = buf_[end_ - 1];
+				pos_ = 1;
+			}
+			ifs_.read(buf_ + pos_, bufsize - pos_);
+			end_ = pos_ + size_t(ifs_.gcount());
+			return end_ > pos_;
+		}
+		///
+		static size_t const bufsize = 8192;
+		///
+		ifdocstream & ifs_;
+		///
+		char_type buf_[bufsize];
+		///
+		size_t pos_ = 0;
+		///
+		size_t end_ = 0;
+		///
+		bool good_;
+	};
+
+
 	/// remove whitespace characters, optionally a single comma,
 	/// and further whitespace characters from the stream.
 	/// @return true if a comma was found, false otherwise
 	///
-	bool removeWSAndComma(ifdocstream & ifs) {
+	bool removeWSAndComma(BibStream & ifs) {
 		char_type ch;
 
 		if (!ifs)
@@ -466,7 +537,7 @@ namespace {
 	///
 	/// @return true if a string of length > 0 could be read.
 	///
-	bool readTypeOrKey(docstring & val, ifdocstream & ifs,
+	bool readTypeOrKey(docstring & val, BibStream & ifs,
 		docstring const & delimChars, docstring const & illegalChars,
 		charCase chCase) {
 
@@ -519,7 +590,7 @@ namespace {
 	/// the variable strings.
 	/// @return true if reading was successful (all single parts were delimited
 	/// correctly)
-	bool readValue(docstring & val, ifdocstream & ifs, const VarMap & strings) {
+	bool readValue(docstring & val, BibStream & ifs, const VarMap & strings) {
 
 		char_type ch;
 
@@ -649,63 +720,45 @@ namespace {
 
 		return true;
 	}
-} // namespace
-
 
-void InsetBibtex::collectBibKeys(InsetIterator const & /*di*/, FileNameList & checkedFiles) const
-{
-	parseBibTeXFiles(checkedFiles);
-}
+	/// A citation entry read from a bib file, with its fields in the
+	/// order of the file.
+	struct BibFileEntry {
+		///
+		docstring key;
+		///
+		docstring type;
+		///
+		vector<pair<docstring, docstring>> fields;
+	};
 
+	typedef function<void (BibFileEntry const &)> BibEntryHandler;
 
-void InsetBibtex::parseBibTeXFiles(FileNameList & checkedFiles) const
-{
-	// This bibtex parser is a first step to parse bibtex files
-	// more precisely.
-	//
-	// - it reads the whole bibtex entry and does a syntax check
-	//   (matching delimiters, missing commas,...
-	// - it recovers from errors starting with the next @-character
-	// - it reads @string definitions and replaces them in the
-	//   field values.
-	// - it accepts more characters in keys or value names than
-	//   bibtex does.
-	//
-	// Officially bibtex does only support ASCII, but in practice
-	// you can use any encoding as long as some elements like keys
-	// and names are pure ASCII. We support specifying an encoding,
-	// and we convert the file from that (default is buffer encoding).
-	// We don't restrict keys to ASCII in LyX, since our own
-	// InsetBibitem can generate non-ASCII keys, and nonstandard
-	// 8bit clean bibtex forks exist.
-
-	BiblioInfo keylist;
 
-	docstring_list const files = getBibFiles();
-	for (auto const & bf : files) {
-		FileName const bibfile = buffer().getBibfilePath(bf);
-		if (bibfile.empty()) {
-			LYXERR0("Unable to find path for " << bf << "!");
-			continue;
+	/// add a parsed entry to the bibliography information
+	void addBibFileEntry(BiblioInfo & keylist, BibFileEntry const & entry)
+	{
+		docstring data;
+		BibTeXInfo keyvalmap(entry.key, entry.type);
+		for (auto const & [name, value] : entry.fields) {
+			keyvalmap[name] = value;
+			data += "\n\n" + value;
+			keylist.addFieldName(name);
 		}
-		if (find(checkedFiles.begin(), checkedFiles.end(), bibfile) != checkedFiles.end())
-			// already checked this one. Skip.
-			continue;
-		else
-			// record that we check this.
-			checkedFiles.push_back(bibfile);
-		string encoding = buffer().masterParams().encoding().iconvName();
-		string ienc = buffer().masterParams().bibFileEncoding(to_utf8(bf));
-		if (ienc.empty() || ienc == "general")
-			ienc = to_ascii(params()["encoding"]);
+		keylist.addEntryType(entry.type);
+		keyvalmap.setAllData(data);
+		keylist[entry.key] = keyvalmap;
+	}
 
-		if (!ienc.empty() && ienc != "auto-legacy-plain" && ienc != "auto-legacy" && encodings.fromLyXName(ienc))
-			encoding = encodings.fromLyXName(ienc)->iconvName();
-		ifdocstream ifs(bibfile.toFilesystemEncoding().c_str(),
-			ios_base::in, encoding);
 
+	/// Parse the contents of a bib file and pass every citation entry
+	/// to \p handle.
+	void parseBibFile(ifdocstream & is, BibEntryHandler const & handle)
+	{
+		BibStream ifs(is);
 		char_type ch;
 		VarMap strings;
+		BibFileEntry entry;
 
 		while (ifs) {
 			ifs.get(ch);
@@ -728,7 +781,7 @@ void InsetBibtex::parseBibTeXFiles(FileNameList & checkedFiles) const
 			}
 
 			if (entryType == from_ascii("comment")) {
-				ifs.ignore(numeric_limits<int>::max(), '\n');
+				ifs.ignoreLine();
 				continue;
 			}
 
@@ -807,16 +860,17 @@ void InsetBibtex::parseBibTeXFiles(FileNameList & checkedFiles) const
 
 				/////////////////////////////////////////////
 				// now we have a key, so we will add an entry
- 				// (even if it's empty, as bibtex does)
+				// (even if it's empty, as bibtex does)
 				//
 				// we now read the field = value pairs.
- 				// all items must be separated by a comma. If
- 				// it is missing the scanning of this entry is
- 				// stopped and the next is searched.
+				// all items must be separated by a comma. If
+				// it is missing the scanning of this entry is
+				// stopped and the next is searched.
 				docstring name;
 				docstring value;
-				docstring data;
-				BibTeXInfo keyvalmap(key, entryType);
+				entry.key = key;
+				entry.type = entryType;
+				entry.fields.clear();
 
 				bool readNext = removeWSAndComma(ifs);
 
@@ -848,18 +902,259 @@ void InsetBibtex::parseBibTeXFiles(FileNameList & checkedFiles) const
 						break;
 					}
 
-					keyvalmap[name] = value;
-					data += "\n\n" + value;
-					keylist.addFieldName(name);
+					entry.fields.emplace_back(name, value);
 					readNext = removeWSAndComma(ifs);
 				}
 
 				// add the new entry
-				keylist.addEntryType(entryType);
-				keyvalmap.setAllData(data);
-				keylist[key] = keyvalmap;
+				handle(entry);
 			} //< else (citation entry)
 		} //< searching '@'
+	}
+
+
+	// Cache of parsed bib files
+	//
+	// Parsing a big bib file is slow, so we store the citation entries
+	// in a binary file in the user directory. It is reused as long as
+	// the checksum of the bib file and the encoding used to read it are
+	// the same. The cache is only meant to be read by the same LyX
+	// binary: strings are stored as raw char_type arrays.
+
+	// The version has to be changed whenever the format changes.
+	char const bib_cache_magic[] = "LyXBibCache 1\n";
+
+	// Protects the writing of the cache files
+	Mutex bib_cache_mutex;
+
+
+	FileName bibCacheFile(FileName const & bibfile, string const & encoding)
+	{
+		if (package().user_support().empty())
+			return FileName();
+		FileName const dir(addName(package().user_support().absFileName(), "bibcache"));
+		if (!dir.exists() && !dir.createDirectory(0700)) {
+			LYXERR(Debug::FILES, "Could not create bib cache directory " << dir);
+			return FileName();
+		}
+		ostringstream os;
+		os << setw(10) << setfill('0')
+		   << checksum(bibfile.absFileName() + '\n' + encoding) << ".bib";
+		return FileName(addName(dir.absFileName(), os.str()));
+	}
+
+
+	void writeCacheInt(ostream & os, uint64_t const i)
+	{
+		os.write(reinterpret_cast<char const *>(&i), sizeof(i));
+	}
+
+
+	void writeCacheString(ostream & os, docstring const & s)
+	{
+		writeCacheInt(os, s.size());
+		os.write(reinterpret_cast<char const *>(s.data()),
+		         streamsize(s.size() * sizeof(char_type)));
+	}
+
+
+	bool readCacheInt(istream & is, uint64_t & i)
+	{
+		return bool(is.read(reinterpret_cast<char *>(&i), sizeof(i)));
+	}
+
+
+	// \p left is the number of bytes left in the file, which protects
+	// against bogus sizes in broken files.
+	bool readCacheString(istream & is, docstring & s, uint64_t & left)
+	{
+		uint64_t size;
+		if (!readCacheInt(is, size) || size > left / sizeof(char_type))
+			return false;
+		left -= size * sizeof(char_type);
+		s.resize(size);
+		return bool(is.read(reinterpret_cast<char *>(&s[0]),
+		                    streamsize(size * sizeof(char_type))));
+	}
+
+
+	/// Pass the entries stored in \p cache to \p handle.
+	/// \return false if the cache does not exist or does not match.
+	bool readBibCache(FileName const & cache, unsigned long const sum,
+	                  string const & encoding, BibEntryHandler const & handle)
+	{
+		ifstream is(cache.toSafeFilesystemEncoding().c_str(),
+		            ios_base::in | ios_base::binary | ios_base::ate);
+		if (!is)
+			return false;
+		uint64_t left = uint64_t(is.tellg());
+		is.seekg(0);
+
+		string magic(sizeof(bib_cache_magic) - 1, '\0');
+		uint64_t file_sum;
+		docstring enc;
+		if (!is.read(&magic[0], streamsize(magic.size()))
+		    || magic != bib_cache_magic
+		    || !readCacheInt(is, file_sum) || file_sum != sum
+		    || !readCacheString(is, enc, left) || enc != from_ascii(encoding))
+			return false;
+
+		// Entries are preceded by their number of fields; the list
+		// is terminated by a field count of max uint64_t.
+		BibFileEntry entry;
+		uint64_t nfields;
+		while (readCacheInt(is, nfields)) {
+			if (nfields == numeric_limits<uint64_t>::max())
+				return true;
+			if (!readCacheString(is, entry.key, left)
+			    || !readCacheString(is, entry.type, left)
+			    || nfields > left)
+				return false;
+			entry.fields.resize(nfields);
+			for (auto & [name, value] : entry.fields)
+				if (!readCacheString(is, name, left)
+				    || !readCacheString(is, value, left))
+					return false;
+			handle(entry);
+		}
+		return false;
+	}
+
+
+	/// Writes a cache file. The contents replace the existing cache
+	/// only when commit() is called.
+	class BibCacheWriter {
+	public:
+		///
+		BibCacheWriter(FileName const & cache, unsigned long const sum,
+		               string const & encoding)
+			: cache_(cache), tmp_(cache.absFileName() + ".tmp"),
+			  locker_(&bib_cache_mutex),
+			  os_(tmp_.toSafeFilesystemEncoding(os::CREATE).c_str(),
+			      ios_base::out | ios_base::trunc | ios_base::binary)
+		{
+			os_.write(bib_cache_magic, sizeof(bib_cache_magic) - 1);
+			writeCacheInt(os_, sum);
+			writeCacheString(os_, from_ascii(encoding));
+		}
+		///
+		~BibCacheWriter()
+		{
+			if (os_.is_open()) {
+				os_.close();
+				tmp_.removeFile();
+			}
+		}
+		///
+		void write(BibFileEntry const & entry)
+		{
+			writeCacheInt(os_, entry.fields.size());
+			writeCacheString(os_, entry.key);
+			writeCacheString(os_, entry.type);
+			for (auto const & [name, value] : entry.fields) {
+				writeCacheString(os_, name);
+				writeCacheString(os_, value);
+			}
+		}
+		///
+		void commit()
+		{
+			writeCacheInt(os_, numeric_limits<uint64_t>::max());
+			os_.close();
+			if (!os_ || !tmp_.moveTo(cache_)) {
+				LYXERR(Debug::FILES, "Could not write bib cache " << cache_);
+				tmp_.removeFile();
+			}
+		}
+	private:
+		///
+		FileName const cache_;
+		///
+		FileName const tmp_;
+		///
+		Mutex::Locker locker_;
+		///
+		ofstream os_;
+	};
+
+} // namespace
+
+
+void InsetBibtex::collectBibKeys(InsetIterator const & /*di*/, FileNameList & checkedFiles) const
+{
+	parseBibTeXFiles(checkedFiles);
+}
+
+
+void InsetBibtex::parseBibTeXFiles(FileNameList & checkedFiles) const
+{
+	// This bibtex parser is a first step to parse bibtex files
+	// more precisely.
+	//
+	// - it reads the whole bibtex entry and does a syntax check
+	//   (matching delimiters, missing commas,...
+	// - it recovers from errors starting with the next @-character
+	// - it reads @string definitions and replaces them in the
+	//   field values.
+	// - it accepts more characters in keys or value names than
+	//   bibtex does.
+	//
+	// Officially bibtex does only support ASCII, but in practice
+	// you can use any encoding as long as some elements like keys
+	// and names are pure ASCII. We support specifying an encoding,
+	// and we convert the file from that (default is buffer encoding).
+	// We don't restrict keys to ASCII in LyX, since our own
+	// InsetBibitem can generate non-ASCII keys, and nonstandard
+	// 8bit clean bibtex forks exist.
+	//
+	// The parsed entries are stored in a cache (see readBibCache), so
+	// that unchanged files do not have to be parsed again.
+
+	BiblioInfo keylist;
+	auto const add = [&keylist](BibFileEntry const & entry) {
+		addBibFileEntry(keylist, entry);
+	};
+
+	docstring_list const files = getBibFiles();
+	for (auto const & bf : files) {
+		FileName const bibfile = buffer().getBibfilePath(bf);
+		if (bibfile.empty()) {
+			LYXERR0("Unable to find path for " << bf << "!");
+			continue;
+		}
+		if (find(checkedFiles.begin(), checkedFiles.end(), bibfile) != checkedFiles.end())
+			// already checked this one. Skip.
+			continue;
+		else
+			// record that we check this.
+			checkedFiles.push_back(bibfile);
+		string encoding = buffer().masterParams().encoding().iconvName();
+		string ienc = buffer().masterParams().bibFileEncoding(to_utf8(bf));
+		if (ienc.empty() || ienc == "general")
+			ienc = to_ascii(params()["encoding"]);
+
+		if (!ienc.empty() && ienc != "auto-legacy-plain" && ienc != "auto-legacy" && encodings.fromLyXName(ienc))
+			encoding = encodings.fromLyXName(ienc)->iconvName();
+
+		FileName const cache = bibCacheFile(bibfile, encoding);
+		unsigned long const sum = cache.empty() ? 0 : bibfile.checksum();
+		if (!cache.empty() && readBibCache(cache, sum, encoding, add)) {
+			LYXERR(Debug::FILES, "Using cached entries of " << bibfile);
+			continue;
+		}
+
+		ifdocstream ifs(bibfile.toFilesystemEncoding().c_str(),
+			ios_base::in, encoding);
+		if (cache.empty()) {
+			parseBibFile(ifs, add);
+			continue;
+		}
+		BibCacheWriter writer(cache, sum, encoding);
+		parseBibFile(ifs, [&](BibFileEntry const & entry) {
+			add(entry);
+			writer.write(entry);
+		});
+		writer.commit();
 	} //< for loop over files
 
 	buffer().addBiblioInfo(keylist);
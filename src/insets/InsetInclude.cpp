@@ -904,9 +904,19 @@ void InsetInclude::latex(otexstream & os, OutputParams const & runparams) const
 	runparams.par_begin = 0;
 	runparams.par_end = tmp->paragraphs().size();
 	runparams.is_child = true;
-	Buffer::ExportStatus retval =
-		tmp->makeLaTeXFile(tmpwritefile, masterFileName(buffer()).
-			onlyPath().absFileName(), runparams, Buffer::OnlyBody);
+	// Reuse the output of the last export if nothing relevant has
+	// changed. The external files are collected separately, so that
+	// they can be registered again in this case.
+	OutputParams child_runparams = runparams;
+	child_runparams.exportdata = make_shared<ExportData>();
+	Buffer::ExportStatus retval = Buffer::ExportSuccess;
+	if (!tmp->reuseChildLaTeXFile(tmpwritefile, child_runparams)) {
+		retval = tmp->makeLaTeXFile(tmpwritefile, masterFileName(buffer()).
+			onlyPath().absFileName(), child_runparams, Buffer::OnlyBody);
+		if (retval == Buffer::ExportSuccess)
+			tmp->cacheChildLaTeXFile(tmpwritefile, child_runparams);
+	}
+	runparams.exportdata->addExternalFiles(*child_runparams.exportdata);
 	if (retval == Buffer::ExportKilled && buffer().isClone() &&
 		  buffer().isExporting()) {
 	  // We really shouldn't get here, I don't think.
@@ -615,6 +615,7 @@ docstring const string2find(docstring const & argument,
 
 bool lyxfind(BufferView * bv, FuncRequest const & ev)
 {
+	LYXTRACE("lyxfind");
 	if (!bv || ev.action() != LFUN_WORD_FIND)
 		return false;
 
@@ -636,6 +637,7 @@ bool lyxfind(BufferView * bv, FuncRequest const & ev)
 
 bool lyxreplace(BufferView * bv, FuncRequest const & ev)
 {
+	LYXTRACE("lyxreplace");
 	if (!bv || ev.action() != LFUN_WORD_REPLACE)
 		return false;
 
@@ -33,6 +33,7 @@
 #include "mathed/InsetMathChar.h"
 #include "mathed/InsetMathUnknown.h"
 
+#include "frontends/FontLoader.h"
 #include "frontends/FontMetrics.h"
 #include "frontends/InputMethod.h"
 #include "frontends/Painter.h"
@@ -359,8 +360,25 @@ void MathData::metrics(MetricsInfo & mi, Dimension & dim, bool tight) const
 	slevel_ = (4 * xascent) / 5;
 	sshift_ = xascent / 4;
 
+	// Reuse the layout of the previous metrics update when possible.
+	MathRowMemo & memo = bv->mathRowMemo();
+	memo.validate(bv->buffer().id(), theFontLoader().generation());
+	MathRowMemo::Key const key(mi, tight);
+	bool const memoizable = layoutIsMemoizable(mi);
+	if (memoizable) {
+		if (memo.replay(this, key, dim)) {
+			display_style_ = mi.base.font.style() == DISPLAY_STYLE;
+			return;
+		}
+		memo.startRecording(this, key);
+	} else
+		memo.spoilRecordings();
+
 	MathRow mrow(mi, this);
 	mrow.metrics(mi, dim);
+	// This sets the cached values of the cell and of the insets in it
+	static unsigned long metrics_stamps = 0;
+	metrics_stamp_ = ++metrics_stamps;
 
 	// Set a minimal ascent/descent for the cell
 	if (tight)
@@ -382,11 +400,45 @@ void MathData::metrics(MetricsInfo & mi, Dimension & dim, bool tight) const
 	MathRow caret_row = MathRow(mrow.caret_dim);
 	for (auto const & e : mrow)
 		if (e.type == MathRow::BEGIN && e.md)
-			bv->setMathRow(e.md, caret_row);
+			memo.storeRow(e.md, caret_row);
 
 	// Cache row and dimension.
-	bv->setMathRow(this, mrow);
-	bv->coordCache().cells().add(this, dim);
+	memo.storeRow(this, mrow);
+	memo.storeCell(this, dim);
+	if (memoizable)
+		memo.stopRecording(dim);
+}
+
+
+bool MathData::layoutIsMemoizable(MetricsInfo const & mi) const
+{
+	// The layout of macros depends on too many things (macro
+	// definitions, editing mode...).
+	if (mi.base.macro_nesting != 0)
+		return false;
+	for (MathAtom const & at : *this)
+		if (at->asMacro() || at->asMacroTemplate())
+			return false;
+
+	// Nor can we reuse the layout of a cell that contains the cursor
+	// (selection, completion, input method preedit).
+	BufferView const * bv = mi.base.bv;
+	Cursor const & cur = bv->cursor();
+	for (size_t i = 0; i != cur.depth(); ++i) {
+		CursorSlice const & sl = cur[i];
+		if (!sl.inset().inMathed())
+			continue;
+		if (&sl.cell() == this)
+			return false;
+		// A selection can span several cells of the innermost inset
+		InsetMath const * inset = sl.inset().asInsetMath();
+		if (cur.selection() && i + 1 == cur.depth() && inset)
+			for (idx_type idx = 0; idx < inset->nargs(); ++idx)
+				if (&inset->cell(idx) == this)
+					return false;
+	}
+	DocIterator const & icp = bv->inlineCompletionPos();
+	return !icp.inMathed() || &icp.cell() != this;
 }
 
 
@@ -129,6 +129,8 @@ public:
 	/** When \c tight is true, the height of the cell will be at least
 	 *  the x height of the font. Otherwise, it will be the max height
 	 *  of the font.
+	 *  The layout of the previous update is reused when possible,
+	 *  see MathRowMemo.
 	 */
 	void metrics(MetricsInfo & mi, Dimension & dim, bool tight = true) const;
 	///
@@ -150,6 +152,8 @@ public:
 	MathClass lastMathClass() const;
 	/// is the cell in display style
 	bool displayStyle() const { return display_style_; }
+	/// identifies the last metrics computation of the cell, see MathRowMemo
+	unsigned long metricsStamp() const { return metrics_stamp_; }
 
 	/// access to cached x coordinate of last drawing
 	int xo(BufferView const & bv) const;
@@ -200,11 +204,15 @@ protected:
 	mutable int sshift_ = 0;
 	/// cached value for display style
 	mutable bool display_style_ = false;
+	/// changes with each metrics computation that is not replayed
+	mutable unsigned long metrics_stamp_ = 0;
 	Buffer * buffer_ = nullptr;
 
 private:
 	/// is this an exact match at this position?
 	bool find1(MathData const & md, size_type pos) const;
+	/// can the layout of this cell be recorded and reused later?
+	bool layoutIsMemoizable(MetricsInfo const & mi) const;
 
 	///
 	void detachMacroParameters(DocIterator * dit, size_type macroPos);
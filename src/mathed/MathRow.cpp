@@ -251,7 +251,7 @@ void MathRow::metrics(MetricsInfo & mi, Dimension & dim)
 	// arguments, it is necessary to keep track of them.
 	vector<pair<InsetMath const *, Dimension>> dim_insets;
 	vector<pair<MathData const *, Dimension>> dim_cells;
-	CoordCache & coords = mi.base.bv->coordCache();
+	MathRowMemo & memo = mi.base.bv->mathRowMemo();
 	for (Element & e : elements_) {
 		mi.base.macro_nesting = e.macro_nesting;
 		Dimension d;
@@ -263,7 +263,7 @@ void MathRow::metrics(MetricsInfo & mi, Dimension & dim)
 		case INSET:
 			e.inset->metrics(mi, d);
 			d.wid += e.before + e.after;
-			coords.insets().add(e.inset, d);
+			memo.storeInset(e.inset, d);
 			break;
 		case BEGIN:
 			if (e.inset) {
@@ -282,7 +282,7 @@ void MathRow::metrics(MetricsInfo & mi, Dimension & dim)
 				d = dim_insets.back().second;
 				afterMetricsMarkers(mi, e, d);
 				d.wid += e.before + e.after;
-				coords.insets().add(e.inset, d);
+				memo.storeInset(e.inset, d);
 				dim_insets.pop_back();
 				// We do not want to count the width again, but the
 				// padding and the vertical dimension are meaningful.
@@ -290,7 +290,7 @@ void MathRow::metrics(MetricsInfo & mi, Dimension & dim)
 			}
 			if (e.md) {
 				LATTEST(dim_cells.back().first == e.md);
-				coords.cells().add(e.md, dim_cells.back().second);
+				memo.storeCell(e.md, dim_cells.back().second);
 				dim_cells.pop_back();
 			}
 			break;
@@ -428,6 +428,120 @@ int MathRow::kerning(BufferView const * bv) const
 }
 
 
+MathRowMemo::Key::Key(MetricsInfo const & mi, bool t)
+	: font(mi.base.font), outer_font(mi.base.outer_font),
+	  fontname(mi.base.fontname), textwidth(mi.base.textwidth), tight(t)
+{}
+
+
+bool MathRowMemo::Key::operator==(Key const & key) const
+{
+	return font == key.font && outer_font == key.outer_font
+		&& fontname == key.fontname && textwidth == key.textwidth
+		&& tight == key.tight;
+}
+
+
+void MathRowMemo::validate(int buffer_id, int font_generation)
+{
+	if (buffer_id == buffer_id_ && font_generation == font_generation_)
+		return;
+	entries_.clear();
+	buffer_id_ = buffer_id;
+	font_generation_ = font_generation;
+}
+
+
+bool MathRowMemo::replay(MathData const * md, Key const & key, Dimension & dim)
+{
+	auto const it = entries_.find(md);
+	if (it == entries_.end() || !(it->second.key == key))
+		return false;
+
+	Entry const & entry = it->second;
+	// The values cached in the cells and insets are not replayed
+	for (Cell const & cell : entry.cells)
+		if (cell.md->metricsStamp() != cell.stamp)
+			return false;
+	for (auto const & row : entry.rows)
+		storeRow(row.first, row.second);
+	for (Cell const & cell : entry.cells)
+		storeCell(cell.md, cell.dim);
+	for (auto const & inset : entry.insets)
+		storeInset(inset.first, inset.second);
+	dim = entry.dim;
+	++replayed_;
+	return true;
+}
+
+
+void MathRowMemo::startRecording(MathData const * md, Key const & key)
+{
+	recordings_.push_back({md, Entry(key), false});
+}
+
+
+void MathRowMemo::stopRecording(Dimension const & dim)
+{
+	LASSERT(!recordings_.empty(), return);
+	Recording & rec = recordings_.back();
+	entries_.erase(rec.md);
+	if (!rec.spoilt) {
+		rec.entry.dim = dim;
+		entries_.emplace(rec.md, move(rec.entry));
+		++recorded_;
+	}
+	recordings_.pop_back();
+}
+
+
+void MathRowMemo::spoilRecordings()
+{
+	for (Recording & rec : recordings_)
+		if (!rec.spoilt) {
+			rec.spoilt = true;
+			// no need to keep this around
+			rec.entry = Entry(rec.entry.key);
+		}
+}
+
+
+void MathRowMemo::storeRow(MathData const * md, MathRow const & mrow)
+{
+	bv_.setMathRow(md, mrow);
+	for (Recording & rec : recordings_)
+		if (!rec.spoilt)
+			rec.entry.rows.emplace_back(md, mrow);
+}
+
+
+void MathRowMemo::storeCell(MathData const * md, Dimension const & dim)
+{
+	bv_.coordCache().cells().add(md, dim);
+	for (Recording & rec : recordings_)
+		if (!rec.spoilt)
+			rec.entry.cells.push_back({md, dim, md->metricsStamp()});
+}
+
+
+void MathRowMemo::storeInset(Inset const * inset, Dimension const & dim)
+{
+	bv_.coordCache().insets().add(inset, dim);
+	for (Recording & rec : recordings_)
+		if (!rec.spoilt)
+			rec.entry.insets.emplace_back(inset, dim);
+}
+
+
+pair<int, int> MathRowMemo::statistics()
+{
+	pair<int, int> const res(replayed_, recorded_);
+	replayed_ = 0;
+	recorded_ = 0;
+	return res;
+}
+
+
 ostream & operator<<(ostream & os, MathRow::Element const & e)
 {
 	switch (e.type) {
@@ -16,14 +16,19 @@
 
 #include "ColorCode.h"
 #include "Dimension.h"
+#include "FontInfo.h"
 
 #include "support/docstring.h"
 
+#include <string>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
 namespace lyx {
 
 class BufferView;
+class Inset;
 class InsetMath;
 class MathData;
 class MetricsInfo;
@@ -145,6 +150,131 @@ private:
 	Elements elements_;
 };
 
+/*
+ * Memo of the layout of the math cells of a BufferView.
+ *
+ * Most metrics updates do not change the contents of the math cells,
+ * and their layout is then the same as in the previous update. This
+ * class allows MathData::metrics() to reuse it.
+ *
+ * The layout of a cell stores the rows and dimensions of the cell and
+ * of its nested cells and insets in the caches of the BufferView. This
+ * is done through the store*() methods, so that it can be recorded and
+ * replayed later. Since the contents of math cells can be modified in
+ * many ways, the recorded layouts are only valid as long as the id of
+ * the buffer and the fonts do not change.
+ *
+ * The metrics computation also caches values in the cells and insets
+ * themselves (the grid of InsetMathGrid, the kerning of symbols, the
+ * style of the cells...), which are shared by all BufferViews and are
+ * not replayed. A layout is therefore only replayed if none of its cells
+ * has been computed again since it was recorded, for example by another
+ * BufferView with a different width.
+ */
+class MathRowMemo
+{
+public:
+	/// The parameters that the layout of a cell depends on
+	struct Key
+	{
+		///
+		Key(MetricsInfo const & mi, bool tight);
+		///
+		bool operator==(Key const & key) const;
+
+		///
+		FontInfo font;
+		///
+		FontInfo outer_font;
+		///
+		std::string fontname;
+		///
+		int textwidth;
+		///
+		bool tight;
+	};
+
+	///
+	explicit MathRowMemo(BufferView & bv) : bv_(bv) {}
+
+	/// Forget everything if the buffer contents or the fonts changed
+	void validate(int buffer_id, int font_generation);
+	/// Replay the layout of \p md if it has been recorded for \p key.
+	/// Returns false if no such layout exists.
+	bool replay(MathData const * md, Key const & key, Dimension & dim);
+	/// Start recording the layout of \p md
+	void startRecording(MathData const * md, Key const & key);
+	/// Stop the last recording and keep it if it is still valid
+	void stopRecording(Dimension const & dim);
+	/// The layouts being recorded cannot be reused, for example
+	/// because a nested cell depends on the cursor position.
+	void spoilRecordings();
+
+	/// Store the row of \p md in the BufferView
+	void storeRow(MathData const * md, MathRow const & mrow);
+	/// Store the dimension of \p md in the coord cache
+	void storeCell(MathData const * md, Dimension const & dim);
+	/// Store the dimension of \p inset in the coord cache
+	void storeInset(Inset const * inset, Dimension const & dim);
+
+	/// Number of replayed and recorded layouts since the last call
+	std::pair<int, int> statistics();
+
+private:
+	/// A cell of a recorded layout
+	struct Cell
+	{
+		///
+		MathData const * md;
+		///
+		Dimension dim;
+		/// The metrics stamp of md when it was recorded
+		unsigned long stamp;
+	};
+	/// A recorded layout
+	struct Entry
+	{
+		///
+		explicit Entry(Key const & k) : key(k) {}
+		///
+		Key key;
+		///
+		Dimension dim;
+		///
+		std::vector<std::pair<MathData const *, MathRow>> rows;
+		///
+		std::vector<Cell> cells;
+		///
+		std::vector<std::pair<Inset const *, Dimension>> insets;
+	};
+	/// A layout being recorded
+	struct Recording
+	{
+		///
+		MathData const * md;
+		///
+		Entry entry;
+		///
+		bool spoilt;
+	};
+
+	///
+	BufferView & bv_;
+	///
+	int buffer_id_ = -1;
+	///
+	int font_generation_ = -1;
+	///
+	std::unordered_map<MathData const *, Entry> entries_;
+	/// The layouts being recorded, innermost last
+	std::vector<Recording> recordings_;
+	///
+	int replayed_ = 0;
+	///
+	int recorded_ = 0;
+};
+
+
 ///
 std::ostream & operator<<(std::ostream & os, MathRow::Element const & elt);
 
@@ -55,4 +55,10 @@ bool openFileWrite(ofdocstream & ofs, FileName const & fname)
 }
 
 
+bool openFileWrite(utf8_ofdocstream & ofs, FileName const & fname)
+{
+	return doOpenFileWrite(ofs, fname);
+}
+
+
 } // namespace lyx
@@ -21,6 +21,7 @@ namespace support { class FileName; }
 
 bool openFileWrite(std::ofstream & ofs, support::FileName const & fname);
 bool openFileWrite(ofdocstream & ofs, support::FileName const & fname);
+bool openFileWrite(utf8_ofdocstream & ofs, support::FileName const & fname);
 
 
 } // namespace lyx
@@ -16,7 +16,9 @@
 #include "Buffer.h"
 #include "BufferParams.h"
 #include "Encoding.h"
+#include "Exporter.h"
 #include "Font.h"
+#include "InsetIterator.h"
 #include "InsetList.h"
 #include "Language.h"
 #include "LyXRC.h"
@@ -28,6 +30,7 @@
 
 #include "insets/InsetBibitem.h"
 #include "insets/InsetArgument.h"
+#include "insets/InsetText.h"
 
 #include "frontends/alert.h"
 
@@ -38,10 +41,15 @@
 #include "support/textutils.h"
 #include "support/gettext.h"
 
+#include <QFuture>
+#include <QThreadPool>
 #include <QThreadStorage>
+#include <QtConcurrentRun>
 
 #include <list>
+#include <memory>
 #include <stack>
+#include <vector>
 
 using namespace std;
 using namespace lyx::support;
@@ -1588,91 +1596,23 @@ void TeXOnePar(Buffer const & buf,
 }
 
 
-// LaTeX all paragraphs
-void latexParagraphs(Buffer const & buf,
-		     Text const & text,
-		     otexstream & os,
-		     OutputParams const & runparams,
-		     string const & everypar)
-{
-	LASSERT(runparams.par_begin <= runparams.par_end,
-		{ os << "% LaTeX Output Error\n"; return; } );
+namespace {
 
+/// Output the top level paragraphs of \p text from \p pit up to \p end.
+/// Afterwards, \p pit is the first paragraph not output and \p lastpit
+/// the last paragraph whose output was started.
+void latexParagraphRange(Buffer const & buf, Text const & text,
+			 otexstream & os, OutputParams const & runparams,
+			 string const & everypar, pit_type & pit,
+			 pit_type const end, pit_type & lastpit,
+			 bool & gave_layout_warning)
+{
 	BufferParams const & bparams = buf.params();
-	BufferParams const & mparams = buf.masterParams();
-
-	bool const maintext = text.isMainText();
-	bool const is_child = buf.masterBuffer() != &buf;
-	bool const multibib_child = maintext && is_child
-			&& mparams.multibib == "child";
-
-	if (multibib_child && mparams.useBiblatex())
-		os << "\\newrefsection";
-	else if (multibib_child && mparams.useBibtopic()
-		 && !buf.masterBibInfo().empty()) {
-		os << "\\begin{btUnit}\n";
-		runparams.openbtUnit = true;
-	}
-
-	// Open a CJK environment at the beginning of the main buffer
-	// if the document's main encoding requires the CJK package
-	// or the document encoding is utf8 and the CJK package is required
-	// (but not in child documents or documents using system fonts):
-	OutputState * state = getOutputState();
-	if (maintext && !is_child && !bparams.useNonTeXFonts
-	    && (bparams.encoding().package() == Encoding::CJK
-			|| (bparams.encoding().name() == "utf8"
-				&& runparams.use_CJK))
-	   ) {
-		docstring const cjkenc = bparams.encoding().iconvName() == "UTF-8"
-								 ? from_ascii("UTF8")
-								 : from_ascii(bparams.encoding().latexName());
-		os << "\\begin{CJK}{" << cjkenc
-		   << "}{" << from_ascii(bparams.fonts_cjk) << "}%\n";
-		state->open_encoding_ = CJK;
-	}
-	// if "auto begin" is switched off, explicitly switch the
-	// language on at start
-	string const mainlang = runparams.use_polyglossia
-		? getPolyglossiaEnvName(bparams.language)
-		: bparams.language->babel();
-	string const lang_begin_command = runparams.use_polyglossia ?
-		"\\begin{$$lang}$$opts" : lyxrc.language_command_begin;
-	string const lang_end_command = runparams.use_polyglossia ?
-		"\\end{$$lang}" : lyxrc.language_command_end;
-	bool const using_begin_end = runparams.use_polyglossia ||
-					!lang_end_command.empty();
-
-	if (maintext && !lyxrc.language_auto_begin &&
-	    !mainlang.empty()) {
-		// FIXME UNICODE
-		string bc = runparams.use_polyglossia ?
-			    getPolyglossiaBegin(lang_begin_command, mainlang,
-						bparams.polyglossiaLangOptions(bparams.language->lang()))
-			  : subst(lang_begin_command, "$$lang", mainlang);
-		os << bc;
-		os << '\n';
-		if (using_begin_end)
-			pushLanguageName(mainlang);
-	}
-
 	ParagraphList const & paragraphs = text.paragraphs();
-
-	if (runparams.par_begin == runparams.par_end) {
-		// The full doc will be exported but it is easier to just rely on
-		// runparams range parameters that will be passed TeXEnvironment.
-		runparams.par_begin = 0;
-		runparams.par_end = static_cast<int>(paragraphs.size());
-	}
-
-	pit_type pit = runparams.par_begin;
-	// lastpit is for the language check after the loop.
-	pit_type lastpit = pit;
 	DocumentClass const & tclass = bparams.documentClass();
+	bool const maintext = text.isMainText();
 
-	// Did we already warn about inTitle layout mixing? (we only warn once)
-	bool gave_layout_warning = false;
-	for (; pit < runparams.par_end; ++pit) {
+	for (; pit < end; ++pit) {
 		lastpit = pit;
 		ParagraphList::const_iterator par = paragraphs.iterator_at(pit);
 
@@ -1769,6 +1709,356 @@ void latexParagraphs(Buffer const & buf,
 		finishEnvironment(os, runparams, data, maintext, lastpar);
 	}
 
+}
+
+
+/// The state that influences the LaTeX output of a paragraph, in
+/// addition to the paragraph itself.
+struct LaTeXChunkState
+{
+	LaTeXChunkState(otexstream const & os, OutputParams const & rp)
+		: stream(os.state()), runparams(rp), output(*getOutputState())
+	{}
+	/// Would the output continue in the same way from \p os and \p rp?
+	/// lastid and lastpos are ignored, since they are set before each
+	/// inset they are used for.
+	bool matches(otexstream const & os, OutputParams const & rp) const
+	{
+		OutputState const * const state = getOutputState();
+		return stream == os.state()
+			&& runparams.is_child == rp.is_child
+			&& runparams.need_maketitle == rp.need_maketitle
+			&& runparams.have_maketitle == rp.have_maketitle
+			&& runparams.inulemcmd == rp.inulemcmd
+			&& runparams.master_language == rp.master_language
+			&& runparams.encoding == rp.encoding
+			&& runparams.post_macro == rp.post_macro
+			&& runparams.isNonLong == rp.isNonLong
+			&& runparams.inDisplayMath == rp.inDisplayMath
+			&& runparams.wasDisplayMath == rp.wasDisplayMath
+			&& runparams.inFootnote == rp.inFootnote
+			&& runparams.openbtUnit == rp.openbtUnit
+			&& runparams.ctObject == rp.ctObject
+			&& runparams.need_noindent == rp.need_noindent
+			&& output.prev_env_language_ == state->prev_env_language_
+			&& output.lang_switch_depth_ == state->lang_switch_depth_
+			&& output.open_polyglossia_lang_ == state->open_polyglossia_lang_
+			&& output.open_encoding_ == state->open_encoding_
+			&& output.cjk_inherited_ == state->cjk_inherited_
+			&& output.nest_level_ == state->nest_level_;
+	}
+	/// Continue the output in \p os and \p rp from this state
+	void restore(otexstream & os, OutputParams const & rp) const
+	{
+		os.state(stream);
+		rp.is_child = runparams.is_child;
+		rp.need_maketitle = runparams.need_maketitle;
+		rp.have_maketitle = runparams.have_maketitle;
+		rp.inulemcmd = runparams.inulemcmd;
+		rp.master_language = runparams.master_language;
+		rp.encoding = runparams.encoding;
+		rp.post_macro = runparams.post_macro;
+		rp.isNonLong = runparams.isNonLong;
+		rp.inDisplayMath = runparams.inDisplayMath;
+		rp.wasDisplayMath = runparams.wasDisplayMath;
+		rp.inFootnote = runparams.inFootnote;
+		rp.openbtUnit = runparams.openbtUnit;
+		rp.ctObject = runparams.ctObject;
+		rp.need_noindent = runparams.need_noindent;
+		rp.lastid = runparams.lastid;
+		rp.lastpos = runparams.lastpos;
+		*getOutputState() = output;
+	}
+	///
+	otexstream::State stream;
+	///
+	OutputParams runparams;
+	///
+	OutputState output;
+};
+
+
+/// A range of top level paragraphs that is output by a worker thread
+struct LaTeXChunk
+{
+	///
+	pit_type begin;
+	///
+	pit_type end;
+	/// Is the output of the range done by a worker thread?
+	bool queued = false;
+	///
+	QFuture<void> future;
+	/// Did the worker thread produce the output of the whole range?
+	bool done = false;
+	///
+	TexString tex;
+	///
+	pit_type lastpit = 0;
+	/// The state after the output of the range
+	unique_ptr<LaTeXChunkState> end_state;
+};
+
+
+/// Split the main text of a master document into ranges starting with
+/// a top level section-like command. The output of such a range depends
+/// only on the state of the output when it begins, and is done
+/// speculatively in a worker thread, assuming that each range begins in
+/// the same state as the first one. Returns an empty vector if the output
+/// should be done serially.
+vector<LaTeXChunk> parallelChunks(Buffer const & buf, Text const & text,
+				  OutputParams const & runparams)
+{
+	vector<LaTeXChunk> chunks;
+	BufferParams const & bparams = buf.params();
+	if (lyxrc.latex_export_threads < 2 || !text.isMainText()
+	    || buf.masterBuffer() != &buf || !bparams.multibib.empty()
+	    // encoding changes of the file stream cannot be recorded
+	    || (!runparams.isFullUnicode()
+		&& (bparams.inputenc == "auto-legacy"
+		    || bparams.inputenc == "auto-legacy-plain")))
+		return chunks;
+
+	// Paragraphs containing insets whose output has side effects, or
+	// that need data which is not safe to access from several threads.
+	ParagraphList const & paragraphs = text.paragraphs();
+	vector<bool> serial(paragraphs.size(), false);
+	InsetText & inset = const_cast<InsetText &>(text.inset());
+	InsetIterator const i_end = end(inset);
+	for (InsetIterator it = begin(inset); it != i_end; ++it) {
+		switch (it->lyxCode()) {
+		case BIBTEX_CODE:
+		case EXTERNAL_CODE:
+		case GRAPHICS_CODE:
+		case INCLUDE_CODE:
+		case INFO_CODE:
+		case LISTINGS_CODE:
+		case MATH_MACRO_CODE:
+		case MATH_MACROTEMPLATE_CODE:
+		case PREVIEW_CODE:
+			serial[it.bottom().pit()] = true;
+			break;
+		default:
+			break;
+		}
+	}
+
+	// Title paragraphs are output serially.
+	pit_type first = runparams.par_begin;
+	for (pit_type pit = runparams.par_begin; pit < runparams.par_end; ++pit)
+		if (paragraphs[pit].layout().intitle)
+			first = pit + 1;
+
+	for (pit_type pit = first + 1; pit < runparams.par_end; ++pit) {
+		Paragraph const & par = paragraphs[pit];
+		Layout const & layout = par.layout();
+		if (par.params().depth() == 0 && layout.isCommand()
+		    && !layout.isEnvironment() && par.params().leftIndent().zero()) {
+			if (!chunks.empty())
+				chunks.back().end = pit;
+			LaTeXChunk chunk;
+			chunk.begin = pit;
+			chunk.end = runparams.par_end;
+			chunk.queued = !chunks.empty();
+			chunks.push_back(move(chunk));
+		}
+	}
+	// The first range is output serially to get the state at its
+	// beginning. We need at least two more for a gain.
+	if (chunks.size() < 3) {
+		chunks.clear();
+		return chunks;
+	}
+	for (LaTeXChunk & chunk : chunks)
+		for (pit_type pit = chunk.begin; pit < chunk.end; ++pit)
+			if (serial[pit])
+				chunk.queued = false;
+	return chunks;
+}
+
+
+/// Output the range of \p chunk in a worker thread, starting in \p start
+void latexChunk(Buffer const & buf, Text const & text,
+		string const & everypar, LaTeXChunkState const & start,
+		LaTeXChunk & chunk)
+{
+	OutputParams runparams = start.runparams;
+	runparams.exportdata = make_shared<ExportData>();
+	// This may run in the thread waiting for the result, which has its
+	// own output state.
+	OutputState * state = getOutputState();
+	OutputState const saved = *state;
+	*state = start.output;
+	otexstringstream os;
+	os.state(start.stream);
+	pit_type pit = chunk.begin;
+	// There are no title paragraphs in the range
+	bool gave_layout_warning = true;
+	try {
+		latexParagraphRange(buf, text, os, runparams, everypar, pit,
+				    chunk.end, chunk.lastpit, gave_layout_warning);
+	} catch (...) {
+		// The serial output will report the problem.
+		*state = saved;
+		return;
+	}
+	if (pit == chunk.end) {
+		chunk.end_state = make_unique<LaTeXChunkState>(os, runparams);
+		chunk.tex = os.release();
+		chunk.done = true;
+	}
+	*state = saved;
+}
+
+
+/// Output the top level paragraphs of \p text, using worker threads for
+/// the ranges in \p chunks.
+void latexParallel(Buffer const & buf, Text const & text,
+		   otexstream & os, OutputParams const & runparams,
+		   string const & everypar, vector<LaTeXChunk> & chunks,
+		   pit_type & pit, pit_type & lastpit,
+		   bool & gave_layout_warning)
+{
+	latexParagraphRange(buf, text, os, runparams, everypar, pit,
+			    chunks.front().begin, lastpit, gave_layout_warning);
+	if (pit != chunks.front().begin) {
+		latexParagraphRange(buf, text, os, runparams, everypar, pit,
+				    runparams.par_end, lastpit, gave_layout_warning);
+		return;
+	}
+
+	LaTeXChunkState const start(os, runparams);
+	QThreadPool pool;
+	pool.setMaxThreadCount(int(lyxrc.latex_export_threads) - 1);
+	for (size_t i = 1; i < chunks.size(); ++i) {
+		LaTeXChunk & chunk = chunks[i];
+		if (!chunk.queued)
+			continue;
+		chunk.future = QtConcurrent::run(&pool, [&buf, &text, &everypar, &start, &chunk](){
+			latexChunk(buf, text, everypar, start, chunk);
+		});
+	}
+
+	for (LaTeXChunk & chunk : chunks) {
+		if (pit >= chunk.end)
+			continue;
+		if (chunk.queued && pit == chunk.begin
+		    && start.matches(os, runparams)) {
+			chunk.future.waitForFinished();
+			if (chunk.done) {
+				LYXERR(Debug::OUTFILE, "Using parallel output of paragraphs "
+				       << chunk.begin << " to " << chunk.end - 1);
+				otexrowstream & otrs = os;
+				otrs << move(chunk.tex);
+				chunk.end_state->restore(os, runparams);
+				runparams.exportdata->addExternalFiles(
+					*chunk.end_state->runparams.exportdata);
+				pit = chunk.end;
+				lastpit = chunk.lastpit;
+				continue;
+			}
+		}
+		latexParagraphRange(buf, text, os, runparams, everypar, pit,
+				    chunk.end, lastpit, gave_layout_warning);
+	}
+	// The pool waits for the chunks that were not needed.
+}
+
+} // namespace
+
+
+// LaTeX all paragraphs
+void latexParagraphs(Buffer const & buf,
+		     Text const & text,
+		     otexstream & os,
+		     OutputParams const & runparams,
+		     string const & everypar)
+{
+	LASSERT(runparams.par_begin <= runparams.par_end,
+		{ os << "% LaTeX Output Error\n"; return; } );
+
+	BufferParams const & bparams = buf.params();
+	BufferParams const & mparams = buf.masterParams();
+
+	bool const maintext = text.isMainText();
+	bool const is_child = buf.masterBuffer() != &buf;
+	bool const multibib_child = maintext && is_child
+			&& mparams.multibib == "child";
+
+	if (multibib_child && mparams.useBiblatex())
+		os << "\\newrefsection";
+	else if (multibib_child && mparams.useBibtopic()
+		 && !buf.masterBibInfo().empty()) {
+		os << "\\begin{btUnit}\n";
+		runparams.openbtUnit = true;
+	}
+
+	// Open a CJK environment at the beginning of the main buffer
+	// if the document's main encoding requires the CJK package
+	// or the document encoding is utf8 and the CJK package is required
+	// (but not in child documents or documents using system fonts):
+	OutputState * state = getOutputState();
+	if (maintext && !is_child && !bparams.useNonTeXFonts
+	    && (bparams.encoding().package() == Encoding::CJK
+			|| (bparams.encoding().name() == "utf8"
+				&& runparams.use_CJK))
+	   ) {
+		docstring const cjkenc = bparams.encoding().iconvName() == "UTF-8"
+								 ? from_ascii("UTF8")
+								 : from_ascii(bparams.encoding().latexName());
+		os << "\\begin{CJK}{" << cjkenc
+		   << "}{" << from_ascii(bparams.fonts_cjk) << "}%\n";
+		state->open_encoding_ = CJK;
+	}
+	// if "auto begin" is switched off, explicitly switch the
+	// language on at start
+	string const mainlang = runparams.use_polyglossia
+		? getPolyglossiaEnvName(bparams.language)
+		: bparams.language->babel();
+	string const lang_begin_command = runparams.use_polyglossia ?
+		"\\begin{$$lang}$$opts" : lyxrc.language_command_begin;
+	string const lang_end_command = runparams.use_polyglossia ?
+		"\\end{$$lang}" : lyxrc.language_command_end;
+	bool const using_begin_end = runparams.use_polyglossia ||
+					!lang_end_command.empty();
+
+	if (maintext && !lyxrc.language_auto_begin &&
+	    !mainlang.empty()) {
+		// FIXME UNICODE
+		string bc = runparams.use_polyglossia ?
+			    getPolyglossiaBegin(lang_begin_command, mainlang,
+						bparams.polyglossiaLangOptions(bparams.language->lang()))
+			  : subst(lang_begin_command, "$$lang", mainlang);
+		os << bc;
+		os << '\n';
+		if (using_begin_end)
+			pushLanguageName(mainlang);
+	}
+
+	ParagraphList const & paragraphs = text.paragraphs();
+
+	if (runparams.par_begin == runparams.par_end) {
+		// The full doc will be exported but it is easier to just rely on
+		// runparams range parameters that will be passed TeXEnvironment.
+		runparams.par_begin = 0;
+		runparams.par_end = static_cast<int>(paragraphs.size());
+	}
+
+	pit_type pit = runparams.par_begin;
+	// lastpit is for the language check after the loop.
+	pit_type lastpit = pit;
+	DocumentClass const & tclass = bparams.documentClass();
+
+	// Did we already warn about inTitle layout mixing? (we only warn once)
+	bool gave_layout_warning = false;
+	vector<LaTeXChunk> chunks = parallelChunks(buf, text, runparams);
+	if (chunks.empty())
+		latexParagraphRange(buf, text, os, runparams, everypar, pit,
+				    runparams.par_end, lastpit, gave_layout_warning);
+	else
+		latexParallel(buf, text, os, runparams, everypar, chunks,
+			      pit, lastpit, gave_layout_warning);
+
 	// FIXME: uncomment the content or remove this block
 	if (pit == runparams.par_end) {
 			// Make sure that the last paragraph is
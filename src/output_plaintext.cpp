@@ -36,7 +36,7 @@ namespace lyx {
 void writePlaintextFile(Buffer const & buf, FileName const & fname,
 	OutputParams const & runparams)
 {
-	ofdocstream ofs;
+	utf8_ofdocstream ofs;
 	if (!openFileWrite(ofs, fname))
 		return;
 
@@ -20,8 +20,11 @@
 #include <QFile>
 #include <QStringList>
 #include <QTimer>
+#include <QtConcurrentRun>
 
 #include <algorithm>
+#include <chrono>
+#include <thread>
 
 using namespace std;
 
@@ -95,6 +98,32 @@ void FileSystemWatcher::debug()
 }
 
 
+//static
+FileStatus FileStatus::query(string const & filename, bool const with_checksum,
+                             bool const recheck_deletion)
+{
+	FileStatus status;
+	status.known = true;
+	FileName const file(filename);
+	status.exists = file.exists();
+	if (!status.exists && recheck_deletion) {
+		// The standard way to overwrite a file is to delete it and create
+		// a new file with the same name, so the file is often missing for
+		// a short time (see #12819). Only report lasting deletions.
+		this_thread::sleep_for(chrono::milliseconds(200));
+		file.refresh();
+		status.exists = file.exists();
+	}
+	if (!status.exists)
+		return status;
+	status.readonly = file.isReadOnly();
+	status.timestamp = file.lastModified();
+	if (with_checksum)
+		status.checksum = file.checksum();
+	return status;
+}
+
+
 FileMonitorGuard::FileMonitorGuard(string const & filename,
                                    QFileSystemWatcher * qwatcher)
 	: filename_(filename), qwatcher_(qwatcher), exists_(true)
@@ -103,10 +132,13 @@ FileMonitorGuard::FileMonitorGuard(string const & filename,
 		return;
 	QObject::connect(qwatcher, SIGNAL(fileChanged(QString const &)),
 	                 this, SLOT(notifyChange(QString const &)));
+	QObject::connect(&query_, SIGNAL(finished()),
+	                 this, SLOT(statusQueried()));
 	if (qwatcher_->files().contains(toqstr(filename)))
 		LYXERR0("This file is already being QFileSystemWatched: " << filename
 		        << ". This should not happen.");
 	refresh();
+	queryStatus(false);
 }
 
 
@@ -138,7 +170,7 @@ void FileMonitorGuard::refresh(bool const emit)
 				// after whether it has been recreated.
 			    QTimer::singleShot(existed ? 100 : 2000, this, SLOT(refresh()));
 			if (existed != exists_ && emit)
-				Q_EMIT fileChanged(exists_);
+				queryStatus(true);
 		}
 	}
 }
@@ -152,7 +184,55 @@ void FileMonitorGuard::notifyChange(QString const & path)
 		// <https://bugreports.qt.io/browse/QTBUG-46483> (not a bug).
 		// Therefore we must refresh.
 		refresh(false);
-		Q_EMIT fileChanged(exists_);
+		queryStatus(true);
+	}
+}
+
+
+void FileMonitorGuard::needChecksum()
+{
+	if (with_checksum_)
+		return;
+	with_checksum_ = true;
+	queryStatus(false);
+}
+
+
+void FileMonitorGuard::queryStatus(bool const notify)
+{
+	if (filename_.empty())
+		return;
+	notify_ |= notify;
+	// Notifications come in bursts when a file is written. Do not queue
+	// queries, the last one gives the final state anyway.
+	if (query_.isRunning()) {
+		query_again_ = true;
+		return;
+	}
+	string const filename = filename_;
+	bool const with_checksum = with_checksum_;
+	// If the file existed, a deletion might only be an overwrite
+	bool const recheck_deletion = status_.known && status_.exists;
+	query_.setFuture(QtConcurrent::run([filename, with_checksum, recheck_deletion]() {
+			return FileStatus::query(filename, with_checksum, recheck_deletion);
+		}));
+}
+
+
+void FileMonitorGuard::statusQueried()
+{
+	status_ = query_.result();
+	if (query_again_) {
+		query_again_ = false;
+		queryStatus(false);
+		return;
+	}
+	LYXERR(Debug::FILES, "Status of " << filename_ << ": exists "
+	       << status_.exists << ", read-only " << status_.readonly
+	       << ", timestamp " << status_.timestamp);
+	if (notify_) {
+		notify_ = false;
+		Q_EMIT fileChanged(status_.exists);
 	}
 }
 
@@ -195,15 +275,12 @@ void FileMonitor::changed(bool const exists)
 ActiveFileMonitor::ActiveFileMonitor(std::shared_ptr<FileMonitorGuard> const & monitor,
                                      FileName const & filename, int interval)
 	: FileMonitor(monitor), filename_(filename), interval_(interval),
-	  timestamp_(0), checksum_(0), cooldown_(true)
+	  timestamp_(0), checksum_(0), cooldown_(true), initialized_(false)
 {
 	QObject::connect(this, SIGNAL(fileChanged(bool)), this, SLOT(setCooldown()));
-	QTimer::singleShot(interval_, this, SLOT(clearCooldown()));
-	filename_.refresh();
-	if (!filename_.exists())
-		return;
-	timestamp_ = filename_.lastModified();
-	checksum_ = filename_.checksum();
+	QObject::connect(&query_, SIGNAL(finished()), this, SLOT(statusQueried()));
+	// The cooldown ends when the initial status is known
+	queryStatus();
 }
 
 
@@ -213,28 +290,41 @@ void ActiveFileMonitor::checkModified()
 		return;
 
 	cooldown_ = true;
+	queryStatus();
+}
+
+
+void ActiveFileMonitor::queryStatus()
+{
+	string const filename = filename_.absFileName();
+	time_t const timestamp = timestamp_;
+	query_.setFuture(QtConcurrent::run([filename, timestamp]() {
+			FileStatus status = FileStatus::query(filename, false, false);
+			if (status.exists && status.timestamp != timestamp)
+				status.checksum = FileName(filename).checksum();
+			return status;
+		}));
+}
+
+
+void ActiveFileMonitor::statusQueried()
+{
+	FileStatus const status = query_.result();
 	bool changed = false;
-	filename_.refresh();
-	bool exists = filename_.exists();
-	if (!exists) {
+	if (!status.exists) {
 		changed = timestamp_ || checksum_;
 		timestamp_ = 0;
 		checksum_ = 0;
-	} else {
-		time_t const new_timestamp = filename_.lastModified();
-
-		if (new_timestamp != timestamp_) {
-			timestamp_ = new_timestamp;
-
-			unsigned long const new_checksum = filename_.checksum();
-			if (new_checksum != checksum_) {
-				checksum_ = new_checksum;
-				changed = true;
-			}
+	} else if (status.timestamp != timestamp_) {
+		timestamp_ = status.timestamp;
+		if (status.checksum != checksum_) {
+			checksum_ = status.checksum;
+			changed = true;
 		}
 	}
-	if (changed)
-		Q_EMIT FileMonitor::fileChanged(exists);
+	if (changed && initialized_)
+		Q_EMIT FileMonitor::fileChanged(status.exists);
+	initialized_ = true;
 	QTimer::singleShot(interval_, this, SLOT(clearCooldown()));
 }
 
@@ -19,10 +19,12 @@
 #include "support/FileName.h"
 #include "support/signals.h"
 
+#include <ctime>
 #include <memory>
 #include <map>
 
 #include <QFileSystemWatcher>
+#include <QFutureWatcher>
 #include <QObject>
 
 
@@ -84,6 +86,29 @@ private:
 };
 
 
+/// The state of a monitored file, as seen by the last query. Queries are run
+/// in a worker thread, so that a slow (e.g. remote) file system does not block
+/// the GUI.
+struct FileStatus
+{
+	/// Query the file system. This can be called from any thread.
+	/// If \p recheck_deletion is true, a missing file is looked up again
+	/// after a short delay.
+	static FileStatus query(std::string const & filename, bool with_checksum,
+	                        bool recheck_deletion);
+	/// false until the first query has finished
+	bool known = false;
+	///
+	bool exists = false;
+	///
+	bool readonly = false;
+	///
+	time_t timestamp = 0;
+	/// only computed on request, 0 otherwise
+	unsigned long checksum = 0;
+};
+
+
 /// Must be unique per path
 /// Ends the watch when deleted
 class FileMonitorGuard : public QObject
@@ -98,6 +123,10 @@ public:
 	~FileMonitorGuard();
 	/// absolute path being tracked
 	std::string const & filename() { return filename_; }
+	/// The status of the file as of the last notification
+	FileStatus const & status() const { return status_; }
+	/// Compute the checksum of the file in the status queries
+	void needChecksum();
 
 public Q_SLOTS:
 	/// Make sure it is being monitored, after e.g. a deletion. See
@@ -106,18 +135,36 @@ public Q_SLOTS:
 	void refresh(bool emit = true);
 
 Q_SIGNALS:
-	/// Connect to this to be notified when the file changes
+	/// Connect to this to be notified when the file changes. status() is
+	/// up to date when this is emitted.
 	void fileChanged(bool exists) const;
 
 private Q_SLOTS:
 	/// Receive notifications from the QFileSystemWatcher
 	void notifyChange(QString const & path);
+	/// Receive the result of a status query
+	void statusQueried();
 
 private:
+	/// Start a status query in a worker thread. If \p notify is true,
+	/// fileChanged() is emitted when it has finished.
+	void queryStatus(bool notify);
+	///
 	std::string const filename_;
 	QFileSystemWatcher * qwatcher_;
 	/// for emitting fileChanged() when the file is created or deleted
 	bool exists_;
+	///
+	FileStatus status_;
+	/// the running status query
+	QFutureWatcher<FileStatus> query_;
+	/// whether another query must be started when the running one is done,
+	/// because the file has changed in the meantime
+	bool query_again_ = false;
+	/// whether fileChanged() is emitted when the queries are done
+	bool notify_ = false;
+	///
+	bool with_checksum_ = false;
 };
 
 
@@ -139,6 +186,11 @@ public:
 	/// deletion. See <https://bugreports.qt.io/browse/QTBUG-46483>. This is
 	/// called automatically.
 	void refresh() { monitor_->refresh(); }
+	/// The status of the file as of the last notification. This does not
+	/// access the file system.
+	FileStatus const & status() const { return monitor_->status(); }
+	/// Compute the checksum in status(), for detecting spurious notifications
+	void needChecksum() { monitor_->needChecksum(); }
 
 Q_SIGNALS:
 	/// Connect to this to be notified when the file changes
@@ -172,14 +224,20 @@ public:
 
 public Q_SLOTS:
 	/// Check explicitly for a modification, but not more than once every
-	/// interval ms.
+	/// interval ms. The file system is accessed in a worker thread.
 	void checkModified();
 
 private Q_SLOTS:
 	void setCooldown() { cooldown_ = true; }
 	void clearCooldown() { cooldown_ = false; }
+	/// Receive the result of checkModified()
+	void statusQueried();
 
 private:
+	/// Query the status in a worker thread, with the checksum if the
+	/// timestamp has changed
+	void queryStatus();
+	///
 	FileName const filename_;
 	///
 	int const interval_;
@@ -189,6 +247,10 @@ private:
 	unsigned long checksum_;
 	///
 	bool cooldown_;
+	/// false until the first query has finished
+	bool initialized_;
+	/// the running status query
+	QFutureWatcher<FileStatus> query_;
 };
 
 
@@ -557,7 +557,7 @@ unsigned long FileName::checksum() const
 	}
 
 	// This is used in the debug output at the end of the method.
-	static QElapsedTimer t;
+	static thread_local QElapsedTimer t;
 	if (lyxerr.debugging(Debug::FILES))
 		t.restart();
 
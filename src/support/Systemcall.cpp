@@ -17,6 +17,7 @@
 #include "support/filetools.h"
 #include "support/gettext.h"
 #include "support/lstrings.h"
+#include "support/mutex.h"
 #include "support/qstring_helpers.h"
 #include "support/Systemcall.h"
 #include "support/SystemcallPrivate.h"
@@ -25,12 +26,16 @@
 
 #include "LyX.h"
 
+#include <atomic>
 #include <cstdlib>
+#include <cstring>
 #include <iostream>
 
 #include <QProcess>
 #include <QElapsedTimer>
 #include <QThread>
+#include <QThreadPool>
+#include <QtConcurrentRun>
 #include <QCoreApplication>
 #include <QDebug>
 
@@ -245,33 +250,221 @@ string const parsecmd(string const & incmd, string & infile, string & outfile,
 	return trim(outcmd[0]);
 }
 
+
+/// Prepare the command line \p what for startProcess(), and log it
+QString prepareCommand(string const & what, string & infile, string & outfile,
+                       string & errfile)
+{
+	string const what_ss = commandPrep(what);
+	if (verbose)
+		lyxerr << "\nRunning: " << what_ss << endl;
+	else
+		LYXERR(Debug::INFO,"Running: " << what_ss);
+
+	return QString::fromLocal8Bit(
+			parsecmd(what_ss, infile, outfile, errfile).c_str());
+}
+
+
+/// Whether this is the thread running the event loop of the application
+bool inMainThread()
+{
+	QCoreApplication const * app = QCoreApplication::instance();
+	return !app || QThread::currentThread() == app->thread();
+}
+
+
+/// Keeps the last bytes appended to it
+class RingBuffer
+{
+public:
+	///
+	explicit RingBuffer(size_t capacity) : data_(capacity) {}
+	///
+	void append(char const * s, size_t n)
+	{
+		size_t const capacity = data_.size();
+		if (n > capacity) {
+			s += n - capacity;
+			n = capacity;
+		}
+		for (size_t i = 0; i < n; ++i) {
+			data_[(start_ + size_) % capacity] = s[i];
+			if (size_ < capacity)
+				++size_;
+			else
+				start_ = (start_ + 1) % capacity;
+		}
+	}
+	///
+	string str() const
+	{
+		string result;
+		result.reserve(size_);
+		for (size_t i = 0; i < size_; ++i)
+			result += data_[(start_ + i) % data_.size()];
+		return result;
+	}
+private:
+	///
+	vector<char> data_;
+	/// index of the oldest byte
+	size_t start_ = 0;
+	///
+	size_t size_ = 0;
+};
+
+
+/// The threads running the jobs of Systemcall::startAsync()
+class JobPool : public QThreadPool
+{
+public:
+	JobPool() { setMaxThreadCount(max(2, QThread::idealThreadCount())); }
+};
+
+
+JobPool & jobPool()
+{
+	static JobPool pool;
+	return pool;
+}
+
 } // namespace
 
 
+struct SystemcallJob::Impl
+{
+	///
+	Impl(string const & what, string const & path, string const & lpath)
+		: what(what), path(path), lpath(lpath), cancel(false),
+		  out(output_size), err(output_size)
+	{}
+	/// Run the process in the calling thread
+	int run(bool cancellable, bool query_stop);
+
+	///
+	string const what;
+	///
+	string const path;
+	///
+	string const lpath;
+	///
+	atomic<bool> cancel;
+	/// Protects out and err
+	mutable Mutex mutex;
+	///
+	RingBuffer out;
+	///
+	RingBuffer err;
+	///
+	QFuture<int> future;
+};
+
+
+int SystemcallJob::Impl::run(bool const cancellable, bool const query_stop)
+{
+	if (cancel)
+		return Systemcall::KILLED;
+
+	string infile;
+	string outfile;
+	string errfile;
+	QString const cmd = prepareCommand(what, infile, outfile, errfile);
+
+	SystemcallPrivate d(infile, outfile, errfile);
+	d.output_handler = [this](char const * s, bool error) {
+		Mutex::Locker lock(&mutex);
+		(error ? err : out).append(s, strlen(s));
+	};
+	d.startProcess(cmd, path, lpath, false);
+	return d.waitForJob(cancel, cancellable, query_stop);
+}
+
+
+QFuture<int> const & SystemcallJob::future() const
+{
+	return d->future;
+}
+
+
+int SystemcallJob::wait() const
+{
+	return d->future.result();
+}
+
+
+bool SystemcallJob::isFinished() const
+{
+	return d->future.isFinished();
+}
+
+
+void SystemcallJob::cancel()
+{
+	d->cancel = true;
+}
+
+
+string SystemcallJob::output() const
+{
+	Mutex::Locker lock(&d->mutex);
+	return d->out.str();
+}
+
+
+string SystemcallJob::errors() const
+{
+	Mutex::Locker lock(&d->mutex);
+	return d->err.str();
+}
+
+
 void Systemcall::killscript()
 {
 	SystemcallPrivate::kill_script = true;
 }
 
 
+SystemcallJobPtr Systemcall::startAsync(string const & what,
+                                        string const & path,
+                                        string const & lpath)
+{
+	auto d = make_shared<SystemcallJob::Impl>(what, path, lpath);
+	d->future = QtConcurrent::run(&jobPool(), [d]() {
+			return d->run(false, false);
+		});
+	return SystemcallJobPtr(new SystemcallJob(d));
+}
+
+
+int Systemcall::maxJobs()
+{
+	return jobPool().maxThreadCount();
+}
+
+
+void Systemcall::setMaxJobs(int n)
+{
+	jobPool().setMaxThreadCount(max(1, n));
+}
+
+
 int Systemcall::startscript(Starttype how, string const & what,
 			    string const & path, string const & lpath,
 			    bool process_events)
 {
-	string const what_ss = commandPrep(what);
-	if (verbose)
-		lyxerr << "\nRunning: " << what_ss << endl;
-	else
-		LYXERR(Debug::INFO,"Running: " << what_ss);
+	bool do_events = process_events || how == WaitLoop;
+	// Processing the events of a worker thread (e.g. of an export) is
+	// pointless. Poll for killscript() instead, without an event loop.
+	if (do_events && how != DontWait && !inMainThread())
+		return SystemcallJob::Impl(what, path, lpath).run(true, true);
 
 	string infile;
 	string outfile;
 	string errfile;
-	QString const cmd = QString::fromLocal8Bit(
-			parsecmd(what_ss, infile, outfile, errfile).c_str());
+	QString const cmd = prepareCommand(what, infile, outfile, errfile);
 
 	SystemcallPrivate d(infile, outfile, errfile);
-	bool do_events = process_events || how == WaitLoop;
 
 	d.startProcess(cmd, path, lpath, how == DontWait);
 	if (how == DontWait && d.state == SystemcallPrivate::Running)
@@ -310,7 +503,7 @@ int Systemcall::startscript(Starttype how, string const & what,
 }
 
 
-bool SystemcallPrivate::kill_script = false;
+atomic<bool> SystemcallPrivate::kill_script(false);
 
 
 SystemcallPrivate::SystemcallPrivate(std::string const & sf, std::string const & of,
@@ -531,17 +724,73 @@ bool SystemcallPrivate::waitWhile(State waitwhile, bool process_events, int time
 }
 
 
+int SystemcallPrivate::waitForJob(atomic<bool> const & cancel,
+                                  bool const cancellable, bool const query_stop)
+{
+	if (!process_ || state == Error) {
+		LYXERR0("Systemcall: '" << cmd_ << "' did not start!");
+		return Systemcall::NOSTART;
+	}
+
+	int timeout = os::timeout_ms();
+	QElapsedTimer timer;
+	timer.start();
+	// Wake up regularly to check for cancellation
+	while (!process_->waitForFinished(100)) {
+		if (process_->state() == QProcess::NotRunning)
+			break;
+		if (cancel || (cancellable && kill_script)) {
+			if (!cancel)
+				kill_script = false;
+			process_->kill();
+			process_->waitForFinished();
+			state = Killed;
+			LYXERR0("Killed: " << cmd_);
+			return Systemcall::KILLED;
+		}
+		if (query_stop && timeout >= 0 && timer.elapsed() > timeout) {
+			bool const stop = queryStopCommand(cmd_);
+			// The command may have finished in the meantime
+			if (process_->state() == QProcess::NotRunning)
+				break;
+			if (stop) {
+				process_->kill();
+				process_->waitForFinished();
+				LYXERR0("Systemcall: '" << cmd_ << "' did not finish!");
+				return Systemcall::TIMEOUT;
+			}
+			timeout *= 3;
+		}
+	}
+
+	if (state == Error && process_->error() == QProcess::FailedToStart) {
+		LYXERR0("Systemcall: '" << cmd_ << "' did not start!");
+		LYXERR0("error " << errorMessage());
+		return Systemcall::NOSTART;
+	}
+
+	int const exit_code = exitCode();
+	if (exit_code)
+		LYXERR0("Systemcall: '" << cmd_ << "' finished with exit code " << exit_code);
+	return exit_code;
+}
+
+
 SystemcallPrivate::~SystemcallPrivate()
 {
 	if (out_index_) {
 		out_data_[out_index_] = '\0';
 		out_index_ = 0;
+		if (output_handler)
+			output_handler(out_data_, false);
 		cout << out_data_;
 	}
 	cout.flush();
 	if (err_index_) {
 		err_data_[err_index_] = '\0';
 		err_index_ = 0;
+		if (output_handler)
+			output_handler(err_data_, true);
 		cerr << err_data_;
 	}
 	cerr.flush();
@@ -561,6 +810,8 @@ void SystemcallPrivate::stdOut()
 				out_data_[out_index_] = '\0';
 				out_index_ = 0;
 				ProgressInterface::instance()->appendMessage(QString::fromLocal8Bit(out_data_));
+				if (output_handler)
+					output_handler(out_data_, false);
 				cout << out_data_;
 			}
 		}
@@ -579,6 +830,8 @@ void SystemcallPrivate::stdErr()
 				err_data_[err_index_] = '\0';
 				err_index_ = 0;
 				ProgressInterface::instance()->appendError(QString::fromLocal8Bit(err_data_));
+				if (output_handler)
+					output_handler(err_data_, true);
 				cerr << err_data_;
 			}
 		}
@@ -15,9 +15,17 @@
 #ifndef SYSTEMCALL_H
 #define SYSTEMCALL_H
 
+#include <memory>
+#include <string>
+
+#include <QFuture>
+
 namespace lyx {
 namespace support {
 
+class SystemcallJob;
+typedef std::shared_ptr<SystemcallJob> SystemcallJobPtr;
+
 /**
  * An instance of Class Systemcall represents a single child process.
  *
@@ -64,6 +72,56 @@ public:
 			std::string const & path = empty_string(),
 			std::string const & lpath = empty_string(),
 			bool process_events = false);
+
+	/** Start child process in a worker thread and return at once.
+	 *  The arguments are as for startscript(). No event loop is run,
+	 *  and the user is not asked whether a long running command should
+	 *  be stopped, use SystemcallJob::cancel() for that. At most
+	 *  maxJobs() jobs run at the same time, the others are queued.
+	 *  This can be called from any thread.
+	 */
+	static SystemcallJobPtr startAsync(std::string const & what,
+			std::string const & path = empty_string(),
+			std::string const & lpath = empty_string());
+	/// The maximal number of jobs of startAsync() running at the same time
+	static int maxJobs();
+	///
+	static void setMaxJobs(int n);
+};
+
+
+/**
+ * A child process started by Systemcall::startAsync(). All methods are
+ * thread-safe. The process is not killed when the job is deleted.
+ */
+class SystemcallJob {
+public:
+	/// The result is the exit code of the process, or a
+	/// Systemcall::ReturnValue.
+	QFuture<int> const & future() const;
+	/// Block until the process has finished, and return the result
+	int wait() const;
+	///
+	bool isFinished() const;
+	/// Kill the process, or do not start it if it is still queued.
+	/// The result is then Systemcall::KILLED.
+	void cancel();
+	/// The end of the standard output of the process, if it is not
+	/// redirected to a file
+	std::string output() const;
+	/// The end of the standard error of the process, if it is not
+	/// redirected to a file
+	std::string errors() const;
+	/// The number of bytes kept by output() and errors()
+	static size_t const output_size = 65536;
+
+private:
+	friend class Systemcall;
+	struct Impl;
+	///
+	explicit SystemcallJob(std::shared_ptr<Impl> const & d) : d(d) {}
+	///
+	std::shared_ptr<Impl> d;
 };
 
 } // namespace support
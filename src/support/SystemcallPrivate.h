@@ -15,6 +15,8 @@
 #include <QObject>
 #include <QProcess>
 
+#include <atomic>
+#include <functional>
 #include <string>
 
 namespace lyx {
@@ -44,6 +46,12 @@ public:
 	State state;
 
 	bool waitWhile(State, bool processEvents, int timeout = -1);
+	/// Wait for a process started by startProcess() without running an
+	/// event loop. The process is killed if \p cancel becomes true, or
+	/// if \p cancellable and kill_script is set.
+	/// Returns the exit code or a Systemcall::ReturnValue.
+	int waitForJob(std::atomic<bool> const & cancel, bool cancellable,
+	               bool query_stop);
 	void startProcess(QString const & cmd, std::string const & path,
 	                  std::string const & lpath, bool detach);
 
@@ -57,7 +65,11 @@ public:
 	static void killProcess(QProcess * p);
 
 	// when true, kill any running script ASAP
-	static bool kill_script;
+	static std::atomic<bool> kill_script;
+
+	/// If set, this is called with the output of the process, as it is
+	/// sent to the console. The second argument is true for stderr.
+	std::function<void(char const *, bool)> output_handler;
 
 
 public Q_SLOTS:
@@ -18,10 +18,15 @@
 #include "support/FileName.h"
 #include "support/gettext.h"
 #include "support/lstrings.h"
+#include "support/mutex.h"
 #include "support/ProgressInterface.h"
 
+#include <chrono>
+#include <fstream>
 #include <iostream>
 #include <iomanip>
+#include <memory>
+#include <vector>
 
 
 using namespace std;
@@ -304,5 +309,146 @@ LyXErr & operator<<(LyXErr & l, ios_base &(*t)(ios_base &))
 LyXErr lyxerr;
 
 
+namespace Trace {
+
+atomic<bool> recording(false);
+
+namespace {
+
+struct Event {
+	char const * name;
+	uint64_t start;
+	uint64_t end;
+};
+
+
+/// The spans recorded by one thread. Only this thread writes to it, so
+/// that recording does not need a lock. When it is full, the oldest spans
+/// are overwritten.
+class EventBuffer {
+public:
+	///
+	explicit EventBuffer(int tid) : tid(tid), events(capacity) {}
+	///
+	void push(Event const & event)
+	{
+		size_t const n = count.load(memory_order_relaxed);
+		events[n % capacity] = event;
+		count.store(n + 1, memory_order_release);
+	}
+	///
+	static size_t const capacity = 1 << 16;
+	/// the thread id in the trace file
+	int const tid;
+	///
+	vector<Event> events;
+	/// number of events pushed so far
+	atomic<size_t> count {0};
+};
+
+
+struct Registry {
+	///
+	Mutex mutex;
+	/// The buffers of all threads that have recorded spans. They are
+	/// kept when the thread finishes.
+	vector<unique_ptr<EventBuffer>> buffers;
+	///
+	string file;
+};
+
+
+Registry & registry()
+{
+	static Registry registry;
+	return registry;
+}
+
+
+EventBuffer & threadBuffer()
+{
+	thread_local EventBuffer * buffer = nullptr;
+	if (!buffer) {
+		Registry & r = registry();
+		Mutex::Locker lock(&r.mutex);
+		r.buffers.push_back(make_unique<EventBuffer>(int(r.buffers.size()) + 1));
+		buffer = r.buffers.back().get();
+	}
+	return *buffer;
+}
+
+} // namespace
+
+
+void enable(string const & file)
+{
+#ifdef ENABLE_TRACING
+	Registry & r = registry();
+	{
+		Mutex::Locker lock(&r.mutex);
+		r.file = file;
+	}
+	// start the clock
+	now();
+	recording = true;
+#else
+	LYXERR0("Cannot write " << file
+	        << ", LyX has been built without tracing support.");
+#endif
+}
+
+
+uint64_t now()
+{
+	using namespace std::chrono;
+	static steady_clock::time_point const origin = steady_clock::now();
+	return duration_cast<microseconds>(steady_clock::now() - origin).count();
+}
+
+
+void record(char const * name, uint64_t start, uint64_t end)
+{
+	threadBuffer().push({name, start, end});
+}
+
+
+void write()
+{
+	if (!enabled())
+		return;
+	recording = false;
+
+	Registry & r = registry();
+	Mutex::Locker lock(&r.mutex);
+	ofstream ofs(r.file.c_str());
+	if (!ofs) {
+		LYXERR0("Cannot write trace file " << r.file);
+		return;
+	}
+	ofs << "{\"traceEvents\":[";
+	bool first = true;
+	for (auto const & buffer : r.buffers) {
+		// Spans that are still open are pushed concurrently, they are
+		// not part of the trace.
+		size_t const count = buffer->count.load(memory_order_acquire);
+		size_t const capacity = EventBuffer::capacity;
+		size_t const begin = count > capacity ? count - capacity : 0;
+		for (size_t i = begin; i < count; ++i) {
+			Event const & e = buffer->events[i % capacity];
+			ofs << (first ? "\n" : ",\n")
+			    << "{\"name\":\"" << e.name
+			    << "\",\"cat\":\"lyx\",\"ph\":\"X\",\"ts\":" << e.start
+			    << ",\"dur\":" << e.end - e.start
+			    << ",\"pid\":1,\"tid\":" << buffer->tid << '}';
+			first = false;
+		}
+	}
+	ofs << "\n],\"displayTimeUnit\":\"ms\"}\n";
+	LYXERR(Debug::INFO, "Trace written to " << r.file);
+}
+
+} // namespace Trace
+
+
 
 } // namespace lyx
@@ -17,6 +17,9 @@
 
 #include "support/docstring.h"
 
+#include <atomic>
+#include <cstdint>
+
 
 // Make sure at compile time that sizeof(unsigned long long) >= 8
 typedef char p__LINE__[ (sizeof(unsigned long long) > 7) ? 1 : -1];
@@ -216,6 +219,45 @@ LyXErr & operator<<(LyXErr &, std::ios_base &(*)(std::ios_base &));
 
 extern LyXErr lyxerr;
 
+
+/// Trace spans, for profiling. A span is recorded for the lifetime of a
+/// Trace::Span object when tracing has been enabled with "-trace file".
+/// The spans are written as Chrome trace events (for chrome://tracing or
+/// Perfetto) when LyX exits. Use the LYXTRACE macro below, which vanishes
+/// if LyX is configured without tracing.
+namespace Trace {
+	/// Record spans from now on, write() writes them to \p file
+	void enable(std::string const & file);
+	///
+	extern std::atomic<bool> recording;
+	///
+	inline bool enabled() { return recording.load(std::memory_order_relaxed); }
+	/// Stop recording and write the recorded spans
+	void write();
+	/// Microseconds since the first call
+	std::uint64_t now();
+	/// Record a span of the current thread. This does not lock.
+	void record(char const * name, std::uint64_t start, std::uint64_t end);
+
+	///
+	class Span {
+	public:
+		/// \p name is not copied, it must be a string literal
+		explicit Span(char const * name)
+			: name_(enabled() ? name : nullptr), start_(name_ ? now() : 0)
+		{}
+		///
+		~Span() { if (name_) record(name_, start_, now()); }
+	private:
+		Span(Span const &) = delete;
+		void operator=(Span const &) = delete;
+		///
+		char const * const name_;
+		///
+		std::uint64_t const start_;
+	};
+} // namespace Trace
+
 } // namespace lyx
 
 #if USE__func__
@@ -242,6 +284,16 @@ extern LyXErr lyxerr;
 		else { lyx::lyxerr << msg; lyx::lyxerr.endl(); } \
 	} while (0)
 
+#ifdef ENABLE_TRACING
+#	define LYXTRACE_CONCAT_(a, b) a##b
+#	define LYXTRACE_CONCAT(a, b) LYXTRACE_CONCAT_(a, b)
+/// Record a trace span named \p name until the end of the scope
+#	define LYXTRACE(name) \
+	lyx::Trace::Span LYXTRACE_CONCAT(lyx_trace_span_, __LINE__)(name)
+#else
+#	define LYXTRACE(name) do {} while (0)
+#endif
+
 #define LYXERR0(msg) \
 	do { \
 		lyx::lyxerr << CURRENT_POSITION << msg; lyx::lyxerr.endl(); \
@@ -16,6 +16,7 @@
 
 #include <algorithm>
 #include <cerrno>
+#include <cstdint>
 #include <cstdio>
 #include <cstring>
 #include <iconv.h>
@@ -376,6 +377,181 @@ void ofdocstream::reset(string const & encoding)
 }
 
 
+namespace {
+
+/// Number of characters of the put area of utf8_filebuf
+size_t const utf8_buffer_size = 65536;
+
+
+/// Convert the UCS4 characters [from, end) to UTF8 at \p to, which must
+/// have room for four bytes per character. Returns the end of the output,
+/// or nullptr if a character is not a valid code point (like iconv does).
+char * ucs4_to_utf8(char_type const * from, char_type const * end, char * to)
+{
+	// Number of consecutive ASCII characters converted one by one
+	int ascii_run = 0;
+	while (from != end) {
+		// Copy long runs of ASCII characters in blocks. The inner loops
+		// have a fixed length, so that the compiler can vectorize them.
+		if (ascii_run >= 16) {
+			while (end - from >= 16) {
+				uint32_t any = 0;
+				for (int i = 0; i < 16; ++i)
+					any |= static_cast<uint32_t>(from[i]);
+				if (any >= 0x80)
+					break;
+				for (int i = 0; i < 16; ++i)
+					to[i] = static_cast<char>(from[i]);
+				from += 16;
+				to += 16;
+			}
+			ascii_run = 0;
+			if (from == end)
+				break;
+		}
+		uint32_t const c = static_cast<uint32_t>(*from++);
+		if (c < 0x80) {
+			*to++ = static_cast<char>(c);
+			++ascii_run;
+			continue;
+		}
+		ascii_run = 0;
+		if (c < 0x800) {
+			*to++ = static_cast<char>(0xC0 | (c >> 6));
+			*to++ = static_cast<char>(0x80 | (c & 0x3F));
+		} else if (c < 0x10000) {
+			// surrogates are not valid code points
+			if (c >= 0xD800 && c < 0xE000)
+				return nullptr;
+			*to++ = static_cast<char>(0xE0 | (c >> 12));
+			*to++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*to++ = static_cast<char>(0x80 | (c & 0x3F));
+		} else if (c < 0x110000) {
+			*to++ = static_cast<char>(0xF0 | (c >> 18));
+			*to++ = static_cast<char>(0x80 | ((c >> 12) & 0x3F));
+			*to++ = static_cast<char>(0x80 | ((c >> 6) & 0x3F));
+			*to++ = static_cast<char>(0x80 | (c & 0x3F));
+		} else
+			return nullptr;
+	}
+	return to;
+}
+
+} // namespace
+
+
+utf8_filebuf::utf8_filebuf()
+	: buf_(new char_type[utf8_buffer_size]),
+	  out_(new char[4 * utf8_buffer_size])
+{
+	// No put area as long as no file is open, so that output fails.
+	setp(nullptr, nullptr);
+}
+
+
+utf8_filebuf::~utf8_filebuf()
+{
+	close();
+	delete[] out_;
+	delete[] buf_;
+}
+
+
+bool utf8_filebuf::open(char const * name)
+{
+	if (file_)
+		return false;
+	file_ = fopen(name, "wb");
+	if (!file_)
+		return false;
+	setp(buf_, buf_ + utf8_buffer_size);
+	return true;
+}
+
+
+bool utf8_filebuf::close()
+{
+	if (!file_)
+		return false;
+	bool success = flushBuffer();
+	if (fclose(file_) != 0)
+		success = false;
+	file_ = nullptr;
+	setp(nullptr, nullptr);
+	return success;
+}
+
+
+utf8_filebuf::int_type utf8_filebuf::overflow(int_type c)
+{
+	if (!file_ || !flushBuffer())
+		return traits_type::eof();
+	if (!traits_type::eq_int_type(c, traits_type::eof())) {
+		*pptr() = traits_type::to_char_type(c);
+		pbump(1);
+	}
+	return traits_type::not_eof(c);
+}
+
+
+int utf8_filebuf::sync()
+{
+	if (!file_ || !flushBuffer() || fflush(file_) != 0)
+		return -1;
+	return 0;
+}
+
+
+bool utf8_filebuf::flushBuffer()
+{
+	char const * const end = ucs4_to_utf8(pbase(), pptr(), out_);
+	setp(buf_, buf_ + utf8_buffer_size);
+	if (!end) {
+		fputs("Invalid UCS4 character in UTF8 output\n", stderr);
+		fflush(stderr);
+		return false;
+	}
+	size_t const size = end - out_;
+	return fwrite(out_, 1, size, file_) == size;
+}
+
+
+utf8_ofdocstream::utf8_ofdocstream() : odocstream(nullptr)
+{
+	rdbuf(&buf_);
+}
+
+
+utf8_ofdocstream::utf8_ofdocstream(char const * s) : odocstream(nullptr)
+{
+	rdbuf(&buf_);
+	open(s);
+}
+
+
+utf8_ofdocstream::~utf8_ofdocstream()
+{
+	if (buf_.is_open())
+		buf_.close();
+}
+
+
+void utf8_ofdocstream::open(char const * s)
+{
+	if (buf_.open(s))
+		clear();
+	else
+		setstate(ios_base::failbit);
+}
+
+
+void utf8_ofdocstream::close()
+{
+	if (!buf_.close())
+		setstate(ios_base::failbit);
+}
+
+
 
 SetEnc setEncoding(string const & encoding)
 {
@@ -14,6 +14,7 @@
 
 #include "support/docstring.h"
 
+#include <cstdio>
 #include <fstream>
 #include <sstream>
 
@@ -78,6 +79,60 @@ public:
 };
 
 
+/// Stream buffer writing UCS4 as UTF8 to a file, used by utf8_ofdocstream.
+/// Contrary to the file buffer of ofdocstream, it does not need iconv.
+class utf8_filebuf : public std::basic_streambuf<char_type> {
+public:
+	///
+	utf8_filebuf();
+	///
+	~utf8_filebuf();
+	///
+	bool open(char const * name);
+	///
+	bool is_open() const { return file_ != nullptr; }
+	/// Flush and close the file. Returns false if something failed.
+	bool close();
+protected:
+	///
+	int_type overflow(int_type c) override;
+	///
+	int sync() override;
+private:
+	/// Convert and write the contents of the put area
+	bool flushBuffer();
+	///
+	std::FILE * file_ = nullptr;
+	/// The put area
+	char_type * buf_;
+	/// The UTF8 output, four bytes per character of the put area
+	char * out_;
+};
+
+
+/// File stream for writing UTF8-encoded files with automatic conversion
+/// from UCS4. This is faster than ofdocstream, but the encoding cannot be
+/// changed. It is meant for exporting formats that always use UTF8.
+class utf8_ofdocstream : public odocstream {
+public:
+	///
+	utf8_ofdocstream();
+	///
+	explicit utf8_ofdocstream(char const * s);
+	///
+	~utf8_ofdocstream();
+	///
+	void open(char const * s);
+	///
+	bool is_open() const { return buf_.is_open(); }
+	///
+	void close();
+private:
+	///
+	utf8_filebuf buf_;
+};
+
+
 
 /// UCS4 input stringstream
 typedef std::basic_istringstream<char_type> idocstringstream;
@@ -0,0 +1,52 @@
+#include <config.h>
+
+#include "../docstring.h"
+#include "../Systemcall.h"
+
+#include <iostream>
+
+#include <QCoreApplication>
+
+
+using namespace lyx::support;
+
+using namespace std;
+
+void test_startAsync()
+{
+	// output and exit code of a finished command (Systemcall also
+	// echoes the output of the command to cout)
+	SystemcallJobPtr job = Systemcall::startAsync("echo hello");
+	cout << job->wait() << endl;
+	cout << job->isFinished() << endl;
+	cout << job->output();
+	job = Systemcall::startAsync("sh -c \"echo error >&2; exit 3\"");
+	cout << job->wait() << endl;
+	cout << job->output().empty() << endl;
+	cout << job->errors();
+	// a command that does not exist
+	job = Systemcall::startAsync("lyxcheckdoesnotexist");
+	cout << (job->wait() == Systemcall::NOSTART) << endl;
+}
+
+void test_cancel()
+{
+	int const max_jobs = Systemcall::maxJobs();
+	Systemcall::setMaxJobs(1);
+	SystemcallJobPtr running = Systemcall::startAsync("sleep 60");
+	// queued behind the running job
+	SystemcallJobPtr queued = Systemcall::startAsync("echo queued");
+	queued->cancel();
+	running->cancel();
+	cout << (running->wait() == Systemcall::KILLED) << endl;
+	cout << (queued->wait() == Systemcall::KILLED) << endl;
+	cout << queued->output().empty() << endl;
+	Systemcall::setMaxJobs(max_jobs);
+}
+
+int main(int argc, char ** argv)
+{
+	QCoreApplication app(argc, argv);
+	test_startAsync();
+	test_cancel();
+}
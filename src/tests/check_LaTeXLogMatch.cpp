@@ -0,0 +1,329 @@
+#include <config.h>
+
+#include "../LaTeXLogMatch.h"
+#include "../support/debug.h"
+
+#include <iostream>
+#include <regex>
+#include <string>
+#include <vector>
+
+
+using namespace lyx;
+using namespace lyx::latexlog;
+using namespace std;
+
+
+// The matchers in ../LaTeXLogMatch.cpp replace the regular expressions
+// that were used by ../LaTeX.cpp. Here both are run on the same lines, and
+// each result is written as "-" (no match) or the matched groups between
+// brackets. Lines where the two disagree are marked by "MISMATCH".
+
+namespace {
+
+string result(bool matched, vector<string> const & groups = vector<string>())
+{
+	if (!matched)
+		return "-";
+	string r;
+	for (string const & g : groups)
+		r += '[' + g + ']';
+	return r.empty() ? "+" : r;
+}
+
+
+string regexMatch(string const & re, string const & s)
+{
+	smatch sub;
+	if (!regex_match(s, sub, regex(re)))
+		return result(false);
+	vector<string> groups;
+	for (size_t i = 1; i < sub.size(); ++i)
+		groups.push_back(sub.str(i));
+	return result(true, groups);
+}
+
+
+// All matches of regex_search(), one after the other
+string regexSearch(string const & re, string const & s)
+{
+	regex const reg(re);
+	smatch what;
+	string r;
+	string::const_iterator first = s.begin();
+	while (regex_search(first, s.end(), what, reg)) {
+		r += '[' + what.str(1) + '|' + what.str(2) + ']';
+		first = what[0].second;
+	}
+	return r.empty() ? "-" : r;
+}
+
+
+// A matcher that was used in place of a regular expression
+struct Case {
+	///
+	string name;
+	///
+	string re;
+	/// regex_search() instead of regex_match()
+	bool search;
+	///
+	string (*matcher)(string const &);
+};
+
+
+string prefixed(string const & s, char const * pre)
+{
+	string arg;
+	bool const m = matchPrefixed(s, pre, arg);
+	return result(m, {arg});
+}
+
+
+string braced(string const & s, char const * pre)
+{
+	string arg;
+	bool const m = matchBraced(s, pre, arg);
+	return result(m, {arg});
+}
+
+
+string delimited(string const & s, char open, char const * excl)
+{
+	string r;
+	string name;
+	string delim;
+	size_t first = 0;
+	while (searchDelimited(s, first, open, excl, name, delim))
+		r += '[' + name + '|' + delim + ']';
+	return r.empty() ? "-" : r;
+}
+
+
+vector<Case> const cases = {
+	{"File", "File: (.+).*", false,
+	 [](string const & s) { return prefixed(s, "File: "); }},
+	// The caller splits off the last character
+	{"No file", "No file (.+)(.).*", false,
+	 [](string const & s) {
+		 string arg;
+		 if (!matchPrefixed(s, "No file ", arg) || arg.size() < 2)
+			 return result(false);
+		 return result(true, {arg.substr(0, arg.size() - 1),
+		                      arg.substr(arg.size() - 1)});
+	 }},
+	{"index", "Writing index file (.+).*", false,
+	 [](string const & s) { return prefixed(s, "Writing index file "); }},
+	{"glossary", "Writing glossary file (.+).*", false,
+	 [](string const & s) { return prefixed(s, "Writing glossary file "); }},
+	{"nomenclature", ".*Writing nomenclature file (.+).*", false,
+	 [](string const & s) {
+		 string arg;
+		 bool const m = matchInfix(s, "Writing nomenclature file ", arg);
+		 return result(m, {arg});
+	 }},
+	{"citation", "\\\\citation\\{([^}]+)\\}", false,
+	 [](string const & s) { return braced(s, "\\citation"); }},
+	{"bibdata", "\\\\bibdata\\{([^}]+)\\}", false,
+	 [](string const & s) { return braced(s, "\\bibdata"); }},
+	{"bibstyle", "\\\\bibstyle\\{([^}]+)\\}", false,
+	 [](string const & s) { return braced(s, "\\bibstyle"); }},
+	{"@input", "\\\\@input\\{([^}]+)\\}", false,
+	 [](string const & s) { return braced(s, "\\@input"); }},
+	{"child", "[^0-9]*([0-9]+[A-Za-z]*_.+\\.tex).*", false,
+	 [](string const & s) {
+		 string name;
+		 bool const m = matchChildFile(s, 0, s.size(), name);
+		 return result(m, {name});
+	 }},
+	// The whole line is used, not the group
+	{"file:line:error", "(.+\\.\\D+:[0-9]+: .+)", false,
+	 [](string const & s) { return result(matchFileLineError(s), {s}); }},
+	{"undefined reference", ".*Reference `(\\w+)\\' on page.*", false,
+	 [](string const & s) {
+		 string ref;
+		 bool const m = matchUndefRef(s, ref);
+		 return result(m, {ref});
+	 }},
+	{"package info", "Package \\w+ Info: .*", false,
+	 [](string const & s) { return result(matchPackageMessage(s, "Info")); }},
+	{"package warning", "Package \\w+ Warning: .*", false,
+	 [](string const & s) { return result(matchPackageMessage(s, "Warning")); }},
+	{"openout", "\\\\openout[0-9]+.*=.*`(.+)(..).*", false,
+	 [](string const & s) {
+		 string name;
+		 string tail;
+		 bool const m = matchOpenoutQuoted(s, name, tail);
+		 return result(m, {name, tail});
+	 }},
+	{"openout LuaTeX", "\\\\openout[0-9]+.*=\\s*(.+)", false,
+	 [](string const & s) {
+		 string name;
+		 bool const m = matchOpenoutPlain(s, name);
+		 return result(m, {name});
+	 }},
+	{"<...>", ".*<[^>]+.*", false,
+	 [](string const & s) { return result(hasDelimitedContent(s, '<', '>')); }},
+	{"(...)", ".*\\([^)]+.*", false,
+	 [](string const & s) { return result(hasDelimitedContent(s, '(', ')')); }},
+	{"<...> files", "<([^>]+)(.)", true,
+	 [](string const & s) { return delimited(s, '<', ">"); }},
+	{"(...) files", "\\(([^()]+)(.)", true,
+	 [](string const & s) { return delimited(s, '(', "()"); }},
+};
+
+
+string expected(Case const & c, string const & s)
+{
+	return c.search ? regexSearch(c.re, s) : regexMatch(c.re, s);
+}
+
+
+// Lines of real logs and aux files, and some corner cases
+char const * const lines[] = {
+	"",
+	"File: article.cls 2021/10/04 v1.4n Standard LaTeX document class",
+	"File: ",
+	"File: x",
+	"No file test.toc.",
+	"No file test.ind",
+	"No file ",
+	"No file x",
+	"No file xy",
+	"Writing index file test.idx",
+	"Writing glossary file test.glo",
+	"Writing nomenclature file test.nlo",
+	"Package nomencl Info: Writing nomenclature file test.nlo on input line 5.",
+	"Writing nomenclature file ",
+	"\\citation{knuth84,lamport94}",
+	"\\citation{}",
+	"\\citation{a}b}",
+	"\\citation{a}}",
+	"\\bibdata{biblio/refs,more}",
+	"\\bibstyle{plain}",
+	"\\@input{0_home_user_child.aux}",
+	"\\@input{a",
+	"(./0_home_user_child.tex",
+	"0_home_user_child.tex (./1a_x_y.tex)",
+	"12_.tex",
+	"12_a.tex",
+	"abc1b_x.tex.tex.",
+	"./test.tex:12: Undefined control sequence.",
+	"./test.tex:12:",
+	"./test.1:12: x",
+	"a.b:1: c",
+	".b:1: c",
+	"x.ab:12: y:13: z",
+	"LaTeX Warning: Reference `sec:intro' on page 1 undefined on input line 7.",
+	"LaTeX Warning: Reference `sec_intro' on page 1 undefined on input line 7.",
+	"Reference `a' on page Reference `b' on page",
+	"Reference `' on page",
+	"Package hyperref Info: Option `colorlinks' set `true' on input line 1.",
+	"Package babel Warning: No hyphenation patterns were preloaded for",
+	"Package  Info: x",
+	"Package hyperref Info:x",
+	"\\openout1 = `test.aux'.",
+	"\\openout12 = `a`b'.",
+	"\\openout1 = `ab'",
+	"\\openout1 = `a'",
+	"\\openout1 = test.aux",
+	"\\openout3 =  test.out",
+	"\\openout3 = ",
+	"\\openout3 =",
+	"\\openout = `test.aux'.",
+	"\\openout1 = a=b",
+	"<test.pdf, id=1, 597.51233pt x 845.0471pt> <use test.pdf>",
+	"<>",
+	"<a",
+	"<<>>",
+	"(/usr/share/texlive/texmf-dist/tex/latex/base/article.cls",
+	"(./test.aux) (./test.toc)",
+	"(",
+	"()",
+	"(a(b)c)",
+	"((a)",
+	"))",
+	0
+};
+
+
+// Random lines over the characters that matter to the patterns
+string randomLine(unsigned long & seed)
+{
+	static char const * const words[] = {"File: ", "No file ",
+		"Writing nomenclature file ", "\\citation", "\\@input",
+		"Reference `", "' on page", "Package ", " Info: ",
+		"\\openout", "= ", " =`", ".tex", ".", ":", ": ", "_", "0", "12",
+		"a", "Ab", "x_y", " ", "\t", "{", "}", "<", ">", "(", ")", "`",
+		"'", "=", 0};
+	size_t nwords = 0;
+	while (words[nwords])
+		++nwords;
+	string s;
+	seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+	int const n = (seed >> 33) % 8;
+	for (int i = 0; i < n; ++i) {
+		seed = seed * 6364136223846793005UL + 1442695040888963407UL;
+		s += words[(seed >> 33) % nwords];
+	}
+	return s;
+}
+
+} // namespace
+
+
+void test_samples()
+{
+	for (Case const & c : cases) {
+		cout << c.name << endl;
+		for (char const * const * l = lines; *l; ++l) {
+			string const s = *l;
+			string const want = expected(c, s);
+			string const got = c.matcher(s);
+			if (want == "-" && got == "-")
+				continue;
+			cout << "  " << s << " -> " << got;
+			if (want != got)
+				cout << " MISMATCH regex: " << want;
+			cout << endl;
+		}
+	}
+}
+
+
+void test_random()
+{
+	unsigned long seed = 42;
+	int mismatches = 0;
+	for (int i = 0; i < 20000; ++i) {
+		string const s = randomLine(seed);
+		for (Case const & c : cases) {
+			string const want = expected(c, s);
+			string const got = c.matcher(s);
+			if (want != got) {
+				++mismatches;
+				cout << c.name << ": " << s << " -> " << got
+				     << " MISMATCH regex: " << want << endl;
+			}
+		}
+	}
+	cout << "random lines: " << mismatches << " mismatches" << endl;
+}
+
+
+void test_stripLogLine()
+{
+	string line("a\rb\0c\r\r", 7);
+	stripLogLine(line);
+	cout << line << endl;
+}
+
+
+int main(int, char **)
+{
+	// Connect lyxerr with cout instead of cerr to catch error output
+	lyx::lyxerr.setStream(cout);
+	test_samples();
+	test_random();
+	test_stripLogLine();
+}
@@ -0,0 +1,90 @@
+#include <config.h>
+
+#include "../WordList.h"
+#include "../support/debug.h"
+
+#include <cstdlib>
+#include <iostream>
+#include <new>
+
+
+using namespace lyx;
+using namespace std;
+
+
+// Count the allocations, to check that interning a known word does not
+// allocate
+namespace {
+
+unsigned long allocations = 0;
+
+} // namespace
+
+
+void * operator new(size_t size)
+{
+	++allocations;
+	if (void * p = malloc(size ? size : 1))
+		return p;
+	throw bad_alloc();
+}
+
+
+void operator delete(void * p) noexcept
+{
+	free(p);
+}
+
+
+void operator delete(void * p, size_t) noexcept
+{
+	free(p);
+}
+
+
+void test_internWord()
+{
+	// longer than any short string buffer
+	docstring const word = from_ascii("interning_does_not_allocate");
+	docstring const other = from_ascii("another_interned_word");
+	docstring const * const w = internWord(word);
+	docstring const * const o = internWord(other);
+	cout << (*w == word) << endl;
+	unsigned long const before = allocations;
+	docstring const * const w2 = internWord(word);
+	cout << (w2 == w) << endl;
+	cout << "allocations when interning a known word: "
+	     << allocations - before << endl;
+
+	unsigned long const before_batch = allocations;
+	{
+		WordInterner interner;
+		for (int i = 0; i < 100; ++i) {
+			interner.intern(word);
+			interner.intern(other);
+		}
+	}
+	cout << "allocations when interning known words in a batch: "
+	     << allocations - before_batch << endl;
+	for (int i = 0; i < 100; ++i) {
+		releaseWord(w);
+		releaseWord(o);
+	}
+
+	// Give back all references, the word is freed then
+	releaseWord(w2);
+	releaseWord(w);
+	releaseWord(o);
+	unsigned long const before_free = allocations;
+	internWord(word);
+	cout << "allocations when interning a freed word: "
+	     << (allocations - before_free > 0) << endl;
+}
+
+
+int main(int, char **)
+{
+	// Connect lyxerr with cout instead of cerr to catch error output
+	lyx::lyxerr.setStream(cout);
+	test_internWord();
+}
@@ -53,6 +53,10 @@ char_type getNewline(iparserdocstream & is, char_type c)
 	return c;
 }
 
+/// How many tokens before the current position are kept when forgetting
+/// the history. This needs to cover putback() and unskip_spaces().
+size_t const rewind_window = 1000;
+
 } // namespace
 
 //
@@ -130,13 +134,13 @@ void iparserdocstream::setEncoding(std::string const & e)
 
 void iparserdocstream::putback(char_type c)
 {
-	s_ = c + s_;
+	s_ += c;
 }
 
 
 void iparserdocstream::putback(docstring const & s)
 {
-	s_ = s + s_;
+	s_.append(s.rbegin(), s.rend());
 }
 
 
@@ -146,8 +150,8 @@ iparserdocstream & iparserdocstream::get(char_type &c)
 		is_.get(c);
 	else {
 		//warning_message("unparsed: " + to_utf8(s_));
-		c = s_[0];
-		s_.erase(0,1);
+		c = s_.back();
+		s_.pop_back();
 	}
 	return *this;
 }
@@ -159,7 +163,8 @@ iparserdocstream & iparserdocstream::get(char_type &c)
 
 
 Parser::Parser(idocstream & is, std::string const & fixedenc)
-	: lineno_(0), pos_(0), iss_(nullptr), is_(is),
+	: lineno_(0), first_(0), pos_(0), catcode_changes_(0),
+	  keep_history_(true), iss_(nullptr), is_(is),
 	  encoding_iconv_(fixedenc.empty() ? "UTF-8" : fixedenc),
 	  theCatcodesType_(NORMAL_CATCODES), curr_cat_(UNDECIDED_CATCODES),
 	  fixed_enc_(!fixedenc.empty())
@@ -171,7 +176,8 @@ Parser::Parser(idocstream & is, std::string const & fixedenc)
 
 
 Parser::Parser(string const & s)
-	: lineno_(0), pos_(0),
+	: lineno_(0), first_(0), pos_(0), catcode_changes_(0),
+	  keep_history_(true),
 	  iss_(new idocstringstream(from_utf8(s))), is_(*iss_),
 	  encoding_iconv_("UTF-8"),
 	  theCatcodesType_(NORMAL_CATCODES), curr_cat_(UNDECIDED_CATCODES),
@@ -191,11 +197,11 @@ Parser::~Parser()
 void Parser::deparse()
 {
 	string s;
-	for(size_type i = pos_ ; i < tokens_.size() ; ++i) {
-		s += tokens_[i].asInput();
+	for(size_type i = pos_ ; i < tokenized() ; ++i) {
+		s += token(i).asInput();
 	}
 	is_.putback(from_utf8(s));
-	tokens_.erase(tokens_.begin() + pos_, tokens_.end());
+	tokens_.erase(tokens_.begin() + (pos_ - first_), tokens_.end());
 	// make sure that next token is read
 	tokenize_one();
 }
@@ -258,6 +264,7 @@ CatCode Parser::catcode(char_type c) const
 void Parser::setCatcode(char c, CatCode cat)
 {
 	theCatcode_[(unsigned char)c] = cat;
+	++catcode_changes_;
 	deparse();
 }
 
@@ -265,6 +272,7 @@ void Parser::setCatcode(char c, CatCode cat)
 void Parser::setCatcodes(cat_type t)
 {
 	theCatcodesType_ = t;
+	++catcode_changes_;
 	deparse();
 }
 
@@ -285,15 +293,48 @@ bool Parser::setEncoding(std::string const & e)
 
 void Parser::push_back(Token const & t)
 {
+	dropHistory();
 	tokens_.push_back(t);
 }
 
 
+void Parser::dropHistory()
+{
+	if (keep_history_)
+		return;
+	// Tokens can be needed again from the oldest saved position
+	size_t keep = pos_;
+	for (auto const & p : positions_)
+		keep = min(keep, p.first);
+	for (size_t const m : marks_)
+		keep = min(keep, m);
+	if (keep < first_ + 2 * rewind_window)
+		return;
+	// Drop many tokens at once, so that moving the remaining ones is cheap
+	size_t const drop = keep - rewind_window - first_;
+	tokens_.erase(tokens_.begin(), tokens_.begin() + drop);
+	first_ += drop;
+}
+
+
+void Parser::mark()
+{
+	marks_.push_back(pos_);
+}
+
+
+void Parser::backToMark()
+{
+	pos_ = marks_.back();
+	marks_.pop_back();
+}
+
+
 // We return a copy here because the tokens_ vector may get reallocated
 Token const Parser::prev_token() const
 {
 	static const Token dummy;
-	return pos_ > 1 ? tokens_[pos_ - 2] : dummy;
+	return pos_ > first_ + 1 ? token(pos_ - 2) : dummy;
 }
 
 
@@ -301,7 +342,7 @@ Token const Parser::prev_token() const
 Token const Parser::curr_token() const
 {
 	static const Token dummy;
-	return pos_ > 0 ? tokens_[pos_ - 1] : dummy;
+	return pos_ > first_ ? token(pos_ - 1) : dummy;
 }
 
 
@@ -311,9 +352,9 @@ Token const Parser::next_token()
 	static const Token dummy;
 	if (!good())
 		return dummy;
-	if (pos_ >= tokens_.size())
+	if (pos_ >= tokenized())
 		tokenize_one();
-	return pos_ < tokens_.size() ? tokens_[pos_] : dummy;
+	return pos_ < tokenized() ? token(pos_) : dummy;
 }
 
 
@@ -325,11 +366,11 @@ Token const Parser::next_next_token()
 		return dummy;
 	// If tokenize_one() has not been called after the last get_token() we
 	// need to tokenize two more tokens.
-	if (pos_ >= tokens_.size())
+	if (pos_ >= tokenized())
 		tokenize_one();
-	if (pos_ + 1 >= tokens_.size())
+	if (pos_ + 1 >= tokenized())
 		tokenize_one();
-	return pos_ + 1 < tokens_.size() ? tokens_[pos_ + 1] : dummy;
+	return pos_ + 1 < tokenized() ? token(pos_ + 1) : dummy;
 }
 
 
@@ -339,14 +380,14 @@ Token const Parser::get_token()
 	static const Token dummy;
 	if (!good())
 		return dummy;
-	if (pos_ >= tokens_.size()) {
+	if (pos_ >= tokenized()) {
 		tokenize_one();
-		if (pos_ >= tokens_.size())
+		if (pos_ >= tokenized())
 			return dummy;
 	}
-	// warning_message("looking at token " + tokens_[pos_]
+	// warning_message("looking at token " + token(pos_)
 	//      + " pos: " + pos_ <<);
-	return tokens_[pos_++];
+	return token(pos_++);
 }
 
 
@@ -402,7 +443,7 @@ bool Parser::skip_spaces(bool skip_comments)
 
 void Parser::unskip_spaces(bool skip_comments)
 {
-	while (pos_ > 0) {
+	while (pos_ > first_) {
 		if ( curr_token().cat() == catSpace ||
 		    (curr_token().cat() == catNewline && curr_token().cs().size() == 1))
 			putback();
@@ -428,15 +469,19 @@ void Parser::putback()
 
 void Parser::pushPosition()
 {
-	positions_.push_back(pos_);
+	positions_.push_back(make_pair(pos_, catcode_changes_));
 }
 
 
 void Parser::popPosition()
 {
-	pos_ = positions_.back();
+	pos_ = positions_.back().first;
+	// The tokens that follow need only be parsed again if they were
+	// read with other catcodes.
+	bool const changed = positions_.back().second != catcode_changes_;
 	positions_.pop_back();
-	deparse();
+	if (changed)
+		deparse();
 }
 
 
@@ -448,7 +493,7 @@ void Parser::dropPosition()
 
 bool Parser::good() const
 {
-	if (pos_ < tokens_.size())
+	if (pos_ < tokenized())
 		return true;
 	if (!is_.good())
 		return false;
@@ -467,7 +512,7 @@ bool Parser::hasOpt(string const & l)
 	//   [bar]
 
 	// remember current position
-	unsigned int oldpos = pos_;
+	mark();
 	// skip spaces and comments
 	while (good()) {
 		get_token();
@@ -483,7 +528,7 @@ bool Parser::hasOpt(string const & l)
 		break;
 	}
 	bool const retval = (next_token().asInput() == l);
-	pos_ = oldpos;
+	backToMark();
 	return retval;
 }
 
@@ -495,7 +540,7 @@ bool Parser::hasIdxMacros(string const & c, string const & e)
 	// \p e marks a terminating delimiter¸
 
 	// remember current position
-	unsigned int oldpos = pos_;
+	mark();
 	// skip spaces and comments
 	bool retval = false;
 	while (good()) {
@@ -516,7 +561,7 @@ bool Parser::hasIdxMacros(string const & c, string const & e)
 		}
 		continue;
 	}
-	pos_ = oldpos;
+	backToMark();
 	return retval;
 }
 
@@ -623,7 +668,7 @@ string Parser::getFullParentheseArg()
 bool Parser::hasListPreamble(string const & itemcmd)
 {
 	// remember current position
-	unsigned int oldpos = pos_;
+	mark();
 	// jump over arguments
 	if (hasOpt())
 		getOpt();
@@ -635,7 +680,7 @@ bool Parser::hasListPreamble(string const & itemcmd)
 	// that follows is not the \item command
 	bool res =  next_token().cs() != itemcmd;
 	// back to orig position
-	pos_ = oldpos;
+	backToMark();
 	return res;
 }
 
@@ -720,11 +765,11 @@ string const Parser::getCommandLatexParam()
 	string res;
 	size_t offset = 0;
 	while (true) {
-		if (pos_ + offset >= tokens_.size())
+		if (pos_ + offset >= tokenized())
 			tokenize_one();
-		if (pos_ + offset >= tokens_.size())
+		if (pos_ + offset >= tokenized())
 			break;
-		Token t = tokens_[pos_ + offset];
+		Token t = token(pos_ + offset);
 		if (t.cat() == catBegin)
 			break;
 		res += t.asInput();
@@ -913,10 +958,10 @@ void Parser::tokenize_one()
 void Parser::dump() const
 {
 	cerr << "\nTokens: ";
-	for (unsigned i = 0; i < tokens_.size(); ++i) {
+	for (size_t i = first_; i < tokenized(); ++i) {
 		if (i == pos_)
 			cerr << " <#> ";
-		cerr << tokens_[i];
+		cerr << token(i);
 	}
 	cerr << " pos: " << pos_ << "\n";
 }
@@ -932,6 +977,10 @@ void Parser::error(string const & msg) const
 
 void Parser::reset()
 {
+	if (first_ > 0) {
+		error("cannot go back to the start after forgetHistory()");
+		return;
+	}
 	pos_ = 0;
 }
 
@@ -148,11 +148,12 @@ public:
 	bool good() const { return s_.empty() ? is_.good() : true; }
 
 	/// Like std::istream::peek()
-	int_type peek() const { return s_.empty() ? is_.peek() : s_[0]; }
+	int_type peek() const { return s_.empty() ? is_.peek() : s_.back(); }
 private:
 	///
 	idocstream & is_;
-	/// characters to read before actually reading the stream
+	/// characters to read before actually reading the stream, in
+	/// reverse order (so that both get() and putback() are cheap)
 	docstring s_;
 };
 
@@ -343,6 +344,10 @@ public:
 	bool good() const;
 	/// resets the parser to initial state
 	void reset();
+	/// Allow the parser to forget the tokens that lie far behind the
+	/// current position and all saved positions. This keeps the memory
+	/// use bounded for large input, but reset() is not possible anymore.
+	void forgetHistory() { keep_history_ = false; }
 
 private:
 	/// Setup catcode table
@@ -351,14 +356,34 @@ private:
 	void tokenize_one();
 	///
 	void push_back(Token const & t);
+	/// The token with number \p i (counted from the start of the input)
+	Token const & token(size_t i) const { return tokens_[i - first_]; }
+	/// The number of tokens that have been read from the start
+	size_t tokenized() const { return first_ + tokens_.size(); }
+	/// remember the current position for a look ahead
+	void mark();
+	/// go back to the position remembered by mark()
+	void backToMark();
+	/// forget the tokens that are not needed anymore
+	void dropHistory();
 	///
 	int lineno_;
-	///
+	/// The tokens that are still needed
 	std::vector<Token> tokens_;
+	/// The number of the first token in tokens_
+	size_t first_;
 	///
 	size_t pos_;
+	/// Positions saved by pushPosition(), with catcode_changes_ at
+	/// that time
+	std::vector<std::pair<size_t, unsigned int>> positions_;
+	/// Positions saved by mark()
+	std::vector<size_t> marks_;
+	/// Number of catcode changes so far. The tokens after a saved
+	/// position need to be parsed again if this changed in between.
+	unsigned int catcode_changes_;
 	///
-	std::vector<unsigned> positions_;
+	bool keep_history_;
 	///
 	idocstringstream * iss_;
 	///
@@ -786,6 +786,48 @@ void Preamble::registerAuthor(std::string const & name, string const & initials)
 }
 
 
+string Preamble::bodySettings() const
+{
+	string settings;
+	for (string const & package : auto_packages)
+		settings += "auto_package\t" + package + '\n';
+	settings += "cite_engine\t" + h_cite_engine + '\n';
+	settings += "multibib\t" + h_multibib + '\n';
+	settings += "suppress_date\t" + h_suppress_date + '\n';
+	settings += "title_layout_found\t"
+		+ string(title_layout_found ? "true" : "false") + '\n';
+	if (h_font_cjk_set)
+		settings += "font_cjk\t" + h_font_cjk + '\n';
+	settings += "use_indices\t" + h_use_indices + '\n';
+	settings += "tracking_changes\t" + h_tracking_changes + '\n';
+	settings += "output_changes\t" + h_output_changes + '\n';
+	return settings;
+}
+
+
+void Preamble::bodySetting(string const & name, string const & value)
+{
+	if (name == "auto_package")
+		auto_packages.insert(value);
+	else if (name == "cite_engine")
+		h_cite_engine = value;
+	else if (name == "multibib")
+		h_multibib = value;
+	else if (name == "suppress_date")
+		h_suppress_date = value;
+	else if (name == "title_layout_found")
+		title_layout_found = value == "true";
+	else if (name == "font_cjk")
+		fontCJK(value);
+	else if (name == "use_indices")
+		h_use_indices = value;
+	else if (name == "tracking_changes")
+		h_tracking_changes = value;
+	else if (name == "output_changes")
+		h_output_changes = value;
+}
+
+
 Author const & Preamble::getAuthor(std::string const & name) const
 {
 	Author author(from_utf8(name), empty_docstring(), empty_docstring());
@@ -105,6 +105,14 @@ public:
 	void registerAuthor(std::string const & name, std::string const & initials);
 	/// Get author named \p name (must be registered first)
 	Author const & getAuthor(std::string const & name) const;
+	/// The registered authors
+	AuthorList const & authors() const { return authors_; }
+	/// The settings that parsing the document body can change, one
+	/// "name\tvalue" line each, so that they can be passed on from a
+	/// process that converted a child document
+	std::string bodySettings() const;
+	/// Take over a setting \p name as written by bodySettings()
+	void bodySetting(std::string const & name, std::string const & value);
 	/// Set text class
 	void setTextClass(std::string const & tclass, TeX2LyXDocClass & tc);
 	/// Get number of arguments of special table column type \c or -1
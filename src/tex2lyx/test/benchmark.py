@@ -0,0 +1,142 @@
+#! /usr/bin/python3
+# -*- coding: utf-8 -*-
+
+# file src/tex2lyx/test/benchmark.py
+# This file is part of LyX, the document processor.
+# Licence details can be found in the file COPYING.
+
+# Full author contact details are available in file CREDITS
+
+# This script measures the throughput of tex2lyx. It converts the test
+# documents, and a large document made by repeating the body of each of
+# them, and prints the time needed and the amount of input per second.
+# The output is not checked, this is what runtests.py is for.
+
+from __future__ import print_function
+
+import os, re, shutil, subprocess, sys, tempfile, time
+
+def usage(prog_name):
+  return "Usage: %s [<tex2lyx binary> [<size of large documents in MB> [<runs>]]]" % prog_name
+
+files = ['test.ltx', \
+         'algo2e.tex', \
+         'beamer.tex', \
+         'box-color-size-space-align.tex', \
+         'CJK.tex', \
+         'CJKutf8.tex', \
+         'listpreamble.tex', \
+         'tabular-x-test.tex', \
+         'test-insets.tex', \
+         'test-insets-basic.tex', \
+         'test-memoir.tex', \
+         'test-minted.tex', \
+         'test-modules.tex', \
+         'test-refstyle-theorems.tex', \
+         'test-scr.tex', \
+         'test-structure.tex', \
+         'verbatim.tex', \
+         'XeTeX-polyglossia.tex']
+
+pat_begin = re.compile(r'\\begin\{document\}')
+pat_end = re.compile(r'\\end\{document\}')
+
+def enlarge(texfile, outfile, size):
+    """Write a copy of texfile to outfile, with the body repeated until
+       the file has at least size bytes. Returns False if texfile has no
+       body."""
+    f = open(texfile, 'rb')
+    content = f.read().decode('latin-1')
+    f.close()
+    begin = pat_begin.search(content)
+    end = pat_end.search(content)
+    if not begin or not end or end.start() <= begin.end():
+        return False
+    body = content[begin.end():end.start()]
+    count = max(1, (size - len(content)) // max(1, len(body)) + 1)
+    f = open(outfile, 'wb')
+    f.write(content[:begin.end()].encode('latin-1'))
+    for i in range(count):
+        f.write(body.encode('latin-1'))
+    f.write(content[end.start():].encode('latin-1'))
+    f.close()
+    return True
+
+def convert(tex2lyx, texfile, lyxfile, runs):
+    """Convert texfile runs times, and return the best time in seconds,
+       or None if tex2lyx failed."""
+    best = None
+    cmd = [tex2lyx, '-f', texfile, lyxfile]
+    for i in range(runs):
+        start = time.time()
+        proc = subprocess.Popen(cmd, stdin=subprocess.PIPE, stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+        proc.communicate()
+        elapsed = time.time() - start
+        if proc.returncode != 0:
+            return None
+        if best is None or elapsed < best:
+            best = elapsed
+    return best
+
+def report(name, size, seconds):
+    if seconds is None:
+        print('%-40s %10d bytes      failed' % (name, size))
+    else:
+        print('%-40s %10d bytes %8.3f s %8.3f MB/s' % (name, size, seconds, size / 1048576.0 / max(seconds, 1e-6)))
+
+def main(argv):
+    if len(argv) > 4:
+        print(usage(argv[0]))
+        return 1
+    tex2lyx = './tex2lyx'
+    if len(argv) > 1:
+        tex2lyx = argv[1]
+    size = 5
+    if len(argv) > 2:
+        size = float(argv[2])
+    runs = 3
+    if len(argv) > 3:
+        runs = int(argv[3])
+
+    inputdir = os.path.realpath(os.path.dirname(argv[0]))
+    topdir = os.path.realpath(os.path.join(inputdir, '..', '..', '..'))
+    workdir = tempfile.mkdtemp(prefix='tex2lyxbench')
+    failed = False
+    total_size = 0
+    total_time = 0.0
+    try:
+        # Convert in a copy of the test directory, so that the source tree
+        # is not touched. The test documents include files of the test
+        # directory and of lib/examples by relative paths, therefore both
+        # are copied to the same places relative to each other.
+        testdir = os.path.join(workdir, 'src', 'tex2lyx', 'test')
+        shutil.copytree(inputdir, testdir)
+        shutil.copytree(os.path.join(topdir, 'lib', 'examples'),
+                        os.path.join(workdir, 'lib', 'examples'))
+        for f in files:
+            (base, ext) = os.path.splitext(f)
+            texfile = os.path.join(inputdir, f)
+            for name in ['small', 'large']:
+                localtex = os.path.join(testdir, base + '-' + name + ext)
+                if name == 'small':
+                    shutil.copyfile(texfile, localtex)
+                elif not enlarge(texfile, localtex, int(size * 1048576)):
+                    continue
+                lyxfile = os.path.join(testdir, base + '-' + name + '.lyx')
+                texsize = os.path.getsize(localtex)
+                seconds = convert(tex2lyx, localtex, lyxfile, runs)
+                report(os.path.basename(localtex), texsize, seconds)
+                if seconds is None:
+                    failed = True
+                else:
+                    total_size += texsize
+                    total_time += seconds
+        report('total', total_size, total_time)
+    finally:
+        shutil.rmtree(workdir, True)
+    if failed:
+        return 1
+    return 0
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv))
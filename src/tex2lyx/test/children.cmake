@@ -0,0 +1,54 @@
+# This file is part of LyX, the document processor.
+# Licence details can be found in the file COPYING.
+#
+# Convert a master document with several child documents sequentially and
+# with parallel jobs, the resulting .lyx files must be the same.
+#
+# Script should be called like:
+# COMMAND ${CMAKE_COMMAND} \
+#     -DLYX_TESTS_USERDIR=${LYX_TESTS_USERDIR} \
+#     -DLYX_USERDIR_VER=${LYX_USERDIR_VER} \
+#     -DTEX2LYX_EXE=$<TARGET_FILE:${_tex2lyx}> \
+#     -DSRCDIR=${TOP_SRC_DIR}/src/tex2lyx/test \
+#     -DWORKDIR=${CMAKE_CURRENT_BINARY_DIR}/children \
+#     -P ${TOP_SRC_DIR}/src/tex2lyx/test/children.cmake
+
+set(ENV{${LYX_USERDIR_VER}} ${LYX_TESTS_USERDIR})
+
+set(_files test-children test-children-1 test-children-2 test-children-3
+           test-children-4)
+
+foreach(_mode sequential parallel)
+  set(_dir "${WORKDIR}/${_mode}")
+  file(REMOVE_RECURSE "${_dir}")
+  file(MAKE_DIRECTORY "${_dir}")
+  foreach(_f ${_files})
+    file(COPY "${SRCDIR}/${_f}.tex" DESTINATION "${_dir}")
+  endforeach()
+  if(_mode STREQUAL "parallel")
+    set(_jobs -j 4)
+  else()
+    set(_jobs)
+  endif()
+  execute_process(COMMAND ${TEX2LYX_EXE} ${_jobs} test-children.tex
+    WORKING_DIRECTORY "${_dir}"
+    RESULT_VARIABLE _err)
+  if(NOT _err EQUAL 0)
+    message(FATAL_ERROR "${_mode} conversion failed")
+  endif()
+endforeach()
+
+foreach(_f ${_files})
+  foreach(_mode sequential parallel)
+    set(_lyx "${WORKDIR}/${_mode}/${_f}.lyx")
+    if(NOT EXISTS "${_lyx}")
+      message(FATAL_ERROR "${_mode} conversion did not create ${_f}.lyx")
+    endif()
+    file(READ "${_lyx}" _content)
+    # The directory of the file is recorded
+    string(REGEX REPLACE "\n\\\\origin [^\n]*" "" _${_mode} "${_content}")
+  endforeach()
+  if(NOT _sequential STREQUAL _parallel)
+    message(FATAL_ERROR "${_f}.lyx differs between the sequential and the parallel conversion")
+  endif()
+endforeach()
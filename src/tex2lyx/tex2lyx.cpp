@@ -34,15 +34,25 @@
 #include "support/Package.h"
 #include "support/Systemcall.h"
 
+#include <cerrno>
+#include <chrono>
 #include <cstdlib>
 #include <algorithm>
 #include <exception>
+#include <fstream>
 #include <iostream>
 #include <string>
 #include <sstream>
 #include <vector>
 #include <map>
 
+#ifndef _WIN32
+# ifdef HAVE_UNISTD_H
+#  include <unistd.h>
+# endif
+# include <sys/wait.h>
+#endif
+
 // comment out to enable debug_messages
 //#define FILEDEBUG
 
@@ -614,6 +624,8 @@ bool copy_files = false;
 bool overwrite_files = false;
 bool no_warnings = false;
 bool skip_children = false;
+/// maximum number of child documents that are converted at the same time
+int max_jobs = 0;
 int error_code = 0;
 
 /// return the number of arguments consumed
@@ -669,6 +681,7 @@ int parse_help(string const &, string const &)
 		"\t-fixedenc encoding Like -e, but ignore encoding changing commands while parsing.\n"
 		"\t-f                 Force overwrite of .lyx files.\n"
 		"\t-help              Print this message and quit.\n"
+		"\t-j n               Convert up to n child documents at the same time.\n"
 		"\t-n                 Translate literate programming (noweb, sweave,... ) file.\n"
 		"\t-q                 Omit warnings.\n"
 		"\t-roundtrip         Re-export created .lyx file infile.lyx.lyx to infile.lyx.tex.\n"
@@ -797,6 +810,17 @@ int parse_noweb(string const &, string const &)
 }
 
 
+int parse_jobs(string const & arg, string const &)
+{
+	if (arg.empty())
+		error_with_message("Missing number after -j switch");
+	max_jobs = convert<int>(arg);
+	if (max_jobs < 1)
+		error_with_message("Invalid number of jobs `" + arg + "'.");
+	return 1;
+}
+
+
 int parse_skipchildren(string const &, string const &)
 {
 	skip_children = true;
@@ -835,6 +859,7 @@ void TeX2LyXApp::easyParse()
 	cmdmap["-f"] = parse_force;
 	cmdmap["-s"] = parse_syntaxfile;
 	cmdmap["-n"] = parse_noweb;
+	cmdmap["-j"] = parse_jobs;
 	cmdmap["-skipchildren"] = parse_skipchildren;
 	cmdmap["-sysdir"] = parse_sysdir;
 	cmdmap["-userdir"] = parse_userdir;
@@ -922,6 +947,342 @@ bool roundtripMode()
 }
 
 
+namespace {
+
+/// Is this a worker process that converts a single child document?
+bool is_worker = false;
+
+
+/// Resolve \p infilename like the parser does, adding .tex if needed
+FileName childFileName(string const & infilename)
+{
+	FileName ifname(infilename);
+	if (!ifname.exists() && ifname.extension().empty())
+		ifname.changeExtension("tex");
+	return ifname;
+}
+
+
+/*!
+ * Does the TeX file \p infilename define commands, environments, theorems
+ * or counters, or does it have a preamble of its own? Such definitions
+ * change how the rest of the master document is parsed.
+ */
+bool definesCommands(string const & infilename)
+{
+	// A rough textual check is enough: If it is wrong, the file is
+	// converted directly, which gives the same result, only slower.
+	// Starred and "x" variants are found by their prefix.
+	static char const * const definitions[] = {"\\newcommand",
+		"\\renewcommand", "\\providecommand", "\\DeclareRobustCommand",
+		"\\newenvironment", "\\renewenvironment", "\\let", "\\def",
+		"\\newtheorem", "\\DeclareMathOperator", "\\newcounter",
+		"\\NewDocumentCommand", "\\RenewDocumentCommand",
+		"\\ProvideDocumentCommand", "\\DeclareDocumentCommand",
+		"\\NewDocumentEnvironment", "\\RenewDocumentEnvironment",
+		"\\ProvideDocumentEnvironment", "\\DeclareDocumentEnvironment",
+		"\\documentclass", 0};
+	ifstream is(childFileName(infilename).toFilesystemEncoding().c_str());
+	string line;
+	while (getline(is, line))
+		for (char const * const * d = definitions; *d; ++d)
+			if (line.find(*d) != string::npos)
+				return true;
+	return false;
+}
+
+
+/// Convert a child document in this process
+string convertChild(string const & infilename, FileName const & outfilename,
+                    string const & encoding, string const & lyxname,
+                    string const & texname)
+{
+	if (tex2lyx(infilename, outfilename, encoding))
+		return lyxname;
+	copy_file(FileName(infilename), texname);
+	return texname;
+}
+
+
+/// The file names of the include insets of converted child documents,
+/// indexed by the placeholders used while they were converted
+map<string, string> child_names;
+
+
+/// Replace the placeholders of converted child documents in \p text
+string resolveChildNames(string text)
+{
+	for (auto const & child : child_names) {
+		if (text.find(child.first) == string::npos)
+			continue;
+		// The name is used as a quoted parameter of the include inset
+		text = subst(text, child.first, subst(child.second, "\"", "\\\""));
+	}
+	return text;
+}
+
+#ifndef _WIN32
+/// A child document that is converted by a worker process
+struct ChildJob {
+	///
+	pid_t pid;
+	/// read end of the pipe the worker writes its results to
+	int fd;
+	///
+	string infilename;
+	///
+	FileName outfilename;
+	///
+	string encoding;
+	/// stands for the file name in the include inset until the job is done
+	string placeholder;
+	/// file name of the include inset if the conversion succeeds
+	string lyxname;
+	/// absolute file name the TeX file is copied to if the conversion fails
+	string texname;
+	/// file name of the include inset if the conversion fails
+	string reltexname;
+};
+
+/// The running workers, oldest first
+vector<ChildJob> child_jobs;
+
+
+/// Read everything the worker of \p job wrote and wait until it exits
+bool collectChildJob(ChildJob const & job, string & result)
+{
+	char buf[4096];
+	while (true) {
+		ssize_t const n = ::read(job.fd, buf, sizeof(buf));
+		if (n > 0)
+			result.append(buf, n);
+		else if (n == 0 || errno != EINTR)
+			break;
+	}
+	::close(job.fd);
+	int status = 0;
+	while (::waitpid(job.pid, &status, 0) == -1)
+		if (errno != EINTR)
+			return false;
+	return WIFEXITED(status) && WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+
+/// Encode the arguments of a known command or environment
+string argumentsToString(vector<ArgumentType> const & arguments)
+{
+	string result;
+	for (ArgumentType const arg : arguments) {
+		if (!result.empty())
+			result += ',';
+		result += convert<string>(int(arg));
+	}
+	return result;
+}
+
+
+/// Decode the arguments of a known command or environment
+vector<ArgumentType> argumentsFromString(string const & s)
+{
+	vector<string> args;
+	split(s, args);
+	vector<ArgumentType> result;
+	for (string const & arg : args)
+		result.push_back(ArgumentType(convert<int>(arg)));
+	return result;
+}
+
+
+/// Add the entries of \p map that are not in \p old to the worker \p result
+void writeCommandDelta(string const & tag, CommandMap const & map,
+                       CommandMap const & old, string & result)
+{
+	for (auto const & entry : map) {
+		CommandMap::const_iterator const it = old.find(entry.first);
+		if (it == old.end() || it->second != entry.second)
+			result += tag + '\t' + entry.first + '\t'
+				+ argumentsToString(entry.second) + '\n';
+	}
+}
+
+
+/*!
+ * Merge the \p result of a worker into our state. The worker has a copy of
+ * our state, but everything that it learned from the child document and
+ * that is needed by the master is sent back, one tab separated entry per
+ * line.
+ */
+void mergeChildResult(string const & result)
+{
+	vector<string> lines;
+	split(result, lines, '\n');
+	for (string const & line : lines) {
+		vector<string> fields;
+		split(line, fields, '\t');
+		if (fields.empty())
+			continue;
+		// Trailing empty fields are dropped by split()
+		fields.resize(3);
+		if (fields[0] == "pdflatex")
+			pdflatex = true;
+		else if (fields[0] == "xetex")
+			xetex = true;
+		else if (fields[0] == "module") {
+			if (find(used_modules.begin(), used_modules.end(),
+			         fields[1]) == used_modules.end())
+				addModule(fields[1]);
+		} else if (fields[0] == "command")
+			known_commands[fields[1]] = argumentsFromString(fields[2]);
+		else if (fields[0] == "environment")
+			known_environments[fields[1]] = argumentsFromString(fields[2]);
+		else if (fields[0] == "mathenvironment")
+			known_math_environments[fields[1]] =
+				argumentsFromString(fields[2]);
+		else if (fields[0] == "author")
+			preamble.registerAuthor(fields[1], fields[2]);
+		else if (fields[0] == "preamble")
+			preamble.bodySetting(fields[1], fields[2]);
+	}
+}
+
+
+/// Wait for the oldest worker and merge its results
+void finishChildJob()
+{
+	ChildJob const job = child_jobs.front();
+	child_jobs.erase(child_jobs.begin());
+	string result;
+	if (collectChildJob(job, result)) {
+		mergeChildResult(result);
+		child_names[job.placeholder] = job.lyxname;
+		return;
+	}
+	warning_message("Converting " + job.infilename
+			+ " in a separate process failed, trying again.");
+	// Do not keep what the worker wrote before it failed
+	if (job.outfilename.exists())
+		job.outfilename.removeFile();
+	if (tex2lyx(job.infilename, job.outfilename, job.encoding)) {
+		child_names[job.placeholder] = job.lyxname;
+		return;
+	}
+	copy_file(FileName(job.infilename), job.texname);
+	child_names[job.placeholder] = job.reltexname;
+}
+#endif
+
+
+/// Wait until all child documents are converted
+void finishChildJobs()
+{
+#ifndef _WIN32
+	while (!child_jobs.empty())
+		finishChildJob();
+#endif
+}
+
+} // anonymous namespace
+
+
+string tex2lyxChild(string const & infilename, FileName const & outfilename,
+                    string const & encoding, string const & lyxname,
+                    string const & texname)
+{
+#ifndef _WIN32
+	// Conversions that are known to fail are done directly, so that the
+	// caller learns about it.
+	if (max_jobs <= 1 || is_worker || !childFileName(infilename).exists() ||
+	    (outfilename.exists() && !overwrite_files) ||
+	    definesCommands(infilename))
+		return convertChild(infilename, outfilename, encoding,
+		                    lyxname, texname);
+	for (ChildJob const & job : child_jobs)
+		if (job.outfilename == outfilename)
+			return job.placeholder;
+	if (int(child_jobs.size()) >= max_jobs)
+		finishChildJob();
+
+	int fds[2];
+	if (::pipe(fds) == -1)
+		return convertChild(infilename, outfilename, encoding,
+		                    lyxname, texname);
+	cout.flush();
+	cerr.flush();
+	pid_t const pid = ::fork();
+	if (pid == -1) {
+		::close(fds[0]);
+		::close(fds[1]);
+		return convertChild(infilename, outfilename, encoding,
+		                    lyxname, texname);
+	}
+	if (pid == 0) {
+		// The worker converts the child and any documents it includes
+		// itself, and reports back what the master needs to know.
+		::close(fds[0]);
+		for (ChildJob const & job : child_jobs)
+			::close(job.fd);
+		child_jobs.clear();
+		is_worker = true;
+		CommandMap const commands = known_commands;
+		CommandMap const environments = known_environments;
+		CommandMap const math_environments = known_math_environments;
+		vector<string> settings;
+		split(preamble.bodySettings(), settings, '\n');
+		bool const ok = tex2lyx(infilename, outfilename, encoding);
+		string result;
+		for (string const & module : used_modules)
+			result += "module\t" + module + '\n';
+		if (pdflatex)
+			result += "pdflatex\n";
+		if (xetex)
+			result += "xetex\n";
+		writeCommandDelta("command", known_commands, commands, result);
+		writeCommandDelta("environment", known_environments,
+		                  environments, result);
+		writeCommandDelta("mathenvironment", known_math_environments,
+		                  math_environments, result);
+		// Registering an author again does no harm
+		for (Author const & author : preamble.authors())
+			if (author.used())
+				result += "author\t" + to_utf8(author.name()) + '\t'
+					+ to_utf8(author.initials()) + '\n';
+		// Only what the child changed, so that the master does not
+		// lose the settings that it made in the meantime
+		vector<string> new_settings;
+		split(preamble.bodySettings(), new_settings, '\n');
+		for (string const & setting : new_settings)
+			if (find(settings.begin(), settings.end(), setting)
+			    == settings.end())
+				result += "preamble\t" + setting + '\n';
+		for (size_t pos = 0; pos < result.size(); ) {
+			ssize_t const n = ::write(fds[1], result.data() + pos,
+			                          result.size() - pos);
+			if (n > 0)
+				pos += n;
+			else if (n == -1 && errno != EINTR)
+				break;
+		}
+		::close(fds[1]);
+		cout.flush();
+		cerr.flush();
+		::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+	}
+	::close(fds[1]);
+	// The file names are needed after the parser has left the parent
+	string const abstexname =
+		makeAbsPath(texname, getParentFilePath(false)).absFileName();
+	static int placeholders = 0;
+	string const placeholder = "\x01" "child"
+		+ convert<string>(++placeholders) + "\x01";
+	child_jobs.push_back({pid, fds[0], infilename, outfilename, encoding,
+	                      placeholder, lyxname, abstexname, texname});
+	return placeholder;
+#else
+	return convertChild(infilename, outfilename, encoding, lyxname, texname);
+#endif
+}
+
+
 namespace {
 
 /*!
@@ -941,6 +1302,11 @@ bool tex2lyx(idocstream & is, ostream & os, string const & encoding,
 	//p.dump();
 
 	preamble.parse(p, documentclass, textclass);
+#ifndef TEST_PARSER
+	// The body is parsed only once, so the tokens that have been
+	// handled can be forgotten.
+	p.forgetHistory();
+#endif
 	list<string> removed_modules;
 	LayoutFile const & baseClass = LayoutFileList::get()[textclass.name()];
 	if (!used_modules.adaptToBaseClass(&baseClass, removed_modules)) {
@@ -980,6 +1346,9 @@ bool tex2lyx(idocstream & is, ostream & os, string const & encoding,
 	context.check_end_layout(ss);
 	ss << "\n\\end_body\n\\end_document\n";
 	active_environments.pop_back();
+	// The modules used by the child documents are needed for the header
+	if (!is_worker)
+		finishChildJobs();
 
 	// We know the used modules only after parsing the full text
 	if (!used_modules.empty()) {
@@ -994,7 +1363,7 @@ bool tex2lyx(idocstream & is, ostream & os, string const & encoding,
 	}
 
 	ss.seekg(0);
-	os << ss.str();
+	os << resolveChildNames(ss.str());
 #ifdef TEST_PARSER
 	p.reset();
 	ofdocstream parsertest("parsertest.tex");
@@ -1101,8 +1470,16 @@ bool tex2lyx(string const & infilename, FileName const & outfilename,
 	debug_message("Input file: " + ifname.absFileName());
 	debug_message("Output file: " + outfilename.absFileName());
 
-	return tex2lyx(ifname, os, encoding,
-	               outfilename.onlyPath().absFileName() + '/');
+	auto const start = chrono::steady_clock::now();
+	bool const retval = tex2lyx(ifname, os, encoding,
+	                            outfilename.onlyPath().absFileName() + '/');
+	if (max_jobs > 0) {
+		chrono::duration<double> const elapsed =
+			chrono::steady_clock::now() - start;
+		warning_message("Converted " + ifname.absFileName() + " in "
+				+ convert<string>(elapsed.count()) + " s");
+	}
+	return retval;
 }
 
 
@@ -55,6 +55,12 @@ void check_comment_bib(std::ostream & os, Context & context);
 
 void fix_child_filename(std::string & name);
 
+/*!
+ * Copy \p src to \p dstname if files are copied (option -copyfiles).
+ * A relative \p dstname is relative to the LyX file of the parent.
+ */
+void copy_file(support::FileName const & src, std::string const & dstname);
+
 std::string const normalize_filename(std::string const & name);
 
 std::string find_file(std::string const & name, std::string const & path,
@@ -216,6 +222,25 @@ bool tex2lyx(std::string const & infilename,
 	     support::FileName const & outfilename,
 	     std::string const & encoding);
 
+/*!
+ *  Like tex2lyx(), but for child documents: If several jobs were requested
+ *  with -j, the conversion runs in a separate process, and the call returns
+ *  immediately. Children that define commands or environments are converted
+ *  directly, since the following text of the including document may use
+ *  them. The modules, commands, environments and authors of the other
+ *  children are merged back before the header of the including document
+ *  is written.
+ *  If the conversion fails, the TeX file is copied to \p texname instead.
+ *  \return the file name to use in the include inset: \p lyxname or
+ *  \p texname, or a placeholder that is replaced by one of them before
+ *  the including document is written.
+ */
+std::string tex2lyxChild(std::string const & infilename,
+                         support::FileName const & outfilename,
+                         std::string const & encoding,
+                         std::string const & lyxname,
+                         std::string const & texname);
+
 /// A general warning message that can be silenced with -q
 void warning_message(std::string const & message);
 /// A general error message
@@ -2864,6 +2864,9 @@ void get_cite_arguments(Parser & p, bool natbibOrder,
 }
 
 
+} // anonymous namespace
+
+
 void copy_file(FileName const & src, string const & dstname)
 {
 	if (!copyFiles())
@@ -2901,6 +2904,8 @@ void copy_file(FileName const & src, string const & dstname)
 }
 
 
+namespace {
+
 /// Parse a literate Chunk section. The initial "<<" is already parsed.
 bool parse_chunk(Parser & p, ostream & os, Context & context)
 {
@@ -5647,12 +5652,13 @@ void parse_text(Parser & p, ostream & os, unsigned flags, bool outer,
 					FileName abssrc(abstexname);
 					copy_file(abssrc, outname);
 				} else if (t.cs() != "verbatiminput" &&
-				           !skipChildren() &&
-				    tex2lyx(abstexname, FileName(abslyxname),
-					    p.getEncoding())) {
-					outname = lyxname;
-					// no need to call copy_file
-					// tex2lyx creates the file
+				           !skipChildren()) {
+					// tex2lyx creates the file, or
+					// copies it if that fails
+					outname = tex2lyxChild(abstexname,
+						FileName(abslyxname),
+						p.getEncoding(), lyxname,
+						filename);
 				} else {
 					outname = filename;
 					FileName abssrc(abstexname);
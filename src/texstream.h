@@ -114,6 +114,40 @@ public:
 	bool afterParbreak() const { return parbreak_; }
 	///
 	bool blankLine() const { return blankline_; }
+	/// The flags that influence how the next output is written
+	struct State {
+		bool canbreakline;
+		bool protectspace;
+		bool terminate_command;
+		bool parbreak;
+		bool blankline;
+		char_type lastchar;
+		bool operator==(State const & s) const
+		{
+			return canbreakline == s.canbreakline
+				&& protectspace == s.protectspace
+				&& terminate_command == s.terminate_command
+				&& parbreak == s.parbreak
+				&& blankline == s.blankline
+				&& lastchar == s.lastchar;
+		}
+	};
+	///
+	State state() const
+	{
+		return { canbreakline_, protectspace_, terminate_command_,
+		         parbreak_, blankline_, lastchar_ };
+	}
+	/// Continue output as if \p s was the state of this stream
+	void state(State const & s)
+	{
+		canbreakline_ = s.canbreakline;
+		protectspace_ = s.protectspace;
+		terminate_command_ = s.terminate_command;
+		parbreak_ = s.parbreak;
+		blankline_ = s.blankline;
+		lastchar_ = s.lastchar;
+	}
 private:
 	///
 	bool canbreakline_;